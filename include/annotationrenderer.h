@@ -0,0 +1,57 @@
+#ifndef __ANNOTATIONRENDERER_H__
+#define __ANNOTATIONRENDERER_H__
+
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <opencv2/core.hpp>
+#include "word.h"
+#include "runedictionary.h"
+namespace fs = std::filesystem;
+
+const size_t ANNOTATION_CACHE_MAX_ENTRIES = 8192; // Rendered patches kept (the cache is emptied when full)
+
+// Look of the translations written over the detected words
+struct AnnotationStyle {
+	int font_face = 0; // cv::FONT_HERSHEY_SIMPLEX
+	int tickness = 1;
+	int padding = 0;
+	cv::Scalar color = cv::Scalar(255, 255, 255);
+	cv::Scalar background_color = cv::Scalar(0, 0, 0);
+};
+
+// A word and the zone its translation is fitted in
+struct Annotation {
+	Word word;
+	cv::Rect zone;
+};
+
+// Writes translations fitted in their zone (same layout as draw_text_in_rect, centered). Every (text, zone size, style,
+// image type) is rasterised once: the next occurrences, in this page or in the other languages, are a patch copy
+class AnnotationRenderer {
+public:
+	AnnotationRenderer(const AnnotationStyle& style = AnnotationStyle()) : m_style(style) {}
+	bool draw(cv::Mat& image, const std::string& text, const cv::Rect& zone);
+	bool render(cv::Mat& image, const std::vector<Annotation>& annotations, RuneDictionary& dictionary);
+	// one annotated copy of page per dictionary, rendered and written concurrently as <output_stem>.<language>.png
+	bool render_languages(const cv::Mat& page, const std::vector<Annotation>& annotations, const std::vector<fs::path>& dictionary_files,
+		const fs::path& output_folder, const std::string& output_stem, std::vector<fs::path>& output_files);
+
+	size_t get_cache_hits() const { return m_cache_hits; }
+	size_t get_cache_misses() const { return m_cache_misses; }
+	void clear_cache();
+private:
+	AnnotationStyle m_style;
+	std::mutex m_cache_mutex;
+	std::unordered_map<std::string, cv::Mat> m_cache; // rendered patch per (text, size, image type)
+	std::atomic<size_t> m_cache_hits = 0;
+	std::atomic<size_t> m_cache_misses = 0;
+
+	bool rasterise(const std::string& text, const cv::Size& size, int type, cv::Mat& patch) const;
+	cv::Mat get_patch(const std::string& text, const cv::Size& size, int type);
+};
+
+#endif // __ANNOTATIONRENDERER_H__
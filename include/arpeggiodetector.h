@@ -12,33 +12,22 @@
 #include <map>
 #include <algorithm>
 #include <filesystem>
+#include <functional>
 #include <numbers> // for Pi
 #include "note.h"
 #include "runedictionary.h"
 #include "arpeggio.h"
+#include "fft.h"
+#include "stft.h"
+#include "yindetector.h"
+#include "notequantizer.h"
 
 const auto DEFAULT_NOTE_LENGTH = 75.0f; // in millisec
 const auto SILENCE_TONE_THRESHOLD = 10.0f;
+const auto DEFAULT_ANALYSIS_OVERLAP = 0.0; // fraction of a note length shared by two analysis frames
+const size_t AUDIO_STREAM_BLOCK_FRAMES = 8192; // frames read from the file at once by stream_words
 
 
-// --- Structures WavHeader ---
-// (Simplified for standard PCM files)
-struct WavHeader {
-    char riff[4]; // "RIFF"
-    uint32_t overall_size;
-    char wave[4]; // "WAVE"
-    char fmt_chunk_marker[4]; // "fmt "
-    uint32_t length_of_fmt;
-    uint16_t format_type;
-    uint16_t channels;
-    uint32_t sample_rate;
-    uint32_t byterate;
-    uint16_t block_align;
-    uint16_t bits_per_sample;
-    char data_chunk_header[4]; // "data"
-    uint32_t data_size;
-};
-
 namespace FFT {
     using Complex = std::complex<double>;
     void fft(std::vector<Complex>& a) ;
@@ -54,7 +43,7 @@ class ArpeggioDetector {
 public:
     ArpeggioDetector() =  default;
     bool load_dictionary(const RuneDictionary& dictionary);
-    std::vector<Note> detect_note_sequence(const std::filesystem::path& filePath, double note_length = DEFAULT_NOTE_LENGTH, bool yin_algo = false);
+    std::vector<Note> detect_note_sequence(const std::filesystem::path& filePath, double note_length = DEFAULT_NOTE_LENGTH, bool yin_algo = false, double overlap = DEFAULT_ANALYSIS_OVERLAP);
     //std::vector<Note> detect_note_sequence_aubio(const fs::path& wavFilePath, float threshold = 0.7f, int minNote = (int)Note::C0, int maxNote = (int)Note::B8);
     std::vector<Note> get_clean_sequence(const std::vector<Note>& sequence);
     Word find(const Arpeggio& arpeggio);
@@ -62,12 +51,65 @@ public:
     static std::vector<int> get_indexed_note_sequence(std::vector<Note>& note_sequence, ScaleType scale = ScaleType::Mixolydian);
     bool detect_words(const std::vector<Note>& notes, std::vector<Word>& words);
     int audio_detection(const fs::path& dictionary_file, const fs::path& audio_file, double note_length, bool yin_algo, std::string& result);
+    // Streaming decode (reader blocks -> analysis frames -> segmented notes -> words): every segmented note and every
+    // word, as soon as it is decided, goes to the callbacks. Memory does not depend on the recording length. decimate: analysis
+    // at the lowest fraction of the file rate that keeps the note range (see ArpeggioStreamConfig)
+    bool stream_words(const fs::path& audio_file, double note_length, bool yin_algo, const std::function<void(const Word&)>& on_word,
+        const std::function<void(Note)>& on_note = nullptr, double overlap = DEFAULT_ANALYSIS_OVERLAP, bool decimate = false);
+    int get_arpeggio_min_length() const { return m_arpeggio_min_length; }
+    int get_arpeggio_max_length() const { return m_arpeggio_max_length; }
 private:
-    Note findClosestNote(double frequency);
-    void detect_note_sequence(const std::vector<float>& samples, uint32_t sampleRate, std::vector<Note>& detected_sequence, double note_length = DEFAULT_NOTE_LENGTH);
+    void detect_note_sequence(const std::vector<float>& samples, uint32_t sampleRate, std::vector<Note>& detected_sequence, double note_length, bool yin_algo, double overlap);
+    // analysis frames of either path: Hann windowed spectra of note_length (FFT) or raw YIN windows
+    bool init_frame_analysis(uint32_t sample_rate, double note_length, bool yin_algo, double overlap, Stft& stft, YinDetector& yin);
+    // pitch in Hz of a frame: interpolated spectrum peak (FFT, below SILENCE_TONE_THRESHOLD for silence) or YIN (-1 if none)
+    double get_frame_pitch(const StftFrame& frame, const Stft& stft, YinDetector* yin, uint32_t sample_rate);
+    static Note get_pitch_note(double pitch, const NoteQuantizer& quantizer);
+    friend class ArpeggioStream; // same frame analysis on pushed blocks
     std::map<std::string, Arpeggio> m_arpeggio_dictionary;
     int m_arpeggio_min_length = INT_MAX;
 	int m_arpeggio_max_length = 0;
 };
 
+// Per frame notes -> note sequence, with the get_clean_sequence rule (no silence, no unknown note, no repetition)
+class NoteSegmenter {
+public:
+    bool push(Note note, Note& segmented_note);
+    void reset() { m_last_note = Note::SILENCE; }
+private:
+    Note m_last_note = Note::SILENCE;
+};
+
+// A word and its notes, numbered from the start of the stream
+struct WordMatch {
+    Word word;
+    size_t first_note = 0;
+    size_t last_note = 0;
+};
+
+// detect_words on a note stream: the match starting at a note is decided once max_length notes follow it (the same
+// greedy choice as on the whole sequence), then the notes before the next start are dropped
+class WordMatcher {
+public:
+    explicit WordMatcher(ArpeggioDetector& detector) : m_detector(detector) {}
+    void push(Note note, std::vector<Word>& words); // appends the words decided by this note
+    void push(Note note, std::vector<WordMatch>& matches);
+    void finish(std::vector<Word>& words); // end of the stream: matches the remaining notes
+    void finish(std::vector<WordMatch>& matches);
+    void reset();
+    // earliest pending note starting a word with the notes at hand and its longest word, false if none
+    bool find_candidate(WordMatch& candidate) const;
+    // decides the first pending note with the notes at hand, without waiting for max_length notes
+    void decide_front(std::vector<WordMatch>& matches) { match_front(matches); }
+    size_t get_nb_pending_notes() const { return m_notes.size(); }
+    size_t get_first_pending_note() const { return m_first_note; } // number of the first pending note
+private:
+    ArpeggioDetector& m_detector;
+    std::deque<Note> m_notes; // the first one is the next match start
+    size_t m_first_note = 0;
+
+    size_t find_word(size_t begin, Word& word) const; // end of the longest word from m_notes[begin], begin if none
+    void match_front(std::vector<WordMatch>& matches);
+};
+
 #endif // __NOTEDETECTOR_H__
\ No newline at end of file
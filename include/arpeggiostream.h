@@ -0,0 +1,98 @@
+#ifndef __ARPEGGIOSTREAM_H__
+#define __ARPEGGIOSTREAM_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <vector>
+#include "arpeggiodetector.h"
+#include "resampler.h"
+
+const auto ARPEGGIO_STREAM_DEFAULT_LATENCY = 500.0; // in millisec, wait of a word candidate for a longer match
+const size_t ARPEGGIO_STREAM_CONVERT_FRAMES = 1024; // 16 bit samples widened at once
+const auto ARPEGGIO_STREAM_MAX_FREQUENCY = 2637.0; // in Hz, E7: two semitones above the highest arpeggio note (D7)
+
+struct ArpeggioStreamConfig {
+    uint32_t sample_rate = 44100; // of the pushed samples
+    uint32_t analysis_rate = 0; // in Hz, frames and pitches at this rate (polyphase resampler), 0 = sample_rate
+    // analyse at the lowest fraction of the analysis rate that keeps the arpeggio notes (up to ARPEGGIO_STREAM_MAX_FREQUENCY):
+    // in the resampler pass band for the FFT, with YIN_MIN_PERIOD samples per period for YIN
+    bool decimate = false;
+    double note_length = DEFAULT_NOTE_LENGTH; // in millisec, FFT analysis frame
+    bool yin_algo = false;
+    double overlap = DEFAULT_ANALYSIS_OVERLAP;
+    // in millisec, how long a word candidate waits for a longer match once its last note is heard.
+    // 0: until max_length notes follow it (the same words as detect_words, the latency depends on the dictionary)
+    double latency = ARPEGGIO_STREAM_DEFAULT_LATENCY;
+    // quantise around the running tuning estimate of the stream (detuned captures), once TUNING_MIN_OBSERVATIONS pitches are in
+    bool estimate_tuning = true;
+};
+
+// Times in seconds since the start of the stream. Note times are in the signal, less the resampler delay
+struct TimedNote {
+    Note note = Note::UNKNOWN;
+    double start = 0.0; // first frame with this note
+    double detected = 0.0; // end of that frame
+};
+
+struct TimedWord {
+    Word word;
+    double start = 0.0; // start of the first note
+    double end = 0.0; // detection of the last note
+    double decided = 0.0; // stream time when the word was emitted
+};
+
+// Live word recognition: sample blocks of any size (capture callback, file replayed in real time) go through the STFT
+// sample ring, the note segmenter and the word matcher, and every recognised word is emitted with its timestamps as soon
+// as it is decided. A candidate word is decided at most latency after its last note, even if more notes keep coming
+class ArpeggioStream {
+public:
+    explicit ArpeggioStream(ArpeggioDetector& detector) : m_detector(detector), m_matcher(detector) {}
+    bool init(const ArpeggioStreamConfig& config, const std::function<void(const TimedWord&)>& on_word,
+        const std::function<void(const TimedNote&)>& on_note = nullptr);
+    void reset(); // new stream, keeps the analysis tables
+    bool is_valid() const { return m_stft.is_valid(); }
+
+    // mono samples in [-1, 1] (float) or 16 bit PCM, returns the number of words emitted by this block
+    size_t push(const float* samples, size_t count);
+    size_t push(const int16_t* samples, size_t count);
+    // end of the stream: decides the pending notes, returns the number of words emitted
+    size_t flush();
+
+    double get_time() const { return (double)m_nb_samples / m_config.sample_rate; } // in sec, audio pushed
+    uint32_t get_analysis_rate() const { return m_analysis_rate; }
+    double get_tuning() const { return m_quantizer.get_tuning(); } // in cents, current estimate
+    size_t get_nb_pending_notes() const { return m_matcher.get_nb_pending_notes(); }
+    const ArpeggioStreamConfig& get_config() const { return m_config; }
+private:
+    ArpeggioDetector& m_detector;
+    ArpeggioStreamConfig m_config;
+    std::function<void(const TimedWord&)> m_on_word;
+    std::function<void(const TimedNote&)> m_on_note;
+    uint32_t m_analysis_rate = 0;
+    PolyphaseResampler m_resampler; // valid when the analysis rate differs from the sample rate
+    std::vector<float> m_resampled;
+    Stft m_stft;
+    YinDetector m_yin;
+    NoteQuantizer m_quantizer;
+    TuningEstimator m_tuning_estimator;
+    NoteSegmenter m_segmenter;
+    WordMatcher m_matcher;
+    std::deque<TimedNote> m_notes; // times of the pending notes of the matcher
+    size_t m_first_timed_note = 0; // number of m_notes.front()
+    std::vector<WordMatch> m_matches; // decided by the current frame
+    WordMatch m_candidate; // earliest word with the notes at hand (latency bound only)
+    bool m_has_candidate = false;
+    size_t m_nb_samples = 0;
+    size_t m_nb_words = 0;
+    std::vector<float> m_converted; // widened 16 bit samples
+
+    void process_frame(const StftFrame& frame);
+    void apply_latency(double now);
+    void emit_matches(double now);
+    const TimedNote& get_note(size_t number) const { return m_notes[number - m_first_timed_note]; }
+    double get_delay() const { return m_resampler.is_valid() ? m_resampler.get_delay() : 0.0; } // in sec
+};
+
+#endif // __ARPEGGIOSTREAM_H__
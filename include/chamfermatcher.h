@@ -0,0 +1,42 @@
+#ifndef __CHAMFERMATCHER_H__
+#define __CHAMFERMATCHER_H__
+
+#include <vector>
+#include <opencv2/core.hpp>
+#include "word.h"
+
+const double CHAMFER_TRUNCATION = 0.10; // Distances are truncated to this part of the template height (min 2 pixels)
+const double CHAMFER_BACKGROUND_DISTANCE = 0.75; // Background points lie at least this many stroke ticknesses away from the template strokes
+const double CHAMFER_BACKGROUND_BAND = 2.0; // and at most this many ticknesses away (a band along the strokes, not the whole template area)
+const double CHAMFER_MAX_BACKGROUND_INK = 0.10; // The score falls to 0 when this part of the background points lie on ink
+const double CHAMFER_DETECTION_THRESHOLD = 0.8; // Chamfer score above which a word is detected
+const int CHAMFER_SCALE_FACTOR_STEPS = 10; // Scale steps for the chamfer backend (tolerant to the stroke tickness, needs fewer steps)
+
+// Sparse template of a word: points of the stroke center lines (scored against the page distance transform)
+// and points of a background band around the strokes (must not be on ink, rejects filled areas)
+struct ChamferTemplate {
+	cv::Size size;
+	double truncation = 0.0;
+	std::vector<cv::Point> skeleton_points;
+	std::vector<cv::Point> background_points;
+};
+
+// Chamfer matching: the distance transform of the page ink is computed once, then every template is scored
+// with a cost proportional to its number of points (not to its area)
+class ChamferMatcher {
+public:
+	ChamferMatcher() = default;
+	bool set_image(const cv::Mat& image);
+	bool is_ready() const { return !m_distance.empty(); }
+	// result has the cv::matchTemplate layout: one score in [0, 1] per top left position of the template in search_roi
+	bool match(const ChamferTemplate& pattern, const cv::Rect& search_roi, cv::Mat& result) const;
+	// forget the ink of a zone (detected words are blanked so they are not found again)
+	void erase(const cv::Rect& zone);
+
+	static bool make_template(const Word& word, double scale_factor, ChamferTemplate& pattern);
+private:
+	cv::Mat m_ink; // CV_32F, 1 on ink
+	cv::Mat m_distance; // CV_32F, distance to the nearest ink pixel
+};
+
+#endif // __CHAMFERMATCHER_H__
@@ -0,0 +1,38 @@
+#ifndef __FFT_H__
+#define __FFT_H__
+
+#include <complex>
+#include <cstdint>
+#include <vector>
+
+// Radix-2 FFT of a fixed size: bit reversal and twiddle tables are computed once, the transforms run in place
+// (iterative butterflies, no allocation). A plan is read only once initialised: one plan can serve several threads
+template<typename T>
+class FftPlan {
+public:
+    using Complex = std::complex<T>;
+
+    FftPlan() = default;
+    explicit FftPlan(size_t size) { init(size); }
+    bool init(size_t size); // size must be a power of two
+    size_t size() const { return m_size; }
+    bool is_valid() const { return m_size > 0; }
+
+    // complex transforms of size() values, forward is unscaled, inverse is scaled by 1 / size()
+    void forward(Complex* data) const;
+    void inverse(Complex* data) const;
+    // real signal of size() values <-> its size() / 2 + 1 first bins, through a size() / 2 complex transform
+    void forward_real(const T* input, Complex* spectrum) const;
+    void inverse_real(const Complex* spectrum, T* output) const;
+
+    static size_t next_power_of_two(size_t n);
+private:
+    size_t m_size = 0;
+    int m_log2_size = 0;
+    std::vector<uint32_t> m_bit_reverse; // over log2(size) bits, shifted right for the half size transform
+    std::vector<Complex> m_twiddles; // exp(-2i pi k / size), k < size / 2
+
+    void transform(Complex* data, size_t n, bool inverse) const;
+};
+
+#endif // __FFT_H__
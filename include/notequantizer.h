@@ -0,0 +1,52 @@
+#ifndef __NOTEQUANTIZER_H__
+#define __NOTEQUANTIZER_H__
+
+#include <array>
+#include <cstddef>
+#include "note.h"
+
+const auto NOTE_REFERENCE_FREQUENCY = 440.0; // in Hz, A4 (MIDI 69) of equal temperament
+const auto NOTE_QUANTIZER_TOLERANCE = 50.0; // in cents, largest deviation from the retuned note (50: every pitch of the range)
+const size_t TUNING_HISTOGRAM_BINS = 100; // 1 cent bins over a semitone, deviations in [-50, 50)
+const auto TUNING_PEAK_WIDTH = 15; // in bins, each side of the histogram peak used by the estimate
+const size_t TUNING_MIN_OBSERVATIONS = 10; // pitches before an estimate is returned
+
+struct QuantizedNote {
+    Note note = Note::UNKNOWN; // UNKNOWN out of C0..B8 or beyond the tolerance
+    double frequency = 0.0; // in Hz, the quantised pitch
+    double cents = 0.0; // deviation from the retuned note, in [-50, 50]
+    double confidence = 0.0; // 1 on the note, 0 at the tolerance
+};
+
+// Pitch -> note in O(1): the MIDI number 69 + 12 log2(f / 440), shifted by the tuning of the recording, is rounded and the
+// remainder kept as the deviation in cents
+class NoteQuantizer {
+public:
+    explicit NoteQuantizer(double tolerance = NOTE_QUANTIZER_TOLERANCE) : m_tolerance(tolerance) {}
+    QuantizedNote quantize(double frequency) const;
+    // the recording is sharp (positive) or flat (negative) by this many cents
+    void set_tuning(double cents) { m_tuning = cents; }
+    double get_tuning() const { return m_tuning; }
+    double get_tolerance() const { return m_tolerance; }
+private:
+    double m_tolerance = NOTE_QUANTIZER_TOLERANCE;
+    double m_tuning = 0.0;
+};
+
+// Tuning of a recording: histogram of the pitch deviations from equal temperament, circular over a semitone (+50 and -50
+// cents are the same offset). The estimate is the circular mean of the deviations around the histogram peak, so a few
+// glides or wrong pitches between the notes do not move it
+class TuningEstimator {
+public:
+    void add(double frequency, double weight = 1.0);
+    bool estimate(double& cents) const; // false before TUNING_MIN_OBSERVATIONS pitches
+    void reset();
+    size_t get_nb_observations() const { return m_nb_observations; }
+
+    static double get_deviation(double frequency); // in cents from the nearest equal tempered note, in [-50, 50)
+private:
+    std::array<double, TUNING_HISTOGRAM_BINS> m_histogram = {};
+    size_t m_nb_observations = 0;
+};
+
+#endif // __NOTEQUANTIZER_H__
@@ -0,0 +1,88 @@
+#ifndef __PAGEGENERATOR_H__
+#define __PAGEGENERATOR_H__
+
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+#include "word.h"
+#include "runedictionary.h"
+#include "runedetector.h"
+namespace fs = std::filesystem;
+
+const double PAGE_GENERATOR_MATCH_IOU = 0.5; // A detected zone overlapping a ground truth word more than this is a true positive
+
+// Layout and degradations of the generated pages (scale factors are relative to RUNE_DEFAULT_SIZE,
+// ticknesses to the rune height, spacings to the rune size)
+struct PageGeneratorOptions {
+	cv::Size page_size = cv::Size(1280, 720);
+	double min_scale_factor = 0.3;
+	double max_scale_factor = 0.6;
+	double min_tickness = 0.06;
+	double max_tickness = 0.09;
+	int min_sentence_words = 3;
+	int max_sentence_words = 8;
+	double word_spacing = 0.6; // space between two words, relative to the rune width
+	double line_spacing = 0.5; // space between two lines, relative to the rune height
+	double margin = 0.05; // relative to the page width / height
+	double noise_sigma = 0.0; // gaussian noise (gray levels), 0: none
+	int blur_kernel_size = 0; // gaussian blur kernel size (odd), 0: none
+	int jpeg_quality = 0; // JPEG re-encoding quality, 0: none
+	double max_rotation = 0.0; // the page is rotated by a random angle in [-max_rotation, max_rotation] degrees
+	cv::Scalar ink_color = cv::Scalar(255, 255, 255);
+	cv::Scalar background_color = cv::Scalar(0, 0, 0);
+	std::vector<fs::path> background_images; // drawn behind the words (resized to the page), instead of background_color
+};
+
+// Ground truth of one word of a generated page
+struct GeneratedWord {
+	std::string hash;
+	std::string translation;
+	int line = 0;
+	cv::Rect rect; // bounding box (the Word::generate_image frame, like the RuneDetector zones)
+	std::vector<cv::Point2f> corners; // corners of the word frame, after the page rotation
+};
+
+struct GeneratedPage {
+	cv::Mat image; // BGR
+	double scale_factor = 1.0;
+	double tickness = 0.0; // pixels
+	double rotation = 0.0; // degrees
+	std::string background; // background image file, empty for a plain background
+	std::vector<GeneratedWord> words;
+};
+
+// Detection scores of a page against its ground truth
+struct GeneratedPageScore {
+	int nb_words = 0;
+	int nb_detections = 0;
+	int nb_matched = 0; // detections on a ground truth word with the right hash
+	double precision() const { return nb_detections > 0 ? (double)nb_matched / nb_detections : 1.0; }
+	double recall() const { return nb_words > 0 ? (double)nb_matched / nb_words : 1.0; }
+};
+
+// Synthetic rune pages: random sentences of dictionary words drawn with Word::generate_image, then degraded
+// (rotation, blur, noise, JPEG). The same seed gives the same pages
+class SyntheticPageGenerator {
+public:
+	SyntheticPageGenerator(const PageGeneratorOptions& options = PageGeneratorOptions(), unsigned int seed = 0);
+	bool load_dictionary(const fs::path& dictionary_file);
+	bool generate_page(GeneratedPage& page);
+	// <output_folder>/page_0000.png + page_0000.json ...
+	bool generate_corpus(const fs::path& output_folder, int nb_pages);
+
+	static bool save_ground_truth(const GeneratedPage& page, const std::string& image_name, const fs::path& json_file);
+	// a ground truth word is found by at most one detection (IoU of the rects, rotation ignored)
+	static GeneratedPageScore score_detections(const GeneratedPage& page, const std::vector<RuneZone>& zones, double min_iou = PAGE_GENERATOR_MATCH_IOU);
+private:
+	PageGeneratorOptions m_options;
+	std::mt19937 m_rng;
+	std::vector<std::pair<std::string, std::string>> m_words; // hash, translation
+	std::vector<cv::Mat> m_backgrounds;
+
+	double uniform(double min_value, double max_value);
+	int uniform_int(int min_value, int max_value);
+};
+
+#endif // __PAGEGENERATOR_H__
@@ -0,0 +1,49 @@
+#ifndef __RESAMPLER_H__
+#define __RESAMPLER_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+const auto RESAMPLER_PASSBAND = 0.9; // fraction of the lower Nyquist frequency kept flat
+const auto RESAMPLER_ATTENUATION = 80.0; // in dB, stop band of the anti aliasing filter
+
+// Rational sample rate conversion (up by L, filter, down by M, with L / M the reduced output / input ratio) with a Kaiser
+// windowed sinc split in L polyphase branches: every output sample is one dot product over the input history
+// (vectorised with OpenCV universal intrinsics). Blocks of any length give the same output as the whole signal at once
+class PolyphaseResampler {
+public:
+    PolyphaseResampler() = default;
+    PolyphaseResampler(uint32_t input_rate, uint32_t output_rate) { init(input_rate, output_rate); }
+    bool init(uint32_t input_rate, uint32_t output_rate, double passband = RESAMPLER_PASSBAND, double attenuation = RESAMPLER_ATTENUATION);
+    void reset(); // forget the input history, keep the filter
+    bool is_valid() const { return m_up > 0; }
+
+    // output samples of these input samples in output (resized), returns their number
+    size_t process(const float* input, size_t count, std::vector<float>& output);
+
+    uint32_t get_input_rate() const { return m_input_rate; }
+    uint32_t get_output_rate() const { return m_output_rate; }
+    uint32_t get_up() const { return m_up; }
+    uint32_t get_down() const { return m_down; }
+    size_t get_nb_taps() const { return m_taps_per_phase; } // per output sample
+    double get_delay() const { return m_delay; } // in sec, group delay of the filter
+    bool is_simd() const { return m_use_simd; }
+
+    // lowest input_rate / k (k integer) not below min_rate, input_rate itself if none
+    static uint32_t get_decimated_rate(uint32_t input_rate, double min_rate);
+private:
+    uint32_t m_input_rate = 0;
+    uint32_t m_output_rate = 0;
+    uint32_t m_up = 0;
+    uint32_t m_down = 0;
+    size_t m_taps_per_phase = 0;
+    double m_delay = 0.0;
+    bool m_use_simd = false;
+    std::vector<float> m_coefficients; // up branches of taps_per_phase values, reversed to run over the history in order
+    std::vector<float> m_buffer; // taps_per_phase - 1 last input samples, then the block
+    size_t m_next_input = 0; // newest input sample of the next output, in the block
+    uint32_t m_next_phase = 0;
+};
+
+#endif // __RESAMPLER_H__
@@ -2,7 +2,8 @@
 #define __RUNE_H__
 
 #include <string>
-#include <opencv2/core/types.hpp>
+#include <vector>
+#include <opencv2/core.hpp>
 
 /*
 * BIT representation of the TUNIC RUNE DECODER
@@ -77,6 +78,7 @@ const auto RUNE_SEGMENT_DRAW_DEFAULT_TICKNESS = 0.075; // thickness percent of t
 
 const auto RUNE_SEGMENT_DETECTION_FILTER_MASK_TICKNESS = 0.10; // 0.04;
 const auto RUNE_SEGMENT_DETECTION_DETECTION_MASK_TICKNESS = 0.04; // 0.04;
+const auto RUNE_SEGMENT_DETECTION_THRESHOLD = 0.50; // Part of a segment mask on ink to set the segment bit
 
 //const auto RUNE_DEFAULT_SIZE = cv::Size2i(50, 100); // Default size of the rune image
 //const auto RUNE_DEFAULT_SIZE = cv::Size2i(70, 130); // Default size of the rune image
@@ -182,6 +184,7 @@ public:
     Rune(unsigned long bin);
     //Rune(std::string name);
     Rune(const Rune& rune);
+    Rune& operator=(const Rune& rune) = default;
     Rune vowel_part() const;
 	Rune consonant_part() const;
     bool is_reverse() const;
@@ -191,7 +194,9 @@ public:
 	std::string to_hexa() const;
 	bool from_hexa(const std::string& hexString);
     bool generate_image(int x, int y, cv::Size2i size, double tickness, cv::Mat& output_image, bool draw_separator = true) const;
-    bool decode_image(const cv::Mat& image); 
+    bool decode_image(const cv::Mat& image, bool debug_mode = false); // headless unless debug_mode is set
+    // batched decode of runes of the same size in a binary image (white on black), origins are the top left of each rune layout
+    static bool decode_cells(const cv::Mat& binary_image, const std::vector<cv::Point2d>& origins, cv::Size2i rune_size, double tickness, std::vector<Rune>& runes);
     //operator overloads
     Rune operator+(const Rune& other) const { return Rune(m_rune | other.m_rune);}
 	bool operator<(const Rune& other) const { return m_rune < other.m_rune; }
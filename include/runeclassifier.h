@@ -0,0 +1,66 @@
+#ifndef __RUNECLASSIFIER_H__
+#define __RUNECLASSIFIER_H__
+
+#include <filesystem>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/ml.hpp>
+#include "rune.h"
+#include "word.h"
+namespace fs = std::filesystem;
+
+const int RUNE_CLASSIFIER_NB_SEGMENTS = 14; // segment bits of a rune (bits 6 and 14 have no segment)
+const int RUNE_CLASSIFIER_SEGMENT_BITS[RUNE_CLASSIFIER_NB_SEGMENTS] = { 0, 1, 2, 3, 4, 5, 7, 8, 9, 10, 11, 12, 13, 15 };
+const int RUNE_CLASSIFIER_SAMPLES_PER_SEGMENT = 9; // ink samples taken along each segment (or around the circle)
+const int RUNE_CLASSIFIER_PROFILE_ROWS = 8; // horizontal projection bins
+const int RUNE_CLASSIFIER_PROFILE_COLS = 4; // vertical projection bins
+const int RUNE_CLASSIFIER_NB_FEATURES = RUNE_CLASSIFIER_NB_SEGMENTS + RUNE_CLASSIFIER_PROFILE_ROWS + RUNE_CLASSIFIER_PROFILE_COLS;
+const int RUNE_CLASSIFIER_HIDDEN_LAYER_SIZE = 32;
+const int RUNE_CLASSIFIER_SYNTHETIC_WORDS = 1500; // generated noisy words added to the labelled images for training
+const float RUNE_CLASSIFIER_BIT_THRESHOLD = 0.5f; // network output above this sets the segment bit
+const int RUNE_CLASSIFIER_HOLDOUT_STRIDE = 4; // every 4th labelled image is held out of training for the evaluation, 0: none
+
+// Evaluation of a rune classifier over labelled word images
+struct RuneClassifierReport {
+	int nb_words = 0;
+	int nb_runes = 0;
+	int nb_rune_errors = 0; // runes with at least one wrong segment (or not found in the word image)
+	int nb_bit_errors = 0;
+	int nb_reference_rune_errors = 0; // same count for the mask based Word::decode_image
+	double classifier_ms = 0.0; // feature extraction + one batched predict
+	double reference_ms = 0.0; // Word::decode_image on every word
+};
+
+// Per segment rune classifier: a small MLP (cv::ml::ANN_MLP) over a compact feature vector per rune
+// (ink ratio sampled along the 14 segments + row / column projections) predicting the 14 segment bits at once
+// Runes are located on the word grid given by the separator (no per rune cell cutting, no mask rasterisation)
+class RuneClassifier {
+public:
+	RuneClassifier() = default;
+	bool load(const fs::path& model_file);
+	bool save(const fs::path& model_file) const;
+	bool is_trained() const;
+	// trains on the labelled images not held out (see RUNE_CLASSIFIER_HOLDOUT_STRIDE) and the synthetic words
+	bool train(const std::vector<fs::path>& labelled_folders, int nb_synthetic_words = RUNE_CLASSIFIER_SYNTHETIC_WORDS, unsigned int seed = 0,
+		int holdout_stride = RUNE_CLASSIFIER_HOLDOUT_STRIDE);
+	// evaluates on the held out labelled images only (all of them when holdout_stride is 0: training accuracy)
+	bool evaluate(const std::vector<fs::path>& labelled_folders, RuneClassifierReport& report, int holdout_stride = RUNE_CLASSIFIER_HOLDOUT_STRIDE) const;
+
+	// one row of features per rune -> one rune per row, in a single predict call
+	bool predict(const cv::Mat& features, std::vector<Rune>& runes) const;
+	// decode cropped binary word images (see crop_word_image), all the runes of all the words in one batch
+	bool decode_words(const std::vector<cv::Mat>& word_images, std::vector<Word>& words, std::vector<bool>& decoded) const;
+
+	// one row per rune of a cropped binary word image
+	static bool extract_features(const cv::Mat& word_image, cv::Mat& features);
+	// all the words stacked, nb_runes[i] rows for word i
+	static bool extract_features(const std::vector<cv::Mat>& word_images, cv::Mat& features, std::vector<int>& nb_runes);
+	static bool load_labelled_words(const std::vector<fs::path>& labelled_folders, std::vector<cv::Mat>& word_images, std::vector<Word>& labels);
+	// keeps the held out words (every holdout_stride-th one) or the other ones
+	static void split_labelled_words(int holdout_stride, bool held_out, std::vector<cv::Mat>& word_images, std::vector<Word>& labels);
+	static bool generate_synthetic_words(int nb_words, unsigned int seed, std::vector<cv::Mat>& word_images, std::vector<Word>& labels);
+private:
+	cv::Ptr<cv::ml::ANN_MLP> m_model;
+};
+
+#endif // __RUNECLASSIFIER_H__
@@ -3,9 +3,16 @@
 
 #include <filesystem>
 #include <map>
+#include <mutex>
+#include <atomic>
+#include <chrono>
 #include "rune.h"
 #include "word.h"
 #include "runedictionary.h"
+#include "runeclassifier.h"
+#include "chamfermatcher.h"
+#include "annotationrenderer.h"
+#include "toolbox.h"
 #include "opencv2/imgproc.hpp"
 #include "opencv2/imgcodecs.hpp"
 #include "opencv2/highgui.hpp"
@@ -14,6 +21,15 @@ namespace fs = std::filesystem;
 const double RUNE_MINIMAL_AREA = 100; // Minimum area for a rune to be considered valid. default 100.0f
 const double RUNE_DETECTION_THRESHOLD = 0.8f; // Threshold the result to find matches - Adjust as needed. default 0.8
 const char RUNE_WORD_TRANSLATION_SEPARATOR = '_'; // Separator for rune word translations
+const double RUNE_ZONE_DUPLICATE_IOU = 0.5; // Two detections overlapping more than this (intersection over union) are the same word
+const double RUNE_ZONE_LINE_TOLERANCE = 0.5; // Max separator y distance (relative to the zone height) to stay on the same text line
+const int RUNE_SCALE_FACTOR_STEPS = 20; // Scale steps tried between the min and max rune size
+const size_t RUNE_SCALE_HITS_HISTORY = 8; // Scale factors of the last detections, tried first on the next pages
+const int INCREMENTAL_TILE_SIZE = 32; // Tile size (pixels) of the change detection between successive captures
+const double INCREMENTAL_NEW_SCENE_RATIO = 0.5; // A capture changing this part of the tiles is a new scene (page angle estimated again)
+const size_t RUNE_HYPOTHESES_TOP_K = 5; // Word hypotheses kept per region
+const int RUNE_MATCH_RESULT_BORDER = 2; // Template matching results are scanned without this border (score peak neighbours)
+const double RUNE_HYPOTHESIS_THRESHOLD = 0.6; // Matches above this score are kept as hypotheses of their region, even below the detection threshold
 
 // Enum for horizontal text alignment
 enum class HorizontalAlignment {
@@ -29,9 +45,21 @@ enum class VerticalAlignment {
     Bottom
 };
 
+// A word matched over a region, with its score
+struct WordHypothesis {
+    Word word;
+    double score = 0.0; // template correlation (or chamfer score), in [0, 1]
+    double scale_factor = 0.0;
+    cv::Rect rect;
+};
+
 struct RuneZone { // Renamed from CharacterZone
     Word word;
     cv::Rect rect;
+    int line = -1; // text line index, set by order_rune_zones
+    double score = 0.0; // score of word
+    double scale_factor = 0.0;
+    std::vector<WordHypothesis> hypotheses; // best score per word over the region, best first (see attach_word_hypotheses)
 
     // Helper for easy comparison of rects
     bool operator==(const RuneZone& other) const { // Renamed from CharacterZone
@@ -42,6 +70,80 @@ struct RuneZone { // Renamed from CharacterZone
     }
 };
 
+// How templates are scored against the page in RuneDetector::detect_words
+enum class MatchingBackend {
+    Correlation, // cv::matchTemplate (TM_CCOEFF_NORMED) of the drawn or PNG word images
+    Chamfer // center line points against the page distance transform (see ChamferMatcher)
+};
+
+// Tuning of RuneDetector::detect_words
+struct DetectionOptions {
+    bool text_regions_only = true; // only match templates over the tiles classified as text (see find_text_regions)
+    int text_tile_size = TEXT_TILE_SIZE;
+    MatchingBackend backend = MatchingBackend::Correlation;
+    bool deskew = true; // straighten the page once before matching (see deskew_image)
+    double detection_threshold = 0.0; // 0: the backend default (RUNE_DETECTION_THRESHOLD or CHAMFER_DETECTION_THRESHOLD)
+    double hypothesis_threshold = RUNE_HYPOTHESIS_THRESHOLD;
+    size_t top_k = RUNE_HYPOTHESES_TOP_K; // hypotheses kept per region, 0: none
+};
+
+// Time budget of an anytime detection: a deadline and / or a cancellation flag set by another thread
+struct DetectionBudget {
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    const std::atomic<bool>* cancel = nullptr;
+
+    static DetectionBudget from_now(double milliseconds) {
+        DetectionBudget budget;
+        budget.deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::milli>(milliseconds));
+        return budget;
+    }
+    // a deadline or a cancellation flag: the detection orders its matches by expected payoff
+    bool is_limited() const {
+        return cancel != nullptr || deadline != std::chrono::steady_clock::time_point::max();
+    }
+    bool exhausted() const {
+        return (cancel != nullptr && cancel->load()) || std::chrono::steady_clock::now() >= deadline;
+    }
+};
+
+// Best so far zones of a detection
+struct DetectionResult {
+    std::vector<RuneZone> zones; // in reading order (see order_rune_zones)
+    std::vector<RuneZone> uncertain_zones; // regions matched above the hypothesis threshold only, in reading order
+    bool complete = true; // false when the budget ran out before every word was tried at every scale
+    double completeness = 1.0; // part of the dictionary words tried
+    double matched_ratio = 0.0; // image area correlated per (word, scale) match, search regions grown by the pattern included
+    double elapsed_ms = 0.0;
+};
+
+// Page kept between successive captures of the same scene (see RuneDetector::detect_words_incremental)
+struct PageState {
+    cv::Size size;
+    double skew_angle = 0.0; // estimated on the first capture of a scene, applied to the next ones
+    std::vector<uint64_t> tile_hashes; // see compute_tile_hashes
+    std::vector<RuneZone> zones;
+    std::vector<RuneZone> uncertain_zones;
+};
+
+// Per block outcome of a batch dictionarisation (one entry per partitioned rectangle)
+struct DictionarizeBlockReport {
+    cv::Rect rect;
+    std::string word_hash;
+    bool decoded = false;
+    bool added = false;
+    double duration_ms = 0.0; // decode time of the block
+};
+
+// Suppress duplicate zones (the best scored one is kept) and sort the remaining ones in reading order (lines top to bottom, left to right in a line)
+bool order_rune_zones(const std::vector<RuneZone>& zones, std::vector<RuneZone>& ordered_zones, double duplicate_iou = RUNE_ZONE_DUPLICATE_IOU);
+// Gives every zone the best hypothesis per word among the ones overlapping it more than duplicate_iou (top_k at most, best first)
+bool attach_word_hypotheses(std::vector<RuneZone>& zones, const std::vector<WordHypothesis>& hypotheses, size_t top_k = RUNE_HYPOTHESES_TOP_K, double duplicate_iou = RUNE_ZONE_DUPLICATE_IOU);
+// Regions of the hypotheses that no zone covers, as zones of their best hypothesis (greedy suppression of the overlapping ones)
+bool find_uncertain_zones(const std::vector<RuneZone>& zones, const std::vector<WordHypothesis>& hypotheses, std::vector<RuneZone>& uncertain_zones, size_t top_k = RUNE_HYPOTHESES_TOP_K, double duplicate_iou = RUNE_ZONE_DUPLICATE_IOU);
+// Part of a detected word bounding box where its translation is written
+cv::Rect get_translation_zone(const cv::Rect& bounding_box);
+
+// Not copyable (the dictionary mutex): pass detectors by reference
 class RuneDetector {
 public:
     //RuneDetector() = default;
@@ -50,16 +152,35 @@ public:
     bool register_word_image(const fs::path& word_image);
 	//bool detect_runes(const fs::path& image_path, std::vector<Rune>& detected_runes);
     bool detect_words(cv::Mat& image, std::vector<Word>& detected_words, int adaptative_cycles = 0, bool debug_mode = false, bool useGeneratedRunes = false, bool overwriteOnDetection = true);
+    bool detect_words(cv::Mat& image, DetectionResult& detection_result, const DetectionBudget& budget, int adaptative_cycles = 0, bool debug_mode = false, bool useGeneratedRunes = false, const std::vector<cv::Rect>* dirty_regions = nullptr);
+    bool detect_words_incremental(cv::Mat& image, DetectionResult& detection_result, int adaptative_cycles = 0, bool useGeneratedRunes = false);
+    void reset_page_state() { m_page_state = PageState(); }
+    bool annotate_languages(const cv::Mat& page, const std::vector<RuneZone>& zones, const std::vector<fs::path>& dictionary_files,
+        const fs::path& output_folder, const std::string& output_stem, std::vector<fs::path>& output_files);
+    AnnotationRenderer& get_annotation_renderer() { return m_annotation_renderer; }
     void displayMatProperties(const cv::Mat& mat, const std::string& name = "Mat");
-    bool generate_scale_factors(const cv::Mat& image, const cv::Mat& pattern, std::vector<double>& scale_factors);
+    bool generate_scale_factors(const cv::Mat& image, const cv::Mat& pattern, std::vector<double>& scale_factors, int nb_values = RUNE_SCALE_FACTOR_STEPS);
     cv::Mat get_image_lines(const cv::Mat& src);
     bool decode_word_image(const fs::path& word_image, Word& word);
     cv::Mat crop_black_borders(const cv::Mat& image);
 	bool dictionarize(const fs::path& image_path, bool debug_mode = false);
+    bool dictionarize_batch(const fs::path& image_path, std::vector<DictionarizeBlockReport>& report);
     //bool draw_text(cv::Mat& image, const cv::Rect& bounding_box, const std::string& translation, const cv::Scalar& color, int thickness);
     int image_detection(const fs::path& dictionary_file, const fs::path& image_file, int adaptative_cycles = 7, bool generatedRunes = true, bool debug_mode = false);
+    void set_detection_options(const DetectionOptions& options) { m_detection_options = options; }
+    const DetectionOptions& get_detection_options() const { return m_detection_options; }
+    bool load_rune_classifier(const fs::path& model_file) { return m_rune_classifier.load(model_file); }
 private:
+    DetectionOptions m_detection_options;
+    RuneClassifier m_rune_classifier; // when trained, dictionarize_batch decodes the runes with it
+    std::unordered_map<std::string, int> m_word_hits; // detections per word hash, frequent words are matched first
+    std::vector<double> m_scale_hits; // scale factors of the last detections, tried first
+    PageState m_page_state; // previous capture of detect_words_incremental
+    AnnotationRenderer m_annotation_renderer; // translations drawn over the detections
+    void order_words_by_payoff(std::vector<std::string>& hash_list) const;
+    void order_scale_factors_by_payoff(std::vector<double>& scale_factors, const std::vector<double>& confirmed_scale_factors) const;
     RuneDictionary* m_dictionary = nullptr;
+    std::mutex m_dictionary_mutex; // guards m_dictionary when blocks are decoded concurrently
 public:
     std::unordered_map<std::string, cv::Mat> m_rune_images; // Map to store rune images
 };
@@ -0,0 +1,92 @@
+#ifndef __STFT_H__
+#define __STFT_H__
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+#include "fft.h"
+
+enum class WindowType {
+    Rectangular,
+    Hann,
+    Hamming,
+    Blackman
+};
+
+struct StftConfig {
+    size_t window_size = 0; // samples per frame
+    size_t hop_size = 0; // samples between two frame starts, 0 = window_size (no overlap)
+    size_t fft_size = 0; // 0 = next power of two of window_size (the frame is zero padded)
+    WindowType window = WindowType::Hann;
+    size_t ring_size = 2; // frames kept valid after their callback (see Stft::get_frame)
+    bool compute_magnitudes = true; // false: raw frames only (time domain consumers like YIN)
+};
+
+// One analysis frame, valid until ring_size newer frames have been emitted
+struct StftFrame {
+    size_t index = 0; // frame number since the last reset
+    size_t start = 0; // position of the first sample in the stream
+    const float* samples = nullptr; // window_size raw samples (not windowed)
+    const double* magnitudes = nullptr; // fft_size / 2 + 1 bins |X[k]|, nullptr without compute_magnitudes
+};
+
+// Short time Fourier analysis of a sample stream: the window table and the FFT plan are built once by init, the samples
+// go through a ring of window_size values and every frame is written in one of ring_size preallocated slots.
+// Samples can be pushed in blocks of any length, the frames are the same as for the whole signal at once
+class Stft {
+public:
+    Stft() = default;
+    explicit Stft(const StftConfig& config) { init(config); }
+    bool init(const StftConfig& config);
+    void reset(); // forget the buffered samples and frames, keep the tables
+    bool is_valid() const { return m_window_size > 0; }
+
+    // calls on_frame for every frame completed by these samples, returns the number of frames
+    size_t push(const float* samples, size_t count, const std::function<void(const StftFrame&)>& on_frame);
+
+    // age 0 is the last emitted frame, up to ring_size - 1
+    const StftFrame* get_frame(size_t age = 0) const;
+
+    size_t get_window_size() const { return m_window_size; }
+    size_t get_hop_size() const { return m_hop_size; }
+    size_t get_fft_size() const { return m_fft_plan.size(); }
+    size_t get_nb_bins() const { return m_fft_plan.size() / 2 + 1; }
+    const std::vector<double>& get_window() const { return m_window; }
+    double get_bin_frequency(double bin, double sample_rate) const { return bin * sample_rate / m_fft_plan.size(); }
+
+    // symmetric window (same as the previous per chunk Hann: 0.5 * (1 - cos(2 pi j / (size - 1))))
+    static void make_window(WindowType type, size_t size, std::vector<double>& window);
+private:
+    // frame points into the slot's own buffers: copies rebind it
+    struct FrameSlot {
+        std::vector<float> samples;
+        std::vector<double> magnitudes;
+        StftFrame frame;
+
+        FrameSlot() = default;
+        FrameSlot(const FrameSlot& other) : samples(other.samples), magnitudes(other.magnitudes), frame(other.frame) { bind(); }
+        FrameSlot& operator=(const FrameSlot& other);
+        void bind();
+    };
+
+    size_t m_window_size = 0;
+    size_t m_hop_size = 0;
+    bool m_compute_magnitudes = true;
+    std::vector<double> m_window;
+    FftPlan<double> m_fft_plan;
+
+    std::vector<float> m_history; // ring of the last window_size samples
+    size_t m_nb_samples = 0; // samples pushed since the last reset
+    size_t m_next_frame_start = 0;
+
+    std::vector<FrameSlot> m_slots;
+    size_t m_nb_frames = 0;
+
+    // shared FFT workspace
+    std::vector<double> m_windowed; // fft_size, zero padded after window_size
+    std::vector<FftPlan<double>::Complex> m_spectrum;
+
+    void emit_frame(const std::function<void(const StftFrame&)>& on_frame);
+};
+
+#endif // __STFT_H__
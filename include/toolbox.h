@@ -6,11 +6,24 @@
 #include <opencv2/core.hpp>
 #include <opencv2/core/types.hpp>
 #include <filesystem>
+#include <cstdint>
 #include "note.h"
 namespace fs = std::filesystem;
 
 const int RUNE_IMAGE_BINARY_FILTER_THRESOLD = 128; // Threshold for binary filter on rune images
 const auto MAX_IMAGE_DETECTION_DIMENSIONS = cv::Size(1280, 900);
+const double REDUCED_DECODE_MAX_UNDERSHOOT = 0.05; // A reduced decode may be this much smaller than the requested bounds (not an exact bound)
+const int TEXT_TILE_SIZE = 48; // Tile size (pixels) of the text region classifier
+const int TEXT_TILE_MIN_STROKE_LENGTH = 16; // Shortest horizontal stroke (pixels) that can be a word separator
+const int TEXT_TILE_MAX_STROKE_TICKNESS = 4; // Thicker horizontal strokes are filled areas, not separators
+const double TEXT_TILE_MIN_INK_DENSITY = 0.04; // Tiles with less ink than this are empty
+const double TEXT_TILE_MAX_INK_DENSITY = 0.25; // Tiles with more ink than this are illustrations
+const double TEXT_TILE_MIN_STROKE_RATIO = 0.10; // Min part of the tile ink made of thin horizontal strokes
+const double TEXT_REGION_MAX_WASTE = 1.25; // Max area growth allowed when merging a row of text tiles into a region
+const double DESKEW_MAX_ANGLE = 15.0; // Only lines closer than this to the horizontal (degrees) vote for the page angle
+const double DESKEW_MIN_ANGLE = 0.25; // Pages rotated by less than this (degrees) are left untouched
+const double DESKEW_MIN_LINE_LENGTH = 0.05; // Shortest voting line, relative to the page width
+const double DESKEW_ANGLE_RESOLUTION = 0.25; // Angle resolution of the line detection (degrees)
 
 // Define the constant vector of 3-character language codes
 const std::vector<std::string> language_codes_3_char = {
@@ -41,10 +54,19 @@ const std::vector<std::string> language_codes_3_char = {
 };
 
 
+// Projection kernels (vectorised): pixels equal to value per row / column of a CV_8U image,
+// first and last index of value in a row of pixels, runs and bounds of projection profiles
+bool count_value_per_row(const cv::Mat& image, uchar value, std::vector<int>& counts);
+bool count_value_per_column(const cv::Mat& image, uchar value, std::vector<int>& counts);
+bool find_value_bounds(const uchar* data, int length, uchar value, int& first, int& last);
+bool find_first_run_above(const std::vector<int>& profile, double threshold, int& run_begin, int& run_end);
+bool find_profile_bounds(const std::vector<int>& profile, int& first, int& last);
+
 bool find_horizontal_separator(const cv::Mat& binary_image, int& line_center_y, int& separator_tickness);
 bool find_horizontal_separator_bounds(const cv::Mat& binary_image, int line_center_y, int& line_center_x_min, int& line_center_x_max);
 bool crop_borders(const cv::Mat& image, int line_center_y, int line_center_x_min, int line_center_x_max, cv::Mat& cropped_image);
 bool make_white_rune_black_background(cv::Mat& image);
+bool crop_word_image(const cv::Mat& binary_word_image, cv::Mat& cropped_image);
 
 cv::Mat applyErosion(const cv::Mat& input_image, int kernel_size, int iterations = 1);
 cv::Mat applyDilation(const cv::Mat& input_image, int kernel_size, int iterations = 1);
@@ -52,7 +74,15 @@ cv::Mat applyOpening(const cv::Mat& input_image, int kernel_size, int iterations
 cv::Mat applyClosing(const cv::Mat& input_image, int kernel_size, int iterations = 1);
 
 std::vector<std::string> loadLinesFromFile(const fs::path& file);
-bool partition_image(cv::Mat& image, std::vector<cv::Rect>& partition);
+// Timings of partition_image
+struct PartitionTiming {
+    double threshold_ms = 0.0;
+    double labelling_ms = 0.0; // connected components and their stats
+    double filtering_ms = 0.0; // nesting and outline tests of the candidates
+    int nb_components = 0;
+    int nb_candidates = 0; // components big enough to be a block
+};
+bool partition_image(cv::Mat& image, std::vector<cv::Rect>& partition, PartitionTiming* timing = nullptr);
 
 double frequencyToMidiNote(double frequency_hz);
 
@@ -69,6 +99,19 @@ void toLowerFast(std::string& s);
 std::string toLowerFastCopy(const std::string& s);
 
 void resize_to_fit_max_bounds(cv::Mat& image, const cv::Size& max_bounds);
-cv::Mat detectAndMaskStraightLines(const cv::Mat& inputImage, double minLineLength, double maxLineGap);
+cv::Mat detectAndMaskStraightLines(const cv::Mat& inputImage, double minLineLength, double maxLineGap, std::vector<cv::Vec4i>& detectedLines, double theta = CV_PI / 180);
+bool read_image_size(const fs::path& image_file, cv::Size& size);
+int get_reduced_decode_factor(const cv::Size& image_size, const cv::Size& max_bounds);
+// max_bounds: decoded at about this size, up to REDUCED_DECODE_MAX_UNDERSHOOT smaller (see get_reduced_decode_factor)
+bool load_gray_image(const fs::path& image_file, cv::Mat& image, const cv::Size& max_bounds = cv::Size());
+bool load_color_image(const fs::path& image_file, cv::Mat& image, const cv::Size& max_bounds = cv::Size());
+bool make_ink_mask(const cv::Mat& image, cv::Mat& ink);
+bool merge_rects(const std::vector<cv::Rect>& rects, std::vector<cv::Rect>& disjoint_rects);
+bool find_text_regions(const cv::Mat& image, std::vector<cv::Rect>& text_regions, double& skipped_ratio, int tile_size = TEXT_TILE_SIZE, bool debug_mode = false);
+bool estimate_skew_angle(const cv::Mat& image, double& angle);
+bool deskew_image(cv::Mat& image, double& angle);
+bool rotate_image(cv::Mat& image, double angle);
+bool compute_tile_hashes(const cv::Mat& image, int tile_size, std::vector<uint64_t>& tile_hashes);
+bool find_dirty_regions(const std::vector<uint64_t>& previous_hashes, const std::vector<uint64_t>& tile_hashes, const cv::Size& image_size, int tile_size, std::vector<cv::Rect>& dirty_regions, double& dirty_ratio);
 
 #endif // __TOOLBOX_H__
\ No newline at end of file
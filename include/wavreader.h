@@ -0,0 +1,73 @@
+#ifndef __WAVREADER_H__
+#define __WAVREADER_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+const int WAV_DOWNMIX = -1; // channel argument: mean of all the channels
+const size_t WAV_READ_BLOCK_FRAMES = 4096; // frames converted per block (bounds the scratch buffer)
+
+enum class WavSampleFormat {
+    Unknown,
+    UInt8,
+    Int16,
+    Int24,
+    Int32,
+    Float32,
+    Float64
+};
+
+// Format of the "fmt " chunk (WAVE_FORMAT_EXTENSIBLE resolved to its sub format) and position of the "data" chunk
+struct WavInfo {
+    uint16_t format_tag = 0; // 1 = PCM, 3 = IEEE float
+    uint16_t channels = 0;
+    uint32_t sample_rate = 0;
+    uint16_t bits_per_sample = 0;
+    uint16_t block_align = 0; // bytes per frame (all channels)
+    WavSampleFormat sample_format = WavSampleFormat::Unknown;
+    size_t nb_frames = 0;
+    size_t data_offset = 0; // in the file
+    double get_duration() const { return sample_rate > 0 ? (double)nb_frames / sample_rate : 0.0; }
+};
+
+// RIFF/WAVE reader: walks the chunks (LIST, fact... are skipped, fmt may be longer than 16 bytes), memory maps the file
+// and converts the data chunk to float samples in [-1, 1], one channel or the mean of all, straight into the caller buffer
+class WavReader {
+public:
+    WavReader() = default;
+    ~WavReader() { close(); }
+    WavReader(const WavReader&) = delete;
+    WavReader& operator=(const WavReader&) = delete;
+
+    bool open(const std::filesystem::path& file);
+    void close();
+    bool is_open() const { return m_data != nullptr; }
+    const WavInfo& get_info() const { return m_info; }
+
+    // frames [first_frame, first_frame + nb_frames) of a channel (WAV_DOWNMIX: mean of the channels) in output,
+    // returns the number of frames written (fewer at the end of the data)
+    size_t read(float* output, size_t first_frame, size_t nb_frames, int channel = WAV_DOWNMIX);
+    // whole data chunk, output is resized once
+    bool read_all(std::vector<float>& output, int channel = WAV_DOWNMIX);
+private:
+    WavInfo m_info;
+    const uint8_t* m_file_data = nullptr; // whole mapped file
+    size_t m_file_size = 0;
+    const uint8_t* m_data = nullptr; // data chunk
+#ifdef _WIN32
+    void* m_file_handle = nullptr;
+    void* m_mapping_handle = nullptr;
+#else
+    int m_file_descriptor = -1;
+#endif
+    std::vector<float> m_block; // interleaved float samples of one block (multichannel and 24 bit files only)
+    std::vector<uint64_t> m_aligned; // raw bytes of one block, when the mapped samples are not aligned on their size
+
+    bool map_file(const std::filesystem::path& file);
+    bool parse_chunks();
+    void convert_block(const uint8_t* data, size_t nb_frames, int channel, float* output);
+};
+
+#endif // __WAVREADER_H__
@@ -5,6 +5,19 @@
 #include <string>
 #include <rune.h>
 
+// Rune cells of a word image, derived from its separator: it spans the runes plus one stroke tickness (round caps)
+struct RuneGrid {
+	int separator_y = 0;
+	int tickness = 0; // separator tickness (pixels)
+	int x_min = 0; // first pixel of the separator
+	int x_max = 0; // last pixel of the separator
+	int nb_runes = 0;
+	double rune_width = 0.0;
+	double rune_height = 0.0;
+	// top left of the layout of rune index (point E lies on the separator, half a stroke after x_min)
+	cv::Point2d get_rune_origin(int index) const;
+};
+
 class Word {
 public:
 	Word() = default;
@@ -14,7 +27,9 @@ public:
 	std::string get_hash() const;
 	std::string to_pseudophonetic() const;
 	bool parse_runes(const std::string& str, std::vector<Rune>& runes);
-	bool decode_image(const cv::Mat& word_image);
+	bool decode_image(const cv::Mat& word_image, bool debug_mode = false);
+	bool decode_grid(const cv::Mat& binary_word_image, const RuneGrid& grid);
+	static bool find_rune_grid(const cv::Mat& binary_word_image, RuneGrid& grid);
 	size_t size() const { return m_runes.size(); }
 	bool generate_image(cv::Size2i rune_size, double tickness, cv::Mat& output_image) const;
 	std::vector<Rune> get_runes() const { return m_runes; }
@@ -0,0 +1,90 @@
+#ifndef __YINDETECTOR_H__
+#define __YINDETECTOR_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "fft.h"
+
+const auto YIN_NOTE_THRESHOLD = 0.05f; // allowed aperiodicity for a note (about 95% probability)
+const auto YIN_MIN_FREQUENCY = 60.0; // in Hz, lowest detectable pitch (bounded by half the window)
+const auto YIN_MAX_FREQUENCY = 4200.0; // in Hz, above C8
+const auto YIN_WINDOW_DURATION = 1000.0 / 44100.0; // in sec, 1000 samples at 44.1 kHz
+const auto YIN_MIN_PERIOD = 7.0; // in samples, shortest period found reliably (the sample rate must be above 7 times the pitch)
+// squared differences per window (integration size x lags) up to which Auto picks DirectSimd: measured crossover with the
+// FFT at 44.1 kHz, DirectSimd is faster for 1000 samples with 500 lags and 2048 with 221, slower for 2048 with 1024
+const auto YIN_AUTO_MAX_DIRECT_WORK = size_t(1) << 19;
+
+// How the difference function d(tau) is computed
+enum class YinMethod {
+    Direct, // sum of squared differences for every lag: O(window * lags), scalar reference
+    DirectSimd, // same sums and normalization, several lags at once with vector registers (scalar when SIMD is unavailable)
+    Fft, // energies minus twice the autocorrelation (FFT plan): O(window log window)
+    Auto, // DirectSimd up to YIN_AUTO_MAX_DIRECT_WORK with vector kernels, Fft otherwise
+    Measured // the faster of DirectSimd and Fft for this window, timed by init on this CPU
+};
+
+// YIN pitch detection (same steps as Yin_getPitch) with buffers allocated once by init. Every window is analysed in a
+// single pass over the lags of the frequency range, for any sample rate
+class YinDetector {
+public:
+    YinDetector() = default;
+    YinDetector(uint32_t sample_rate, size_t window_size, float threshold = YIN_NOTE_THRESHOLD,
+        double min_frequency = YIN_MIN_FREQUENCY, double max_frequency = YIN_MAX_FREQUENCY, YinMethod method = YinMethod::Auto) {
+        init(sample_rate, window_size, threshold, min_frequency, max_frequency, method);
+    }
+    bool init(uint32_t sample_rate, size_t window_size, float threshold = YIN_NOTE_THRESHOLD,
+        double min_frequency = YIN_MIN_FREQUENCY, double max_frequency = YIN_MAX_FREQUENCY, YinMethod method = YinMethod::Auto);
+    bool is_valid() const { return m_window_size > 0; }
+
+    // pitch in Hz of window_size samples, -1 if no lag is periodic enough
+    float get_pitch(const float* samples);
+    // 16 bit samples, widened to float in an internal buffer
+    float get_pitch(const int16_t* samples);
+    // 1 - aperiodicity of the last pitch found, 0 if none
+    float get_probability() const { return m_probability; }
+
+    size_t get_window_size() const { return m_window_size; }
+    uint32_t get_sample_rate() const { return m_sample_rate; }
+    size_t get_min_lag() const { return m_min_lag; }
+    size_t get_max_lag() const { return m_max_lag; }
+    YinMethod get_method() const { return m_method; } // never Auto or Measured once initialised
+    // also accept a period whose parabola minimum between two lags is below the threshold (decimated signals: the
+    // shortest periods are a few samples and dip between the lags), off by default
+    void set_parabolic_threshold(bool enabled) { m_parabolic_threshold = enabled; }
+    // vector kernels (OpenCV universal intrinsics) of DirectSimd available and enabled. Their width is fixed at compile
+    // time, the only runtime switch is cv::useOptimized()
+    bool is_simd() const { return m_use_simd; }
+    // cumulative mean normalized difference d'(tau) of the last window, lags [0, max_lag)
+    const std::vector<float>& get_difference() const { return m_difference; }
+private:
+    uint32_t m_sample_rate = 0;
+    size_t m_window_size = 0;
+    size_t m_min_lag = 0; // first lag searched (highest frequency)
+    size_t m_max_lag = 0; // lags [0, max_lag), at most half the window
+    size_t m_integration_size = 0; // window_size - max_lag samples compared for every lag
+    float m_threshold = YIN_NOTE_THRESHOLD;
+    float m_probability = 0;
+    YinMethod m_method = YinMethod::Fft;
+    bool m_use_simd = false;
+    bool m_parabolic_threshold = false;
+    std::vector<float> m_difference; // d(tau), then the cumulative mean normalized d'(tau)
+    std::vector<float> m_running_sums; // sum of d over [1, tau], for the vector normalization
+    std::vector<float> m_samples; // widened 16 bit samples
+
+    // Fft method: the window fits the plan without zero padding wrapping over the compared samples
+    FftPlan<double> m_fft_plan;
+    std::vector<double> m_fft_buffer; // fft_size real values, then the autocorrelation
+    std::vector<FftPlan<double>::Complex> m_head_spectrum; // first integration_size samples
+    std::vector<FftPlan<double>::Complex> m_window_spectrum; // whole window
+    std::vector<double> m_energy; // prefix sums of the squared samples
+
+    void difference(const float* samples);
+    void difference_fft(const float* samples);
+    YinMethod measure_fastest_method();
+    void cumulative_mean_normalized_difference();
+    int absolute_threshold();
+    float parabolic_interpolation(int tau_estimate) const;
+};
+
+#endif // __YINDETECTOR_H__
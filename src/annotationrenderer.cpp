@@ -0,0 +1,153 @@
+#include "annotationrenderer.h"
+
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+#include <opencv2/core/utility.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+// Same fit as draw_text_in_rect (centered, font scale fitting the zone without padding), drawn as a coverage mask
+// then colored through a lookup table: pixel = background + (color - background) * coverage
+bool AnnotationRenderer::rasterise(const std::string& text, const cv::Size& size, int type, cv::Mat& patch) const
+{
+	int channels = CV_MAT_CN(type);
+	if (CV_MAT_DEPTH(type) != CV_8U || (channels != 1 && channels != 3 && channels != 4)) {
+		std::cerr << "Error: Annotations are drawn on 8 bit gray, BGR or BGRA images only." << std::endl;
+		return false;
+	}
+	int available_width = size.width - 2 * m_style.padding;
+	int available_height = size.height - 2 * m_style.padding;
+	if (available_width <= 0 || available_height <= 0) {
+		return false;
+	}
+
+	cv::Mat coverage = cv::Mat::zeros(size, CV_8U);
+	int baseline = 0;
+	cv::Size text_size_ref = cv::getTextSize(text, m_style.font_face, 1.0, m_style.tickness, &baseline);
+	if (text_size_ref.width > 0 && text_size_ref.height > 0) {
+		double font_scale = (std::min)((double)available_width / text_size_ref.width, (double)available_height / text_size_ref.height);
+		baseline = 0;
+		cv::Size text_size = cv::getTextSize(text, m_style.font_face, font_scale, m_style.tickness, &baseline);
+		int text_x = m_style.padding + (available_width - text_size.width) / 2;
+		int text_y = m_style.padding + static_cast<int>(std::round(available_height / 2.0 + text_size.height / 2.0 - baseline));
+		cv::putText(coverage, text, cv::Point(text_x, text_y), m_style.font_face, font_scale, cv::Scalar(255), m_style.tickness, cv::LINE_AA);
+	}
+
+	cv::Mat lut(1, 256, CV_MAKETYPE(CV_8U, channels));
+	for (int alpha = 0; alpha < 256; alpha++) {
+		uchar* entry = lut.ptr<uchar>(0) + alpha * channels;
+		for (int c = 0; c < channels; c++) {
+			// gray images use the first component of the colors (like cv::putText)
+			double background = m_style.background_color[c], color = m_style.color[c];
+			entry[c] = cv::saturate_cast<uchar>(background + (color - background) * alpha / 255.0);
+		}
+	}
+	if (channels == 1) {
+		cv::LUT(coverage, lut, patch);
+	}
+	else {
+		cv::Mat coverage_channels;
+		cv::cvtColor(coverage, coverage_channels, channels == 3 ? cv::COLOR_GRAY2BGR : cv::COLOR_GRAY2BGRA);
+		cv::LUT(coverage_channels, lut, patch);
+	}
+	return true;
+}
+
+cv::Mat AnnotationRenderer::get_patch(const std::string& text, const cv::Size& size, int type)
+{
+	std::string key = text + '\x1f' + std::to_string(size.width) + 'x' + std::to_string(size.height) + ':' + std::to_string(type);
+	{
+		std::lock_guard<std::mutex> lock(m_cache_mutex);
+		auto it = m_cache.find(key);
+		if (it != m_cache.end()) {
+			m_cache_hits++;
+			return it->second;
+		}
+	}
+
+	// rasterised outside of the lock: two threads may render the same patch once each
+	cv::Mat patch;
+	if (!rasterise(text, size, type, patch)) {
+		return cv::Mat();
+	}
+	m_cache_misses++;
+	std::lock_guard<std::mutex> lock(m_cache_mutex);
+	if (m_cache.size() >= ANNOTATION_CACHE_MAX_ENTRIES) {
+		m_cache.clear();
+	}
+	m_cache[key] = patch;
+	return patch;
+}
+
+void AnnotationRenderer::clear_cache()
+{
+	std::lock_guard<std::mutex> lock(m_cache_mutex);
+	m_cache.clear();
+	m_cache_hits = 0;
+	m_cache_misses = 0;
+}
+
+bool AnnotationRenderer::draw(cv::Mat& image, const std::string& text, const cv::Rect& zone)
+{
+	cv::Rect visible_zone = zone & cv::Rect(0, 0, image.cols, image.rows);
+	if (visible_zone.empty()) {
+		return false;
+	}
+	cv::Mat patch = get_patch(text, zone.size(), image.type());
+	if (patch.empty()) {
+		return false;
+	}
+	patch(visible_zone - zone.tl()).copyTo(image(visible_zone));
+	return true;
+}
+
+bool AnnotationRenderer::render(cv::Mat& image, const std::vector<Annotation>& annotations, RuneDictionary& dictionary)
+{
+	for (const auto& annotation : annotations) {
+		draw(image, dictionary.translate(annotation.word), annotation.zone);
+	}
+	return true;
+}
+
+bool AnnotationRenderer::render_languages(const cv::Mat& page, const std::vector<Annotation>& annotations, const std::vector<fs::path>& dictionary_files,
+	const fs::path& output_folder, const std::string& output_stem, std::vector<fs::path>& output_files)
+{
+	output_files.assign(dictionary_files.size(), fs::path());
+	if (page.empty()) {
+		std::cerr << "Error: Cannot annotate an empty page." << std::endl;
+		return false;
+	}
+	std::error_code error;
+	fs::create_directories(output_folder, error);
+	if (error) {
+		std::cerr << "Error: Could not create output folder " << output_folder << ": " << error.message() << std::endl;
+		return false;
+	}
+
+	// one language per task: load the dictionary, annotate a copy of the page, write it
+	std::atomic<bool> success = true;
+	cv::parallel_for_(cv::Range(0, (int)dictionary_files.size()), [&](const cv::Range& range) {
+		for (int i = range.start; i < range.end; i++) {
+			RuneDictionary dictionary;
+			if (!dictionary.load(dictionary_files[i])) {
+				success = false;
+				continue;
+			}
+			// dictionary.<language>.txt -> <language>
+			std::string language = dictionary_files[i].stem().extension().string();
+			language = language.empty() ? dictionary_files[i].stem().string() : language.substr(1);
+
+			cv::Mat annotated_page = page.clone();
+			render(annotated_page, annotations, dictionary);
+			fs::path output_file = output_folder / (output_stem + "." + language + ".png");
+			if (!cv::imwrite(output_file.string(), annotated_page)) {
+				std::cerr << "Error: Could not write annotated page " << output_file << std::endl;
+				success = false;
+				continue;
+			}
+			output_files[i] = output_file;
+		}
+	});
+	return success;
+}
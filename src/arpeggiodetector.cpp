@@ -3,28 +3,26 @@
 #include <queue>
 #include <cmath>
 #include <algorithm>
-#include <yin.h>
+#include "yindetector.h"
 #include <toolbox.h>
+#include "stft.h"
+#include "wavreader.h"
+#include "arpeggiostream.h"
 using Complex = std::complex<double>;
 
+// Vector API kept for compatibility (same exp(+2i pi jk / n) convention): repeated transforms should reuse a FftPlan
 void FFT::fft(std::vector<Complex>& a) {
-    auto n = a.size();
-    if (n <= 1) return;
-
-    std::vector<Complex> a0(n / 2), a1(n / 2);
-    for (int i = 0; 2 * i < n; i++) {
-        a0[i] = a[2 * i];
-        a1[i] = a[2 * i + 1];
+    if (a.size() <= 1) return;
+    FftPlan<double> plan;
+    if (!plan.init(a.size())) {
+        return;
     }
-    fft(a0);
-    fft(a1);
-
-    double ang = 2 * std::numbers::pi / n;
-    Complex w(1), wn(cos(ang), sin(ang));
-    for (int i = 0; 2 * i < n; i++) {
-        a[i] = a0[i] + w * a1[i];
-        a[i + n / 2] = a0[i] - w * a1[i];
-        w *= wn;
+    for (auto& value : a) {
+        value = std::conj(value);
+    }
+    plan.forward(a.data());
+    for (auto& value : a) {
+        value = std::conj(value);
     }
 }
 
@@ -155,164 +153,146 @@ std::vector<Note> ArpeggioDetector::get_clean_sequence(const std::vector<Note>&
     return std::vector<Note>(cleanSeq);
 }
 
-Note ArpeggioDetector::findClosestNote(double frequency) {
-    if (frequency < SILENCE_TONE_THRESHOLD) return Note::SILENCE;
+Note ArpeggioDetector::get_pitch_note(double pitch, const NoteQuantizer& quantizer) {
+    if (pitch < 0) return Note::UNKNOWN;
+    if (pitch < SILENCE_TONE_THRESHOLD) return Note::SILENCE;
 
-    double min_dist = std::numeric_limits<double>::max();
-    Note best_match = Note::UNKNOWN;
+    // nearest note of the retuned scale, UNKNOWN out of C0..B8
+    return quantizer.quantize(pitch).note;
+}
 
-    for (const auto& note : note_frequencies) {
-        double dist = std::abs(note.second - frequency);
-        if (dist < min_dist) {
-            min_dist = dist;
-            best_match = note.first;
+bool ArpeggioDetector::init_frame_analysis(uint32_t sample_rate, double note_length, bool yin_algo, double overlap, Stft& stft, YinDetector& yin) {
+    StftConfig config;
+    if (yin_algo) {
+        // min buffer length => 1/freq * sample rate
+        // ex: C0 => 1/16.35 Hz = 0,0611620795107034 sec => 0.061162 * 44100 = 2 697 samples
+        // ex: A4 => 1/440 Hz = 0,0022727272727273 sec => 100,22 samples
+        // one pass over the lags up to half the window (pitches down to about 88 Hz, whatever the sample rate)
+        config.window_size = static_cast<size_t>(std::lround(sample_rate * YIN_WINDOW_DURATION));
+        // raw frames only: no window nor spectrum
+        config.window = WindowType::Rectangular;
+        config.compute_magnitudes = false;
+        if (!yin.init(sample_rate, config.window_size, YIN_NOTE_THRESHOLD)) {
+            return false;
         }
     }
-
-    // Tolerance: frequency must be closer than ~3% of the target
-    // Semi-tone is around 5.9%, so 3% is a good margin.
-    if (min_dist / frequency < 0.03) {
-        return best_match;
+    else {
+        const double chunk_duration_s = note_length / 1000.0; // 100 ms
+        // Hann window to reduce spectral losses, zero padded to the next power of 2 (window table and FFT plan built once)
+        config.window_size = static_cast<size_t>(sample_rate * chunk_duration_s);
+        config.window = WindowType::Hann;
     }
-
-    return Note::UNKNOWN;
+    config.hop_size = std::max<size_t>(1, static_cast<size_t>(std::lround(config.window_size * (1.0 - std::clamp(overlap, 0.0, 0.95)))));
+    return stft.init(config);
 }
 
-void ArpeggioDetector::detect_note_sequence(const std::vector<float>& samples, uint32_t sampleRate, std::vector<Note>& detected_sequence, double note_length) {
-    const double chunk_duration_s = note_length / 1000.0; // 100 ms
-    const size_t samples_per_chunk = static_cast<size_t>(sampleRate * chunk_duration_s);
-    // Determine FFT size (next power of 2 for best efficiency)
-    size_t fft_size = 1;
-    while (fft_size < samples_per_chunk) {
-        fft_size *= 2;
+double ArpeggioDetector::get_frame_pitch(const StftFrame& frame, const Stft& stft, YinDetector* yin, uint32_t sample_rate) {
+    if (yin != nullptr) {
+        //auto proba = yin->get_probability(); // TODO: maybe we should filter with proba > 90%
+        return yin->get_pitch(frame.samples);
     }
 
-    std::cout << "\nDetecting note sequence (range : " << (int)note_length << "ms)\n";
-
-    for (size_t i = 0; i + samples_per_chunk <= samples.size(); i += samples_per_chunk) {
+    // Find peak frequency
+    double max_magnitude = 0.0;
+    size_t peak_index = 0;
 
-        std::vector<FFT::Complex> chunk(fft_size, 0.0);
+    // Analyze only the first half of FFT result (symetrical)
+    const size_t half_size = stft.get_fft_size() / 2;
+    for (size_t j = 1; j < half_size; ++j) {
+        if (frame.magnitudes[j] > max_magnitude) {
+            max_magnitude = frame.magnitudes[j];
+            peak_index = j;
+        }
+    }
 
-        // Apply Hann window to reduce spectrall losses
-        for (size_t j = 0; j < samples_per_chunk; ++j) {
-            double hann_multiplier = 0.5 * (1 - cos(2 * std::numbers::pi * j / (samples_per_chunk - 1)));
-            chunk[j] = samples[i + j] * hann_multiplier;
+    // parabola through the log magnitudes around the peak: the frequency between two bins, for the deviation in cents
+    double peak_bin = (double)peak_index;
+    if (peak_index > 0 && peak_index + 1 < half_size && frame.magnitudes[peak_index - 1] > 0 && frame.magnitudes[peak_index + 1] > 0) {
+        double left = std::log(frame.magnitudes[peak_index - 1]);
+        double center = std::log(frame.magnitudes[peak_index]);
+        double right = std::log(frame.magnitudes[peak_index + 1]);
+        double curvature = left - 2 * center + right;
+        if (curvature < 0) {
+            peak_bin += 0.5 * (left - right) / curvature;
         }
+    }
 
-        // Compute FFT
-        FFT::fft(chunk);
+    return stft.get_bin_frequency(peak_bin, sample_rate);
+}
 
-        // Find peak frequency
-        double max_magnitude = 0.0;
-        size_t peak_index = 0;
+void ArpeggioDetector::detect_note_sequence(const std::vector<float>& samples, uint32_t sampleRate, std::vector<Note>& detected_sequence, double note_length, bool yin_algo, double overlap) {
+    if (!yin_algo) {
+        std::cout << "\nDetecting note sequence (range : " << (int)note_length << "ms)\n";
+    }
 
-        // Analyze only the first half of FFT result (symetrical)
-        for (size_t j = 1; j < fft_size / 2; ++j) {
-            double mag = std::abs(chunk[j]);
-            if (mag > max_magnitude) {
-                max_magnitude = mag;
-                peak_index = j;
-            }
-        }
+    Stft stft;
+    YinDetector yin;
+    if (!init_frame_analysis(sampleRate, note_length, yin_algo, overlap, stft, yin)) {
+        return;
+    }
 
-        double peak_frequency = static_cast<double>(peak_index) * sampleRate / fft_size;
+    // frame pitches first: the quantisation is centred on the tuning of the whole recording
+    std::vector<double> pitches;
+    TuningEstimator tuning_estimator;
+    stft.push(samples.data(), samples.size(), [&](const StftFrame& frame) {
+        double pitch = get_frame_pitch(frame, stft, yin_algo ? &yin : nullptr, sampleRate);
+        pitches.push_back(pitch);
+        if (pitch >= SILENCE_TONE_THRESHOLD) {
+            tuning_estimator.add(pitch);
+        }
+    });
+    NoteQuantizer quantizer;
+    double tuning = 0.0;
+    if (tuning_estimator.estimate(tuning)) {
+        quantizer.set_tuning(tuning);
+    }
 
-        auto note = findClosestNote(peak_frequency);
+    for (double pitch : pitches) {
+        auto note = get_pitch_note(pitch, quantizer);
 
+        if (yin_algo) {
+            // windows without pitch are skipped
+            if (note != Note::UNKNOWN) {
+                detected_sequence.push_back(note);
+                std::cout << note_to_string(note) << " ";
+            }
+        }
         // to avoid infinite repetitions of "SILENCE" or "UNKNOWN"
-        if (detected_sequence.empty() || detected_sequence.back() != note || (note != Note::SILENCE && note != Note::UNKNOWN)) {
+        else if (detected_sequence.empty() || detected_sequence.back() != note || (note != Note::SILENCE && note != Note::UNKNOWN)) {
             detected_sequence.push_back(note);
         }
     }
 }
 
-std::vector<Note> ArpeggioDetector::detect_note_sequence(const std::filesystem::path& filePath, double note_length, bool yin_algo) {
+std::vector<Note> ArpeggioDetector::detect_note_sequence(const std::filesystem::path& filePath, double note_length, bool yin_algo, double overlap) {
     if (!std::filesystem::exists(filePath)) {
         std::cerr << "Erreur : Le fichier '" << filePath << "' n'existe pas." << std::endl;
         return std::vector<Note>();
     }
 
-    std::ifstream file(filePath, std::ios::binary);
-    if (!file.is_open()) {
-        std::cerr << "Error : Impossible to open file." << std::endl;
-        return std::vector<Note>();
-    }
-
-    WavHeader header;
-    file.read(reinterpret_cast<char*>(&header), sizeof(WavHeader));
-
-    // Validation simple
-    if (std::string(header.riff, 4) != "RIFF" || std::string(header.wave, 4) != "WAVE") {
-        std::cerr << "Error: Invalid or unsupported file (RIFF/WAVE header is missing)." << std::endl;
-        return std::vector<Note>();
-    }
-    if (header.format_type != 1) { // 1 = PCM
-        std::cerr << "Error: Only uncompressed WAV PCM are supported." << std::endl;
+    WavReader wav_reader;
+    if (!wav_reader.open(filePath)) {
         return std::vector<Note>();
     }
+    const WavInfo header = wav_reader.get_info(); // close() resets the reader info
 
     std::cout << "File opened : " << filePath << "\n"
         << "Sample rate: " << header.sample_rate << " Hz\n"
         << "Channels: " << header.channels << "\n"
         << "Bits per sample: " << header.bits_per_sample << std::endl;
 
-    // Reading audio data
+    // Reading audio data: normalized float [-1.0, 1.0], converted from the mapped file in one allocation
+    // (if stereo, the second channel is ignored)
     std::vector<float> audio_samples;
-    std::vector<int16_t> audio_samples_int16;
-    int16_t sample16;
-    while (file.read(reinterpret_cast<char*>(&sample16), sizeof(int16_t))) {
-        // Conversion in nor;alized float [-1.0, 1.0]
-        audio_samples.push_back(static_cast<float>(sample16) / 32768.0f);
-        audio_samples_int16.push_back(sample16);
-        // If stereo, the second channel is ignored
-        if (header.channels == 2) {
-            file.seekg(sizeof(int16_t), std::ios_base::cur);
-        }
+    if (!wav_reader.read_all(audio_samples, 0)) {
+        std::cerr << "Error: Could not read the samples of " << filePath << std::endl;
+        return std::vector<Note>();
     }
+    wav_reader.close();
 
 
     std::vector<Note> detected_sequence;
-    if (yin_algo) {
-
-        Yin yin;
-
-        // min buffer length => 1/freq * sample rate
-        // ex: C0 => 1/16.35 Hz = 0,0611620795107034 sec => 0.061162 * 44100 = 2 697 samples
-        // ex: A4 => 1/440 Hz = 0,0022727272727273 sec => 100,22 samples
-        const int window_size = 1000;
-        int16_t audio_buff[window_size];
-
-        printf("About to test how many samples are needed to detect the pitch in a given signal\n");
-        printf("WARNING: this test has an absolute disregard for memory managment, hang tight this could hurt a little...\n");
-        for (int offset = 0; offset < (audio_samples_int16.size() - window_size); offset += window_size) {
-
-            
-            int buffer_length = 100;
-            float pitch = 0;
-
-            std::copy(audio_samples_int16.data() + offset, audio_samples_int16.data() + offset + window_size, audio_buff);
-            while (pitch < 10 && buffer_length < window_size) {
-                Yin_init(&yin, buffer_length, 0.05);
-                pitch = Yin_getPitch(&yin, audio_buff);
-                buffer_length++;
-                //std::cout << "buffer_length" << buffer_length << std::endl;
-            }
-            if (pitch != -1) {
-                //    printf("Pitch is found to be %f with buffer length %i and probabiity %f\n", pitch, buffer_length, Yin_getProbability(&yin));
-                //auto proba = Yin_getProbability(&yin); // TODO: maybe we should filter with proba > 90%
-                Note note = (Note)frequencyToMidiNote(pitch);
-                detected_sequence.push_back(note);
-                std::cout << note_to_string(note) << " ";
-            }
-            else {
-                //std::cout << "pitch not found" << std::endl;
-            }
-
-        }
-    }
-    else {
-        detect_note_sequence(audio_samples, header.sample_rate, detected_sequence, note_length);
-    }
+    detect_note_sequence(audio_samples, header.sample_rate, detected_sequence, note_length, yin_algo, overlap);
 
     return detected_sequence;
 }
@@ -471,45 +451,160 @@ int ArpeggioDetector::audio_detection(const fs::path& dictionary_file, const fs:
     // DETECTION MODE
     RuneDictionary dictionary(dictionary_file);
 
-    std::vector<float> audioData;
+    ArpeggioDetector arpeggio_detector;
+    arpeggio_detector.load_dictionary(dictionary);
+
+    // notes and words are printed as they are decoded: long recordings are never held in memory
+    std::cout << "==== NOTE SEQUENCE ====" << std::endl;
+    bool decoded = arpeggio_detector.stream_words(audio_file, note_length, yin_algo,
+        [&](const Word& word) {
+            std::string word_translation;
+            if (dictionary.get_translation(word.get_hash(), word_translation)) {
+                std::cout << std::endl << "==== DETECTED WORD ==== " << word_translation << std::endl;
+            }
+        },
+        [](Note note) {
+            std::cout << note_to_string(note) << " ";
+        });
+    std::cout << std::endl << std::endl;
 
-    ArpeggioDetector noteDetector;
-    std::vector<Note> detected_sequence = noteDetector.detect_note_sequence(audio_file, note_length, yin_algo);
-    //std::vector<Note> detected_sequence = noteDetector.detect_note_sequence_aubio(audio_file);
+    return decoded ? 0 : 1;
+}
 
-    // detected sequence
-    std::cout << "==== detected_sequence ====" << std::endl;
-    for (size_t i = 0; i < detected_sequence.size(); ++i) {
-        std::cout << note_to_string(detected_sequence[i]) << " ";
+bool ArpeggioDetector::stream_words(const fs::path& audio_file, double note_length, bool yin_algo, const std::function<void(const Word&)>& on_word,
+    const std::function<void(Note)>& on_note, double overlap, bool decimate) {
+    WavReader wav_reader;
+    if (!wav_reader.open(audio_file)) {
+        return false;
+    }
+    const WavInfo& info = wav_reader.get_info();
+
+    // no latency bound: the same words as detect_words on the whole capture
+    ArpeggioStreamConfig config;
+    config.sample_rate = info.sample_rate;
+    config.note_length = note_length;
+    config.yin_algo = yin_algo;
+    config.overlap = overlap;
+    config.decimate = decimate;
+    config.latency = 0.0;
+    ArpeggioStream stream(*this);
+    bool stream_ready = stream.init(config,
+        [&](const TimedWord& timed_word) {
+            if (on_word) {
+                on_word(timed_word.word);
+            }
+        },
+        [&](const TimedNote& timed_note) {
+            if (on_note) {
+                on_note(timed_note.note);
+            }
+        });
+    if (!stream_ready) {
+        return false;
     }
-    std::cout << std::endl << std::endl;
 
-    auto note_sequence = noteDetector.get_clean_sequence(detected_sequence);
+    // first channel, like detect_note_sequence
+    std::vector<float> block(AUDIO_STREAM_BLOCK_FRAMES);
+    for (size_t first_frame = 0; first_frame < info.nb_frames; ) {
+        size_t nb_requested = (std::min)(block.size(), info.nb_frames - first_frame);
+        size_t nb_read = wav_reader.read(block.data(), first_frame, nb_requested, 0);
+        if (nb_read != nb_requested) {
+            std::cerr << "Error: Could not read frames " << first_frame << " to " << first_frame + nb_requested << " of " << audio_file << std::endl;
+            return false;
+        }
+        stream.push(block.data(), nb_read);
+        first_frame += nb_read;
+    }
+    stream.flush();
+    return true;
+}
 
-    // Afficher la séquence nettoyee
-    std::cout << "==== NOTE SEQUENCE ====" << std::endl;
-    for (size_t i = 0; i < note_sequence.size(); ++i) {
-        std::cout << note_to_string(note_sequence[i]) << " ";
+bool NoteSegmenter::push(Note note, Note& segmented_note) {
+    if (note == m_last_note || note == Note::SILENCE || note == Note::UNKNOWN) {
+        return false;
     }
-    std::cout << std::endl << std::endl;
+    m_last_note = note;
+    segmented_note = note;
+    return true;
+}
 
-    ArpeggioDetector arpeggio_detector;
-    arpeggio_detector.load_dictionary(dictionary);
+// Longest range of detect_words from a begin note, with the notes at hand
+size_t WordMatcher::find_word(size_t begin, Word& word) const {
+    const size_t max_length = static_cast<size_t>(std::max(0, m_detector.get_arpeggio_max_length()));
+    const size_t min_length = static_cast<size_t>(std::max(0, m_detector.get_arpeggio_min_length()));
+    size_t distance_to_end = m_notes.size() - begin;
+    size_t range_end_start = distance_to_end > max_length ? begin + max_length : m_notes.size() - 1;
+    for (size_t range_end = range_end_start; range_end > begin; --range_end) {
+        if (range_end - begin + 1 < min_length) {
+            break; // skip if the range is too short
+        }
+        std::vector<Note> note_range(m_notes.begin() + begin, m_notes.begin() + range_end + 1);
+        word = m_detector.find(ArpeggioDetector::get_indexed_note_sequence(note_range));
+        if (word.is_valid()) {
+            return range_end;
+        }
+    }
+    return begin;
+}
 
-    std::vector<Word> words;
-    bool detecttion_res = arpeggio_detector.detect_words(note_sequence, words);
-
-    //result = dictionary.translate(note_sequence);
-    std::cout << std::endl;
-    std::cout << "==== DETECTED WORDS ==== " << std::endl << result << std::endl << std::endl;
-    for (const auto& word : words) {
-        auto word_hash = word.get_hash();
-        std::string word_translation;
-        if (dictionary.get_translation(word_hash, word_translation)) {
-            std::cout << word_translation << " ";
+// One step of detect_words with the first pending note as range begin
+void WordMatcher::match_front(std::vector<WordMatch>& matches) {
+    size_t next_begin = 1;
+    WordMatch match;
+    size_t range_end = find_word(0, match.word);
+    if (range_end > 0) {
+        match.first_note = m_first_note;
+        match.last_note = m_first_note + range_end;
+        matches.push_back(match);
+        next_begin = range_end; // keep the last note in case it is used as the first note of the next arpeggio
+    }
+    m_notes.erase(m_notes.begin(), m_notes.begin() + next_begin);
+    m_first_note += next_begin;
+}
+
+bool WordMatcher::find_candidate(WordMatch& candidate) const {
+    for (size_t begin = 0; begin + 1 < m_notes.size(); begin++) {
+        size_t range_end = find_word(begin, candidate.word);
+        if (range_end > begin) {
+            candidate.first_note = m_first_note + begin;
+            candidate.last_note = m_first_note + range_end;
+            return true;
         }
     }
-    std::cout << std::endl << std::endl;
+    return false;
+}
+
+void WordMatcher::push(Note note, std::vector<WordMatch>& matches) {
+    m_notes.push_back(note);
+    // same ranges as on the whole sequence once max_length notes follow the begin
+    while (m_notes.size() > static_cast<size_t>(std::max(0, m_detector.get_arpeggio_max_length()))) {
+        match_front(matches);
+    }
+}
+
+void WordMatcher::push(Note note, std::vector<Word>& words) {
+    std::vector<WordMatch> matches;
+    push(note, matches);
+    for (const auto& match : matches) {
+        words.push_back(match.word);
+    }
+}
 
-    return 0;
-}
\ No newline at end of file
+void WordMatcher::finish(std::vector<WordMatch>& matches) {
+    while (!m_notes.empty()) {
+        match_front(matches);
+    }
+}
+
+void WordMatcher::finish(std::vector<Word>& words) {
+    std::vector<WordMatch> matches;
+    finish(matches);
+    for (const auto& match : matches) {
+        words.push_back(match.word);
+    }
+}
+
+void WordMatcher::reset() {
+    m_notes.clear();
+    m_first_note = 0;
+}
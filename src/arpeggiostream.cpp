@@ -0,0 +1,162 @@
+#include "arpeggiostream.h"
+
+#include <algorithm>
+#include <iostream>
+
+bool ArpeggioStream::init(const ArpeggioStreamConfig& config, const std::function<void(const TimedWord&)>& on_word,
+    const std::function<void(const TimedNote&)>& on_note)
+{
+    if (config.sample_rate == 0 || config.latency < 0.0) {
+        std::cerr << "Error: Invalid stream configuration (sample rate " << config.sample_rate << " Hz, latency " << config.latency << " ms)." << std::endl;
+        return false;
+    }
+    // FFT sizes and YIN windows follow the analysis rate: a decimated rate cuts their cost by the same factor
+    uint32_t analysis_rate = config.analysis_rate > 0 ? config.analysis_rate : config.sample_rate;
+    if (config.decimate) {
+        double min_rate = 2 * ARPEGGIO_STREAM_MAX_FREQUENCY / RESAMPLER_PASSBAND;
+        if (config.yin_algo) {
+            min_rate = (std::max)(min_rate, YIN_MIN_PERIOD * ARPEGGIO_STREAM_MAX_FREQUENCY);
+        }
+        analysis_rate = PolyphaseResampler::get_decimated_rate(analysis_rate, min_rate);
+    }
+    m_resampler = PolyphaseResampler();
+    if (analysis_rate != config.sample_rate && !m_resampler.init(config.sample_rate, analysis_rate)) {
+        return false;
+    }
+    if (!m_detector.init_frame_analysis(analysis_rate, config.note_length, config.yin_algo, config.overlap, m_stft, m_yin)) {
+        return false;
+    }
+    m_yin.set_parabolic_threshold(analysis_rate < config.sample_rate);
+    m_analysis_rate = analysis_rate;
+    m_config = config;
+    m_on_word = on_word;
+    m_on_note = on_note;
+    m_converted.resize(ARPEGGIO_STREAM_CONVERT_FRAMES);
+    reset();
+    return true;
+}
+
+void ArpeggioStream::reset()
+{
+    if (m_resampler.is_valid()) {
+        m_resampler.reset();
+    }
+    m_stft.reset();
+    m_quantizer.set_tuning(0.0);
+    m_tuning_estimator.reset();
+    m_segmenter.reset();
+    m_matcher.reset();
+    m_notes.clear();
+    m_first_timed_note = 0;
+    m_matches.clear();
+    m_has_candidate = false;
+    m_nb_samples = 0;
+    m_nb_words = 0;
+}
+
+size_t ArpeggioStream::push(const float* samples, size_t count)
+{
+    if (!is_valid()) {
+        return 0;
+    }
+    size_t nb_words_before = m_nb_words;
+    m_nb_samples += count;
+    if (m_resampler.is_valid()) {
+        m_resampler.process(samples, count, m_resampled);
+        samples = m_resampled.data();
+        count = m_resampled.size();
+    }
+    m_stft.push(samples, count, [&](const StftFrame& frame) { process_frame(frame); });
+    return m_nb_words - nb_words_before;
+}
+
+size_t ArpeggioStream::push(const int16_t* samples, size_t count)
+{
+    size_t nb_words = 0;
+    for (size_t done = 0; done < count; ) {
+        size_t block = (std::min)(count - done, m_converted.size());
+        for (size_t i = 0; i < block; i++) {
+            m_converted[i] = samples[done + i] * (1.0f / 32768.0f);
+        }
+        nb_words += push(m_converted.data(), block);
+        done += block;
+    }
+    return nb_words;
+}
+
+size_t ArpeggioStream::flush()
+{
+    size_t nb_words_before = m_nb_words;
+    m_matcher.finish(m_matches);
+    emit_matches(get_time());
+    m_has_candidate = false;
+    return m_nb_words - nb_words_before;
+}
+
+void ArpeggioStream::process_frame(const StftFrame& frame)
+{
+    // the frame is complete once its last sample is pushed, its content is late by the resampler filter delay
+    double now = (double)(frame.start + m_stft.get_window_size()) / m_analysis_rate;
+    double delay = get_delay();
+    double pitch = m_detector.get_frame_pitch(frame, m_stft, m_config.yin_algo ? &m_yin : nullptr, m_analysis_rate);
+    double tuning = 0.0;
+    if (m_config.estimate_tuning && pitch >= SILENCE_TONE_THRESHOLD) {
+        m_tuning_estimator.add(pitch);
+        if (m_tuning_estimator.estimate(tuning)) {
+            m_quantizer.set_tuning(tuning);
+        }
+    }
+    Note note = ArpeggioDetector::get_pitch_note(pitch, m_quantizer);
+    Note segmented_note;
+    if (m_segmenter.push(note, segmented_note)) {
+        TimedNote timed_note;
+        timed_note.note = segmented_note;
+        timed_note.start = (std::max)(0.0, (double)frame.start / m_analysis_rate - delay);
+        timed_note.detected = (std::max)(0.0, now - delay);
+        m_notes.push_back(timed_note);
+        if (m_on_note) {
+            m_on_note(timed_note);
+        }
+        m_matcher.push(segmented_note, m_matches);
+        emit_matches(now);
+        if (m_config.latency > 0.0) {
+            m_has_candidate = m_matcher.find_candidate(m_candidate);
+        }
+    }
+    apply_latency(now);
+}
+
+// The candidate has waited long enough for a longer match (in signal time, like the note times): the notes before it
+// start no word with the notes at hand and are dropped, then it is decided
+void ArpeggioStream::apply_latency(double now)
+{
+    while (m_has_candidate && (now - get_delay() - get_note(m_candidate.last_note).detected) * 1000.0 >= m_config.latency) {
+        while (m_matcher.get_first_pending_note() <= m_candidate.first_note) {
+            m_matcher.decide_front(m_matches);
+        }
+        emit_matches(now);
+        m_has_candidate = m_matcher.find_candidate(m_candidate);
+    }
+}
+
+void ArpeggioStream::emit_matches(double now)
+{
+    for (const auto& match : m_matches) {
+        TimedWord timed_word;
+        timed_word.word = match.word;
+        timed_word.start = get_note(match.first_note).start;
+        timed_word.end = get_note(match.last_note).detected;
+        timed_word.decided = now;
+        m_nb_words++;
+        if (m_on_word) {
+            m_on_word(timed_word);
+        }
+    }
+    m_matches.clear();
+
+    // the matcher keeps the last note of a word
+    while (m_first_timed_note < m_matcher.get_first_pending_note()) {
+        m_notes.pop_front();
+        m_first_timed_note++;
+    }
+}
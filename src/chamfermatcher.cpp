@@ -0,0 +1,111 @@
+#include "chamfermatcher.h"
+
+#include <iostream>
+#include <algorithm>
+#include <opencv2/imgproc.hpp>
+#include "toolbox.h"
+
+bool ChamferMatcher::set_image(const cv::Mat& image)
+{
+	cv::Mat ink;
+	if (!make_ink_mask(image, ink)) {
+		return false;
+	}
+	ink.convertTo(m_ink, CV_32F, 1.0 / 255.0);
+
+	// distance of every pixel to the nearest ink pixel (ink pixels are the zeros of the inverted mask)
+	cv::Mat background;
+	cv::bitwise_not(ink, background);
+	cv::distanceTransform(background, m_distance, cv::DIST_L2, cv::DIST_MASK_3);
+	return true;
+}
+
+void ChamferMatcher::erase(const cv::Rect& zone)
+{
+	if (!is_ready()) {
+		return;
+	}
+	cv::Rect image_zone = zone & cv::Rect(0, 0, m_ink.cols, m_ink.rows);
+	m_ink(image_zone).setTo(0.0f);
+	// the distances are truncated when matching, any large value means "no ink around"
+	// (the distances just outside the zone are not updated, they can only be pessimistic)
+	m_distance(image_zone).setTo((float)(m_ink.rows + m_ink.cols));
+}
+
+bool ChamferMatcher::match(const ChamferTemplate& pattern, const cv::Rect& search_roi, cv::Mat& result) const
+{
+	if (!is_ready() || pattern.skeleton_points.empty()) {
+		return false;
+	}
+	cv::Rect roi = search_roi & cv::Rect(0, 0, m_distance.cols, m_distance.rows);
+	int result_cols = roi.width - pattern.size.width + 1;
+	int result_rows = roi.height - pattern.size.height + 1;
+	if (result_cols <= 0 || result_rows <= 0) {
+		return false;
+	}
+
+	// one shifted view of the truncated distance map per skeleton point: the cost only depends on the number of points
+	cv::Mat truncated_distance = cv::min(m_distance(roi), pattern.truncation);
+	cv::Mat distance_sum = cv::Mat::zeros(result_rows, result_cols, CV_32F);
+	for (const auto& point : pattern.skeleton_points) {
+		distance_sum += truncated_distance(cv::Rect(point.x, point.y, result_cols, result_rows));
+	}
+	distance_sum.convertTo(result, CV_32F, -1.0 / (pattern.truncation * pattern.skeleton_points.size()), 1.0);
+
+	// the background around the strokes must be free of ink (filled areas are close to every skeleton point)
+	if (!pattern.background_points.empty()) {
+		cv::Mat ink = m_ink(roi);
+		cv::Mat ink_sum = cv::Mat::zeros(result_rows, result_cols, CV_32F);
+		for (const auto& point : pattern.background_points) {
+			ink_sum += ink(cv::Rect(point.x, point.y, result_cols, result_rows));
+		}
+		cv::Mat background_score;
+		ink_sum.convertTo(background_score, CV_32F, -1.0 / (CHAMFER_MAX_BACKGROUND_INK * pattern.background_points.size()), 1.0);
+		background_score = cv::max(background_score, 0.0f);
+		result = result.mul(background_score);
+	}
+	return true;
+}
+
+// The template is drawn like the correlation templates (see Word::generate_image), the center lines are drawn
+// with a one pixel tickness in the same frame
+bool ChamferMatcher::make_template(const Word& word, double scale_factor, ChamferTemplate& pattern)
+{
+	pattern = ChamferTemplate();
+	if (!word.is_valid()) {
+		return false;
+	}
+
+	cv::Size2i rune_size = RUNE_DEFAULT_SIZE * scale_factor;
+	double tickness = (std::max)(1.0, RUNE_SEGMENT_DRAW_DEFAULT_TICKNESS * RUNE_DEFAULT_SIZE.height * scale_factor);
+	cv::Mat word_image;
+	if (rune_size.width <= 0 || rune_size.height <= 0 || !word.generate_image(rune_size, tickness, word_image)) {
+		return false;
+	}
+	pattern.size = word_image.size();
+	pattern.truncation = (std::max)(2.0, CHAMFER_TRUNCATION * pattern.size.height);
+
+	cv::Mat skeleton_image = cv::Mat::zeros(word_image.size(), CV_8U);
+	int rune_x = (int)tickness;
+	for (const auto& rune : word.get_runes()) {
+		rune.generate_image(rune_x, (int)tickness, rune_size, 1, skeleton_image);
+		rune_x += rune_size.width;
+	}
+	cv::findNonZero(skeleton_image, pattern.skeleton_points);
+
+	// background: a grid of points in a band along the strokes, far enough from the (anti aliased) strokes to accept
+	// thicker real strokes. The band keeps the number of points (the match cost) proportional to the stroke length
+	cv::Mat strokes, stroke_distance;
+	cv::threshold(word_image, strokes, 0, 255, cv::THRESH_BINARY_INV);
+	cv::distanceTransform(strokes, stroke_distance, cv::DIST_L2, cv::DIST_MASK_3);
+	int step = (std::max)(1, (int)std::round(0.5 * tickness));
+	for (int y = 0; y < stroke_distance.rows; y += step) {
+		const float* distances = stroke_distance.ptr<float>(y);
+		for (int x = 0; x < stroke_distance.cols; x += step) {
+			if (distances[x] >= CHAMFER_BACKGROUND_DISTANCE * tickness && distances[x] <= CHAMFER_BACKGROUND_BAND * tickness) {
+				pattern.background_points.push_back(cv::Point(x, y));
+			}
+		}
+	}
+	return !pattern.skeleton_points.empty();
+}
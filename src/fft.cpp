@@ -0,0 +1,158 @@
+#include "fft.h"
+
+#include <cmath>
+#include <iostream>
+#include <numbers>
+#include <utility>
+
+template<typename T>
+size_t FftPlan<T>::next_power_of_two(size_t n)
+{
+    size_t power = 1;
+    while (power < n) {
+        power <<= 1;
+    }
+    return power;
+}
+
+template<typename T>
+bool FftPlan<T>::init(size_t size)
+{
+    m_size = 0;
+    m_log2_size = 0;
+    m_bit_reverse.clear();
+    m_twiddles.clear();
+    if (size == 0 || (size & (size - 1)) != 0 || size > (size_t(1) << 31)) {
+        std::cerr << "Error: FFT size must be a power of two, got " << size << std::endl;
+        return false;
+    }
+
+    while ((size_t(1) << m_log2_size) < size) {
+        m_log2_size++;
+    }
+    m_bit_reverse.resize(size);
+    for (size_t i = 0; i < size; i++) {
+        uint32_t reversed = 0;
+        for (int bit = 0; bit < m_log2_size; bit++) {
+            reversed |= ((i >> bit) & 1u) << (m_log2_size - 1 - bit);
+        }
+        m_bit_reverse[i] = reversed;
+    }
+    // computed in double whatever the precision of the plan
+    m_twiddles.resize(size / 2);
+    for (size_t k = 0; k < size / 2; k++) {
+        double angle = -2.0 * std::numbers::pi * k / size;
+        m_twiddles[k] = Complex((T)std::cos(angle), (T)std::sin(angle));
+    }
+    m_size = size;
+    return true;
+}
+
+// n is size() or size() / 2: the half size transform uses every other twiddle and the bit reversal without its lowest bit
+template<typename T>
+void FftPlan<T>::transform(Complex* data, size_t n, bool inverse) const
+{
+    int shift = n == m_size ? 0 : 1;
+    for (size_t i = 0; i < n; i++) {
+        size_t j = m_bit_reverse[i] >> shift;
+        if (i < j) {
+            std::swap(data[i], data[j]);
+        }
+    }
+
+    for (size_t length = 2; length <= n; length <<= 1) {
+        size_t half = length / 2;
+        size_t twiddle_step = m_size / length;
+        for (size_t start = 0; start < n; start += length) {
+            Complex* even = data + start;
+            Complex* odd = even + half;
+            for (size_t j = 0; j < half; j++) {
+                Complex w = m_twiddles[j * twiddle_step];
+                if (inverse) {
+                    w = std::conj(w);
+                }
+                Complex product = odd[j] * w;
+                odd[j] = even[j] - product;
+                even[j] += product;
+            }
+        }
+    }
+
+    if (inverse) {
+        T scale = T(1) / (T)n;
+        for (size_t i = 0; i < n; i++) {
+            data[i] *= scale;
+        }
+    }
+}
+
+template<typename T>
+void FftPlan<T>::forward(Complex* data) const
+{
+    transform(data, m_size, false);
+}
+
+template<typename T>
+void FftPlan<T>::inverse(Complex* data) const
+{
+    transform(data, m_size, true);
+}
+
+// z[k] = x[2k] + i x[2k + 1] is transformed in the spectrum buffer, then the bins k and m - k are split in place:
+// X[k] = E[k] + W^k O[k] with E = (Z[k] + conj(Z[m - k])) / 2 and O = (Z[k] - conj(Z[m - k])) / 2i
+template<typename T>
+void FftPlan<T>::forward_real(const T* input, Complex* spectrum) const
+{
+    if (m_size < 2) {
+        if (m_size == 1) {
+            spectrum[0] = Complex(input[0], 0);
+        }
+        return;
+    }
+    size_t m = m_size / 2;
+    for (size_t k = 0; k < m; k++) {
+        spectrum[k] = Complex(input[2 * k], input[2 * k + 1]);
+    }
+    transform(spectrum, m, false);
+
+    Complex z0 = spectrum[0];
+    spectrum[0] = Complex(z0.real() + z0.imag(), 0);
+    spectrum[m] = Complex(z0.real() - z0.imag(), 0);
+    const Complex half_i(0, T(0.5));
+    for (size_t k = 1; k <= m / 2; k++) {
+        Complex zk = spectrum[k];
+        Complex zmk = spectrum[m - k];
+        Complex even = T(0.5) * (zk + std::conj(zmk));
+        Complex odd = -half_i * (zk - std::conj(zmk));
+        Complex even_mirror = T(0.5) * (zmk + std::conj(zk));
+        Complex odd_mirror = -half_i * (zmk - std::conj(zk));
+        spectrum[k] = even + m_twiddles[k] * odd;
+        spectrum[m - k] = even_mirror + m_twiddles[m - k] * odd_mirror;
+    }
+}
+
+// inverse of forward_real: Z[k] = E[k] + i O[k] is rebuilt in the output buffer (viewed as m complex values)
+template<typename T>
+void FftPlan<T>::inverse_real(const Complex* spectrum, T* output) const
+{
+    if (m_size < 2) {
+        if (m_size == 1) {
+            output[0] = spectrum[0].real();
+        }
+        return;
+    }
+    size_t m = m_size / 2;
+    Complex* z = reinterpret_cast<Complex*>(output);
+    const Complex i_unit(0, 1);
+    for (size_t k = 0; k < m; k++) {
+        Complex xk = spectrum[k];
+        Complex xmk = std::conj(spectrum[m - k]);
+        Complex even = T(0.5) * (xk + xmk);
+        Complex odd = T(0.5) * (xk - xmk) * std::conj(m_twiddles[k]);
+        z[k] = even + i_unit * odd;
+    }
+    transform(z, m, true);
+}
+
+template class FftPlan<float>;
+template class FftPlan<double>;
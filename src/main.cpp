@@ -5,9 +5,13 @@
 #include <queue>
 #include <filesystem>
 #include <string>
+#include <charconv>
+#include <cstring>
 #include "arpeggiodetector.h"
 #include "runedetector.h"
 #include "runedictionary.h"
+#include "runeclassifier.h"
+#include "pagegenerator.h"
 //#include "libtuneic.h"
 namespace fs = std::filesystem;
 
@@ -74,16 +78,109 @@ fs::path getExecutablePath() {
 
 
 const auto RUNES_FOLDER = fs::path("../../../data/runes");
+const auto RUNES_CAPTURES_FOLDER = fs::path("../../../data/runes_captures");
 const auto DICTIONARY_ENG = fs::path("../../../lang/dictionary.eng.txt");
 const auto DICTIONARY_FRA = fs::path("../../../lang/dictionary.fra.txt");
 
+// whole argument as a number (no exception, no trailing characters)
+template <typename T>
+static bool parse_argument(const char* argument, T& value)
+{
+    const char* end = argument + std::strlen(argument);
+    auto [position, error] = std::from_chars(argument, end, value);
+    return error == std::errc() && position == end && position != argument;
+}
+
+static void print_usage(const char* program)
+{
+    std::cerr << "Usage: "
+        << program << " <file.wav> [note_length_millisec=75]>" << std::endl
+        << "       " << program << " --train-rune-classifier|--eval-rune-classifier <model.yml>" << std::endl
+        << "       " << program << " --dictionarize <image> [model.yml]" << std::endl
+        << "       " << program << " --annotate-languages <image> <output folder>" << std::endl
+        << "       " << program << " --generate-pages <dictionary.txt> <output folder> <nb pages> [seed=0]" << std::endl;
+}
+
 int main(int argc, char* argv[]) {
 
     bool yin_algo = true;
 
+    // rune classifier training / evaluation over the labelled rune images (evaluated on the images held out of training)
+    if (argc == 3 && (std::string(argv[1]) == "--train-rune-classifier" || std::string(argv[1]) == "--eval-rune-classifier")) {
+        fs::path model_file = argv[2];
+        std::vector<fs::path> labelled_folders = { RUNES_FOLDER, RUNES_CAPTURES_FOLDER };
+        RuneClassifier rune_classifier;
+        if (std::string(argv[1]) == "--train-rune-classifier") {
+            if (!rune_classifier.train(labelled_folders) || !rune_classifier.save(model_file)) {
+                return 1;
+            }
+        }
+        else if (!rune_classifier.load(model_file)) {
+            return 1;
+        }
+        RuneClassifierReport report;
+        return rune_classifier.evaluate(labelled_folders, report) ? 0 : 1;
+    }
+
+    // new words of a rune page added to the english dictionary, decoded by the trained rune classifier when a model is given
+    if ((argc == 3 || argc == 4) && std::string(argv[1]) == "--dictionarize") {
+        RuneDictionary rune_dictionary(DICTIONARY_ENG);
+        RuneDetector rune_detector(&rune_dictionary);
+        if (argc == 4 && !rune_detector.load_rune_classifier(argv[3])) {
+            return 1;
+        }
+        if (!rune_detector.dictionarize(argv[2])) {
+            return 1;
+        }
+        return rune_dictionary.save(DICTIONARY_ENG) ? 0 : 1;
+    }
+
+    // synthetic rune pages with their JSON ground truth, for the detection benchmarks
+    if (argc >= 5 && std::string(argv[1]) == "--generate-pages") {
+        int nb_pages = 0;
+        unsigned int seed = 0;
+        if (argc > 6 || !parse_argument(argv[4], nb_pages) || nb_pages <= 0 || (argc == 6 && !parse_argument(argv[5], seed))) {
+            std::cerr << "Error: Invalid number of pages or seed." << std::endl;
+            print_usage(argv[0]);
+            return 1;
+        }
+        SyntheticPageGenerator page_generator(PageGeneratorOptions(), seed);
+        if (!page_generator.load_dictionary(argv[2])) {
+            return 1;
+        }
+        return page_generator.generate_corpus(argv[3], nb_pages) ? 0 : 1;
+    }
+
+    // one detection, one annotated page per dictionary of the lang folder
+    if (argc == 4 && std::string(argv[1]) == "--annotate-languages") {
+        fs::path image_file = argv[2];
+        cv::Mat page;
+        // annotated pages keep the colors of the capture (matched in gray)
+        if (!load_color_image(image_file, page, MAX_IMAGE_DETECTION_DIMENSIONS)) {
+            std::cerr << "Error: Could not load rune image from " << image_file << std::endl;
+            return 1;
+        }
+        RuneDictionary rune_dictionary(DICTIONARY_ENG);
+        RuneDetector rune_detector(&rune_dictionary);
+        rune_detector.load_rune_folder(RUNES_FOLDER);
+        DetectionOptions options = rune_detector.get_detection_options();
+        options.deskew = false; // the zones are drawn on the page as loaded
+        rune_detector.set_detection_options(options);
+        DetectionResult detection_result;
+        cv::Mat detection_image = page.clone();
+        rune_detector.detect_words(detection_image, detection_result, DetectionBudget(), 7, false, true);
+
+        std::vector<fs::path> dictionary_files, output_files;
+        for (const auto& entry : fs::directory_iterator(DICTIONARY_ENG.parent_path())) {
+            if (entry.path().extension() == ".txt" && entry.path().stem().string().rfind("dictionary.", 0) == 0) {
+                dictionary_files.push_back(entry.path());
+            }
+        }
+        return rune_detector.annotate_languages(page, detection_result.zones, dictionary_files, argv[3], image_file.stem().string(), output_files) ? 0 : 1;
+    }
+
     if (argc != 2 && argc != 3) {
-        std::cerr << "Usage: "
-            << argv[0] << " <file.wav> [note_length_millisec=75]>" << std::endl;
+        print_usage(argv[0]);
         return 1;
     }
 
@@ -0,0 +1,82 @@
+#include "notequantizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+QuantizedNote NoteQuantizer::quantize(double frequency) const
+{
+    QuantizedNote quantized;
+    quantized.frequency = frequency;
+    if (!(frequency > 0.0)) {
+        return quantized;
+    }
+    double midi = 69.0 + 12.0 * std::log2(frequency / NOTE_REFERENCE_FREQUENCY) - m_tuning / 100.0;
+    double nearest = std::round(midi);
+    quantized.cents = 100.0 * (midi - nearest);
+    if (nearest < (double)Note::C0 || nearest > (double)Note::B8 || std::abs(quantized.cents) > m_tolerance) {
+        return quantized;
+    }
+    quantized.note = static_cast<Note>(static_cast<int>(nearest));
+    quantized.confidence = m_tolerance > 0.0 ? (std::max)(0.0, 1.0 - std::abs(quantized.cents) / m_tolerance) : 1.0;
+    return quantized;
+}
+
+double TuningEstimator::get_deviation(double frequency)
+{
+    double midi = 12.0 * std::log2(frequency / NOTE_REFERENCE_FREQUENCY);
+    double deviation = 100.0 * (midi - std::floor(midi + 0.5));
+    return deviation >= 50.0 ? deviation - 100.0 : deviation;
+}
+
+void TuningEstimator::add(double frequency, double weight)
+{
+    if (!(frequency > 0.0) || !(weight > 0.0)) {
+        return;
+    }
+    size_t bin = static_cast<size_t>(std::floor(get_deviation(frequency) + 50.0));
+    m_histogram[(std::min)(bin, TUNING_HISTOGRAM_BINS - 1)] += weight;
+    m_nb_observations++;
+}
+
+bool TuningEstimator::estimate(double& cents) const
+{
+    if (m_nb_observations < TUNING_MIN_OBSERVATIONS) {
+        return false;
+    }
+    const int nb_bins = static_cast<int>(TUNING_HISTOGRAM_BINS);
+
+    // peak of the histogram summed over the peak width, wrapping around the semitone
+    int peak = 0;
+    double peak_sum = -1.0;
+    for (int bin = 0; bin < nb_bins; bin++) {
+        double sum = 0.0;
+        for (int offset = -TUNING_PEAK_WIDTH; offset <= TUNING_PEAK_WIDTH; offset++) {
+            sum += m_histogram[(bin + offset + nb_bins) % nb_bins];
+        }
+        if (sum > peak_sum) {
+            peak_sum = sum;
+            peak = bin;
+        }
+    }
+
+    // circular mean of the bin centers around the peak (one turn per semitone)
+    double x = 0.0, y = 0.0;
+    for (int offset = -TUNING_PEAK_WIDTH; offset <= TUNING_PEAK_WIDTH; offset++) {
+        int bin = (peak + offset + nb_bins) % nb_bins;
+        double angle = 2 * std::numbers::pi * (bin - 50 + 0.5) / nb_bins;
+        x += m_histogram[bin] * std::cos(angle);
+        y += m_histogram[bin] * std::sin(angle);
+    }
+    if (x == 0.0 && y == 0.0) {
+        return false;
+    }
+    cents = std::atan2(y, x) * nb_bins / (2 * std::numbers::pi);
+    return true;
+}
+
+void TuningEstimator::reset()
+{
+    m_histogram.fill(0.0);
+    m_nb_observations = 0;
+}
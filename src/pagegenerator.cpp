@@ -0,0 +1,279 @@
+#include "pagegenerator.h"
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+SyntheticPageGenerator::SyntheticPageGenerator(const PageGeneratorOptions& options, unsigned int seed)
+	: m_options(options), m_rng(seed)
+{
+	for (const auto& background_file : m_options.background_images) {
+		cv::Mat background = cv::imread(background_file.string(), cv::IMREAD_COLOR_BGR);
+		if (background.empty()) {
+			std::cerr << "Error: Could not load background image " << background_file << std::endl;
+			continue;
+		}
+		m_backgrounds.push_back(background);
+	}
+}
+
+double SyntheticPageGenerator::uniform(double min_value, double max_value)
+{
+	return std::uniform_real_distribution<double>(min_value, max_value)(m_rng);
+}
+
+int SyntheticPageGenerator::uniform_int(int min_value, int max_value)
+{
+	return std::uniform_int_distribution<int>(min_value, (std::max)(min_value, max_value))(m_rng);
+}
+
+bool SyntheticPageGenerator::load_dictionary(const fs::path& dictionary_file)
+{
+	RuneDictionary dictionary;
+	if (!dictionary.load(dictionary_file)) {
+		return false;
+	}
+	std::vector<std::string> hash_list;
+	dictionary.get_hash_list(hash_list);
+	m_words.clear();
+	for (const auto& hash : hash_list) {
+		std::string translation;
+		if (Word(hash).is_valid() && dictionary.get_translation(hash, translation)) {
+			m_words.push_back({ hash, translation });
+		}
+	}
+	if (m_words.empty()) {
+		std::cerr << "Error: No word to draw in dictionary " << dictionary_file << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool SyntheticPageGenerator::generate_page(GeneratedPage& page)
+{
+	page = GeneratedPage();
+	if (m_words.empty()) {
+		std::cerr << "Error: Load a dictionary before generating pages." << std::endl;
+		return false;
+	}
+	const cv::Size page_size = m_options.page_size;
+
+	// background
+	if (!m_backgrounds.empty()) {
+		int background_index = uniform_int(0, (int)m_backgrounds.size() - 1);
+		cv::resize(m_backgrounds[background_index], page.image, page_size, 0, 0, cv::INTER_AREA);
+		page.background = m_options.background_images[background_index].string();
+	}
+	else {
+		page.image = cv::Mat(page_size, CV_8UC3, m_options.background_color);
+	}
+
+	// one rune size per page, like a game screen
+	page.scale_factor = uniform(m_options.min_scale_factor, m_options.max_scale_factor);
+	cv::Size2i rune_size = RUNE_DEFAULT_SIZE * page.scale_factor;
+	page.tickness = (std::max)(1.0, uniform(m_options.min_tickness, m_options.max_tickness) * rune_size.height);
+	if (rune_size.width <= 0 || rune_size.height <= 0) {
+		std::cerr << "Error: Invalid rune size for the page generator." << std::endl;
+		return false;
+	}
+
+	// sentences written left to right, line after line, until the page is full
+	int margin_x = (int)(m_options.margin * page_size.width);
+	int margin_y = (int)(m_options.margin * page_size.height);
+	int word_spacing = (int)(m_options.word_spacing * rune_size.width);
+	int line_height = (int)(rune_size.height + 2 * page.tickness + m_options.line_spacing * rune_size.height);
+	int x = margin_x;
+	int y = margin_y;
+	int line = 0;
+	int sentence_words = 0;
+	int nb_failures = 0;
+	cv::Mat ink(page_size, CV_8U, cv::Scalar(0));
+	while (y + line_height <= page_size.height - margin_y && nb_failures < 100) {
+		if (sentence_words == 0) {
+			sentence_words = uniform_int(m_options.min_sentence_words, m_options.max_sentence_words);
+		}
+		const auto& [hash, translation] = m_words[uniform_int(0, (int)m_words.size() - 1)];
+		cv::Mat word_image;
+		if (!Word(hash).generate_image(rune_size, page.tickness, word_image)) {
+			nb_failures++;
+			continue;
+		}
+		if (word_image.cols > page_size.width - 2 * margin_x) {
+			// longer than a line
+			nb_failures++;
+			continue;
+		}
+		if (x + word_image.cols > page_size.width - margin_x) {
+			x = margin_x;
+			y += line_height;
+			line++;
+			continue;
+		}
+
+		cv::Rect rect(x, y, word_image.cols, word_image.rows);
+		cv::Mat word_ink = ink(rect);
+		cv::max(word_ink, word_image, word_ink);
+		GeneratedWord generated_word;
+		generated_word.hash = hash;
+		generated_word.translation = translation;
+		generated_word.line = line;
+		generated_word.rect = rect;
+		page.words.push_back(generated_word);
+
+		x += word_image.cols + word_spacing;
+		if (--sentence_words == 0) {
+			// sentences end with a wider space
+			x += word_spacing;
+		}
+	}
+
+	// ink blended over the background (the anti aliased strokes keep their soft borders)
+	cv::Mat ink_alpha, ink_alpha_bgr, ink_layer;
+	ink.convertTo(ink_alpha, CV_32F, 1.0 / 255.0);
+	cv::cvtColor(ink_alpha, ink_alpha_bgr, cv::COLOR_GRAY2BGR);
+	cv::Mat page_float;
+	page.image.convertTo(page_float, CV_32FC3);
+	ink_layer = cv::Mat(page_size, CV_32FC3, m_options.ink_color);
+	page_float = page_float.mul(cv::Scalar(1.0, 1.0, 1.0) - ink_alpha_bgr) + ink_layer.mul(ink_alpha_bgr);
+
+	// degradations
+	page.rotation = m_options.max_rotation > 0.0 ? uniform(-m_options.max_rotation, m_options.max_rotation) : 0.0;
+	cv::Mat rotation = cv::getRotationMatrix2D(cv::Point2f(0.5f * page_size.width, 0.5f * page_size.height), page.rotation, 1.0);
+	if (page.rotation != 0.0) {
+		cv::warpAffine(page_float, page_float, rotation, page_size, cv::INTER_LINEAR, cv::BORDER_REPLICATE);
+	}
+	cv::Rect page_rect(cv::Point(0, 0), page_size);
+	for (auto& word : page.words) {
+		std::vector<cv::Point2f> corners = {
+			cv::Point2f((float)word.rect.x, (float)word.rect.y),
+			cv::Point2f((float)(word.rect.x + word.rect.width), (float)word.rect.y),
+			cv::Point2f((float)(word.rect.x + word.rect.width), (float)(word.rect.y + word.rect.height)),
+			cv::Point2f((float)word.rect.x, (float)(word.rect.y + word.rect.height))
+		};
+		cv::transform(corners, word.corners, rotation);
+		word.rect = cv::boundingRect(word.corners) & page_rect;
+	}
+	if (m_options.blur_kernel_size > 1) {
+		int kernel_size = m_options.blur_kernel_size | 1;
+		cv::GaussianBlur(page_float, page_float, cv::Size(kernel_size, kernel_size), 0);
+	}
+	if (m_options.noise_sigma > 0.0) {
+		cv::Mat noise(page_size, CV_32FC3);
+		cv::randn(noise, cv::Scalar::all(0.0), cv::Scalar::all(m_options.noise_sigma));
+		page_float += noise;
+	}
+	page_float.convertTo(page.image, CV_8UC3);
+	if (m_options.jpeg_quality > 0) {
+		std::vector<uchar> buffer;
+		cv::imencode(".jpg", page.image, buffer, { cv::IMWRITE_JPEG_QUALITY, m_options.jpeg_quality });
+		page.image = cv::imdecode(buffer, cv::IMREAD_COLOR_BGR);
+	}
+	return true;
+}
+
+static std::string json_escape(const std::string& str)
+{
+	std::ostringstream escaped;
+	for (unsigned char c : str) {
+		switch (c) {
+		case '"': escaped << "\\\""; break;
+		case '\\': escaped << "\\\\"; break;
+		case '\n': escaped << "\\n"; break;
+		case '\r': escaped << "\\r"; break;
+		case '\t': escaped << "\\t"; break;
+		default:
+			if (c < 0x20) {
+				escaped << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)c << std::dec;
+			}
+			else {
+				escaped << c;
+			}
+		}
+	}
+	return escaped.str();
+}
+
+bool SyntheticPageGenerator::save_ground_truth(const GeneratedPage& page, const std::string& image_name, const fs::path& json_file)
+{
+	std::ofstream file(json_file);
+	if (!file.is_open()) {
+		std::cerr << "Error: Could not write ground truth file " << json_file << std::endl;
+		return false;
+	}
+	file << "{\n";
+	file << "  \"image\": \"" << json_escape(image_name) << "\",\n";
+	file << "  \"width\": " << page.image.cols << ",\n";
+	file << "  \"height\": " << page.image.rows << ",\n";
+	file << "  \"scale_factor\": " << page.scale_factor << ",\n";
+	file << "  \"tickness\": " << page.tickness << ",\n";
+	file << "  \"rotation\": " << page.rotation << ",\n";
+	file << "  \"background\": \"" << json_escape(page.background) << "\",\n";
+	file << "  \"words\": [";
+	for (size_t i = 0; i < page.words.size(); i++) {
+		const auto& word = page.words[i];
+		file << (i == 0 ? "\n" : ",\n");
+		file << "    { \"hash\": \"" << json_escape(word.hash) << "\", \"translation\": \"" << json_escape(word.translation)
+			<< "\", \"line\": " << word.line
+			<< ", \"rect\": [" << word.rect.x << ", " << word.rect.y << ", " << word.rect.width << ", " << word.rect.height << "]"
+			<< ", \"corners\": [";
+		for (size_t c = 0; c < word.corners.size(); c++) {
+			file << (c == 0 ? "" : ", ") << "[" << word.corners[c].x << ", " << word.corners[c].y << "]";
+		}
+		file << "] }";
+	}
+	file << (page.words.empty() ? "]\n" : "\n  ]\n");
+	file << "}\n";
+	return true;
+}
+
+bool SyntheticPageGenerator::generate_corpus(const fs::path& output_folder, int nb_pages)
+{
+	std::error_code error;
+	fs::create_directories(output_folder, error);
+	if (error) {
+		std::cerr << "Error: Could not create corpus folder " << output_folder << ": " << error.message() << std::endl;
+		return false;
+	}
+	for (int i = 0; i < nb_pages; i++) {
+		std::ostringstream page_name;
+		page_name << "page_" << std::setw(4) << std::setfill('0') << i;
+		GeneratedPage page;
+		if (!generate_page(page)) {
+			return false;
+		}
+		std::string image_name = page_name.str() + ".png";
+		if (!cv::imwrite((output_folder / image_name).string(), page.image) ||
+			!save_ground_truth(page, image_name, output_folder / (page_name.str() + ".json"))) {
+			std::cerr << "Error: Could not save page " << image_name << std::endl;
+			return false;
+		}
+	}
+	std::cout << "Generated " << nb_pages << " pages in " << output_folder << std::endl;
+	return true;
+}
+
+GeneratedPageScore SyntheticPageGenerator::score_detections(const GeneratedPage& page, const std::vector<RuneZone>& zones, double min_iou)
+{
+	GeneratedPageScore score;
+	score.nb_words = (int)page.words.size();
+	score.nb_detections = (int)zones.size();
+	std::vector<bool> found(page.words.size(), false);
+	for (const auto& zone : zones) {
+		std::string hash = zone.word.get_hash();
+		for (size_t i = 0; i < page.words.size(); i++) {
+			const auto& rect = page.words[i].rect;
+			double intersection = (rect & zone.rect).area();
+			double iou = intersection / (rect.area() + zone.rect.area() - intersection);
+			if (!found[i] && iou > min_iou && page.words[i].hash == hash) {
+				found[i] = true;
+				score.nb_matched++;
+				break;
+			}
+		}
+	}
+	return score;
+}
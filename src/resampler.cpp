@@ -0,0 +1,142 @@
+#include "resampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <numbers>
+#include <numeric>
+#include <opencv2/core/utility.hpp>
+#include <opencv2/core/hal/intrin.hpp>
+
+const size_t RESAMPLER_TAP_ALIGNMENT = 8; // taps per branch rounded up for whole vector loops
+
+// Zeroth order modified Bessel function (Kaiser window), power series
+static double bessel_i0(double x)
+{
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 50 && term > 1e-12 * sum; k++) {
+        term *= (x / (2 * k)) * (x / (2 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+static float dot_product(const float* samples, const float* coefficients, size_t count, bool use_simd)
+{
+    size_t i = 0;
+    float sum = 0.0f;
+#if CV_SIMD
+    if (use_simd) {
+        const size_t lanes = cv::VTraits<cv::v_float32>::vlanes();
+        cv::v_float32 sum0 = cv::vx_setzero_f32(), sum1 = cv::vx_setzero_f32();
+        for (; i + 2 * lanes <= count; i += 2 * lanes) {
+            sum0 = cv::v_fma(cv::vx_load(samples + i), cv::vx_load(coefficients + i), sum0);
+            sum1 = cv::v_fma(cv::vx_load(samples + i + lanes), cv::vx_load(coefficients + i + lanes), sum1);
+        }
+        sum = cv::v_reduce_sum(cv::v_add(sum0, sum1));
+    }
+#endif
+    for (; i < count; i++) {
+        sum += samples[i] * coefficients[i];
+    }
+    return sum;
+}
+
+uint32_t PolyphaseResampler::get_decimated_rate(uint32_t input_rate, double min_rate)
+{
+    if (min_rate <= 0.0) {
+        return input_rate;
+    }
+    for (uint32_t factor = static_cast<uint32_t>(input_rate / min_rate); factor > 1; factor--) {
+        if (input_rate % factor == 0) {
+            return input_rate / factor;
+        }
+    }
+    return input_rate;
+}
+
+bool PolyphaseResampler::init(uint32_t input_rate, uint32_t output_rate, double passband, double attenuation)
+{
+    m_up = 0;
+    if (input_rate == 0 || output_rate == 0 || passband <= 0.0 || passband >= 1.0 || attenuation <= 8.0) {
+        std::cerr << "Error: Invalid resampler (" << input_rate << " Hz to " << output_rate << " Hz, pass band " << passband
+            << ", attenuation " << attenuation << " dB)." << std::endl;
+        return false;
+    }
+    uint32_t divisor = std::gcd(input_rate, output_rate);
+    uint32_t up = output_rate / divisor;
+    uint32_t down = input_rate / divisor;
+
+    // Kaiser design at the up sampled rate: flat up to passband * lower Nyquist, attenuated from the lower Nyquist
+    const double upsampled_rate = (double)input_rate * up;
+    const double nyquist = (std::min)(input_rate, output_rate) / 2.0;
+    const double transition = (1.0 - passband) * nyquist / upsampled_rate; // in cycles per sample
+    const double cutoff = (1.0 + passband) / 2.0 * nyquist / upsampled_rate;
+    size_t length = static_cast<size_t>(std::ceil((attenuation - 8.0) / (2.285 * 2 * std::numbers::pi * transition))) + 1;
+    size_t taps_per_phase = (length + up - 1) / up;
+    taps_per_phase = (taps_per_phase + RESAMPLER_TAP_ALIGNMENT - 1) / RESAMPLER_TAP_ALIGNMENT * RESAMPLER_TAP_ALIGNMENT;
+    length = taps_per_phase * up;
+
+    const double beta = attenuation > 50.0 ? 0.1102 * (attenuation - 8.7) : 0.5842 * std::pow(attenuation - 21.0, 0.4) + 0.07886 * (attenuation - 21.0);
+    const double center = (length - 1) / 2.0;
+    std::vector<double> filter(length);
+    double sum = 0.0;
+    for (size_t n = 0; n < length; n++) {
+        double t = n - center;
+        double sinc = t == 0.0 ? 2 * cutoff : std::sin(2 * std::numbers::pi * cutoff * t) / (std::numbers::pi * t);
+        double ratio = t / center;
+        filter[n] = sinc * bessel_i0(beta * std::sqrt((std::max)(0.0, 1.0 - ratio * ratio))) / bessel_i0(beta);
+        sum += filter[n];
+    }
+
+    // unit gain for every branch on average (the up sampled signal has up - 1 zeros for a sample)
+    m_coefficients.resize(length);
+    for (uint32_t phase = 0; phase < up; phase++) {
+        for (size_t j = 0; j < taps_per_phase; j++) {
+            m_coefficients[phase * taps_per_phase + j] = static_cast<float>(filter[phase + (taps_per_phase - 1 - j) * up] * up / sum);
+        }
+    }
+
+    m_input_rate = input_rate;
+    m_output_rate = output_rate;
+    m_up = up;
+    m_down = down;
+    m_taps_per_phase = taps_per_phase;
+    m_delay = center / upsampled_rate;
+    m_use_simd = CV_SIMD && cv::useOptimized();
+    reset();
+    return true;
+}
+
+void PolyphaseResampler::reset()
+{
+    m_buffer.assign(m_taps_per_phase > 0 ? m_taps_per_phase - 1 : 0, 0.0f);
+    m_next_input = 0;
+    m_next_phase = 0;
+}
+
+size_t PolyphaseResampler::process(const float* input, size_t count, std::vector<float>& output)
+{
+    output.clear();
+    if (!is_valid()) {
+        return 0;
+    }
+    const size_t history = m_taps_per_phase - 1;
+    m_buffer.resize(history + count);
+    std::memcpy(m_buffer.data() + history, input, count * sizeof(float));
+
+    // output n is at n * down in the up sampled signal: input n * down / up, branch n * down % up
+    output.reserve(static_cast<size_t>((double)(count + 1) * m_up / m_down) + 1);
+    while (m_next_input < count) {
+        output.push_back(dot_product(m_buffer.data() + m_next_input, m_coefficients.data() + m_next_phase * m_taps_per_phase, m_taps_per_phase, m_use_simd));
+        m_next_phase += m_down;
+        m_next_input += m_next_phase / m_up;
+        m_next_phase %= m_up;
+    }
+    m_next_input -= count;
+
+    std::memmove(m_buffer.data(), m_buffer.data() + count, history * sizeof(float));
+    m_buffer.resize(history);
+    return output.size();
+}
@@ -4,6 +4,7 @@
 #include <string>
 #include <sstream>
 #include <iomanip>
+#include <opencv2/core/utility.hpp>
 #include <opencv2/imgproc.hpp>
 #include <opencv2/highgui.hpp>
 #include <runedetector.h>
@@ -191,20 +192,21 @@ bool Rune::generate_image(int x, int y, cv::Size2i size, double tickness, cv::Ma
 }
 
 
-bool Rune::decode_image(const cv::Mat& rune_image)
+// One rune image (point E on the left border, rune height = image height): a batch of a single cell
+bool Rune::decode_image(const cv::Mat& rune_image, bool debug_mode)
 {
-	const auto RUNE_SEGMENT_DETECTION_THRESHOLD = 0.50; // Threshold for segment detection
-	bool result = true;
-	auto height = rune_image.rows;
-	auto width = rune_image.cols;
 	m_rune = 0;
+	if (rune_image.empty()) {
+		return false;
+	}
 
 	cv::Mat binary_image;
 	cv::threshold(rune_image, binary_image, 100, 255, cv::THRESH_BINARY);
-	cv::imshow("Binary Image (Line Isolated)", binary_image);
-
-	cv::waitKey(1000); // Wait for a key press to close the window
-	cv::destroyAllWindows();
+	if (debug_mode) {
+		cv::imshow("Binary Image (Line Isolated)", binary_image);
+		cv::waitKey(1000); // Wait for a key press to close the window
+		cv::destroyAllWindows();
+	}
 
 	int line_center_y = 0;
 	int tickness = 0;
@@ -213,61 +215,100 @@ bool Rune::decode_image(const cv::Mat& rune_image)
 		return false; // No separator line found
 	}
 
-	// 2. Calculate the origin point for the rune segments based on separator position
-	// point E is the left point of the horizontal separator
-	auto dx = 0 ;
-	auto dy = line_center_y - (0.01 * RUNE_POINT_E.y * height) - (RUNE_SEGMENT_DRAW_DEFAULT_TICKNESS * width);
-
-	// put original image to a bigger one with black background and borders
-	// this is needed to avoid problems with matching the rune segments
-	cv::Mat rune_image_with_borders(2*height, 2*width, CV_8UC1, cv::Scalar(0));
-	cv::Rect paste_zone(0.5 * width + dx, 0.5 * height + dy, width, height);
-
-	rune_image.copyTo(rune_image_with_borders(paste_zone)); // Copy source image into the ROI of the destination
-
-	//cv::imshow("Result using copyTo()", rune_image_with_borders);
-	//cv::waitKey(1000); // Wait for a key press to close the window
+	// the separator goes through point E
+	std::vector<cv::Point2d> origins = { cv::Point2d(0.0, line_center_y - 0.01 * RUNE_POINT_E.y * rune_image.rows) };
+	std::vector<Rune> runes;
+	if (!decode_cells(binary_image, origins, cv::Size2i(rune_image.cols, rune_image.rows), tickness, runes)) {
+		return false;
+	}
+	m_rune = runes[0].m_rune;
+	if (debug_mode) {
+		std::cout << "Decoded rune: " << to_hexa() << std::endl;
+	}
+	return (m_rune != 0);
+}
 
+// Every cell of a rune grid has the same size: the segment masks are drawn once for the batch. The parts of a mask
+// close to another segment or to the separator are left out (ink shared by two segments), a segment is set when
+// RUNE_SEGMENT_DETECTION_THRESHOLD of the rest lies on ink. Closing (kernel following the stroke) only runs in the cells
+bool Rune::decode_cells(const cv::Mat& binary_image, const std::vector<cv::Point2d>& origins, cv::Size2i rune_size, double tickness, std::vector<Rune>& runes)
+{
+	runes.assign(origins.size(), Rune(RUNE_NULL));
+	if (binary_image.empty() || binary_image.type() != CV_8UC1 || rune_size.width <= 0 || rune_size.height <= 0) {
+		std::cerr << "Error: Rune cells are decoded from a binary image with a valid rune size." << std::endl;
+		return false;
+	}
 
- 	for(int shift = 0; shift < 16; ++shift) {
+	// cell = rune layout + the strokes overflowing it
+	int margin = (int)std::ceil(tickness) + 2;
+	cv::Size cell_size(rune_size.width + 2 * margin, rune_size.height + 2 * margin);
 
-		if(shift == 6 || shift == 14) {
+	std::vector<unsigned long> segment_bits;
+	std::vector<cv::Mat> detection_masks, filter_masks;
+	for (int shift = 0; shift < 16; ++shift) {
+		if (shift == 6 || shift == 14) {
 			// no segments for these bits
 			continue;
 		}
-
-		// generate a segment mask (greater tickeness for better detection)
-		cv::Mat rune_filter_mask(2*height, 2*width, CV_8UC1, cv::Scalar(0));
-		cv::Mat rune_detection_mask(2*height, 2*width, CV_8UC1, cv::Scalar(0));
-		unsigned long rune_bit = (0x1 << shift);
-		Rune rune_part = Rune(rune_bit);
-		rune_part.generate_image(0.5 * width, 0.5 * height, cv::Size2i(width, height), RUNE_SEGMENT_DETECTION_FILTER_MASK_TICKNESS* height, rune_filter_mask, false);
-		rune_part.generate_image(0.5 * width, 0.5 * height, cv::Size2i(width, height), RUNE_SEGMENT_DETECTION_DETECTION_MASK_TICKNESS * height, rune_detection_mask, false);
-
-		cv::Mat filtered_result, detection_result;
-		cv::bitwise_and(rune_image_with_borders, rune_filter_mask, filtered_result, rune_filter_mask);
-		cv::bitwise_and(filtered_result, rune_detection_mask, detection_result, rune_detection_mask);
-
-		//int rune_filter_mask_white_pixel_count = cv::countNonZero(rune_filter_mask);
-		int detection_mask_white_pixel_count = cv::countNonZero(rune_detection_mask);
-		int match_white_pixel_count = cv::countNonZero(detection_result);
-		double match = static_cast<double>(match_white_pixel_count) / static_cast<double>(detection_mask_white_pixel_count);
-
-		if (match >= RUNE_SEGMENT_DETECTION_THRESHOLD) {
-			std::cout << "Pattern detected!" << std::endl;
-			m_rune |= rune_bit; // Set the corresponding bit in m_rune
+		Rune rune_part = Rune(0x1ul << shift);
+		cv::Mat detection_mask(cell_size, CV_8UC1, cv::Scalar(0));
+		cv::Mat filter_mask(cell_size, CV_8UC1, cv::Scalar(0));
+		rune_part.generate_image(margin, margin, rune_size, RUNE_SEGMENT_DETECTION_DETECTION_MASK_TICKNESS * rune_size.height, detection_mask, false);
+		rune_part.generate_image(margin, margin, rune_size, RUNE_SEGMENT_DETECTION_FILTER_MASK_TICKNESS * rune_size.height, filter_mask, false);
+		segment_bits.push_back(0x1ul << shift);
+		detection_masks.push_back(detection_mask);
+		filter_masks.push_back(filter_mask);
+	}
+	cv::Mat separator_mask(cell_size, CV_8UC1, cv::Scalar(0));
+	Rune(RUNE_NULL).generate_image(margin, margin, rune_size, RUNE_SEGMENT_DETECTION_FILTER_MASK_TICKNESS * rune_size.height, separator_mask, true);
+
+	std::vector<int> mask_pixel_counts(detection_masks.size());
+	for (size_t s = 0; s < detection_masks.size(); s++) {
+		cv::Mat shared_mask = separator_mask.clone();
+		for (size_t other = 0; other < filter_masks.size(); other++) {
+			if (other != s) {
+				cv::bitwise_or(shared_mask, filter_masks[other], shared_mask);
+			}
 		}
-
-		//cv::imshow("rune_image", rune_image);
-		cv::imshow("1-rune_image_with_borders", rune_image_with_borders);
-		cv::imshow("2-rune_filter_mask", rune_filter_mask);
-		cv::imshow("3-rune_detection_mask", rune_detection_mask);
-		cv::imshow("4-filtered_result", filtered_result);
-		cv::imshow("5-detection_result", detection_result);
-
-		cv::waitKey(300); // Wait for a key press to close the window
-		cv::destroyAllWindows();
+		cv::Mat exclusive_mask;
+		cv::bitwise_and(detection_masks[s], ~shared_mask, exclusive_mask);
+		if (cv::countNonZero(exclusive_mask) > 0) {
+			detection_masks[s] = exclusive_mask;
+		}
+		mask_pixel_counts[s] = cv::countNonZero(detection_masks[s]);
 	}
-	 
-	return (m_rune != 0);
+
+	// padded so the cells of the border runes stay whole
+	int padding = (std::max)(cell_size.width, cell_size.height);
+	cv::Mat padded_image;
+	cv::copyMakeBorder(binary_image, padded_image, padding, padding, padding, padding, cv::BORDER_CONSTANT, cv::Scalar(0));
+	cv::Rect padded_rect(0, 0, padded_image.cols, padded_image.rows);
+	int kernel_size = 2 * (int)(tickness / 6.0) + 1;
+	cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(kernel_size, kernel_size));
+
+	cv::parallel_for_(cv::Range(0, (int)origins.size()), [&](const cv::Range& range) {
+		cv::Mat cell, matched;
+		for (int i = range.start; i < range.end; i++) {
+			cv::Rect cell_rect(cvRound(origins[i].x) - margin + padding, cvRound(origins[i].y) - margin + padding, cell_size.width, cell_size.height);
+			if ((cell_rect & padded_rect) != cell_rect) {
+				continue;
+			}
+			if (kernel_size > 1) {
+				cv::morphologyEx(padded_image(cell_rect), cell, cv::MORPH_CLOSE, kernel);
+			}
+			else {
+				cell = padded_image(cell_rect);
+			}
+			unsigned long value = 0;
+			for (size_t s = 0; s < detection_masks.size(); s++) {
+				cv::bitwise_and(cell, detection_masks[s], matched);
+				double match = static_cast<double>(cv::countNonZero(matched)) / (std::max)(1, mask_pixel_counts[s]);
+				if (match >= RUNE_SEGMENT_DETECTION_THRESHOLD) {
+					value |= segment_bits[s]; // Set the corresponding bit
+				}
+			}
+			runes[i] = Rune(value);
+		}
+	});
+	return true;
 }
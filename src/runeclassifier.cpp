@@ -0,0 +1,492 @@
+#include "runeclassifier.h"
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <atomic>
+#include <algorithm>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include "toolbox.h"
+#include "runedetector.h"
+
+// Segment geometry in rune layout coordinates (percent of the rune size), in RUNE_CLASSIFIER_SEGMENT_BITS order
+// the last entry is the circle (center, point of the circle)
+static const std::initializer_list<cv::Point2d> RUNE_CLASSIFIER_SEGMENTS[RUNE_CLASSIFIER_NB_SEGMENTS] = {
+	RUNE_SEGMENT_01, RUNE_SEGMENT_02, RUNE_SEGMENT_03, RUNE_SEGMENT_04, RUNE_SEGMENT_05, RUNE_SEGMENT_06, RUNE_SEGMENT_08,
+	RUNE_SEGMENT_09, RUNE_SEGMENT_10, RUNE_SEGMENT_11, RUNE_SEGMENT_12, RUNE_SEGMENT_13, RUNE_SEGMENT_14,
+	RUNE_RADIUS_16
+};
+
+static unsigned long rune_segment_mask()
+{
+	unsigned long mask = 0;
+	for (int i = 0; i < RUNE_CLASSIFIER_NB_SEGMENTS; i++) {
+		mask |= (0x1ul << RUNE_CLASSIFIER_SEGMENT_BITS[i]);
+	}
+	return mask;
+}
+
+// mean of a 0/1 image over a box, from its integral image
+static float box_mean(const cv::Mat& integral_image, int x, int y, int radius)
+{
+	int x0 = std::clamp(x - radius, 0, integral_image.cols - 1);
+	int y0 = std::clamp(y - radius, 0, integral_image.rows - 1);
+	int x1 = std::clamp(x + radius + 1, 0, integral_image.cols - 1);
+	int y1 = std::clamp(y + radius + 1, 0, integral_image.rows - 1);
+	int area = (x1 - x0) * (y1 - y0);
+	if (area <= 0) {
+		return 0.0f;
+	}
+	int sum = integral_image.at<int>(y1, x1) - integral_image.at<int>(y0, x1) - integral_image.at<int>(y1, x0) + integral_image.at<int>(y0, x0);
+	return (float)sum / area;
+}
+
+// Features of all the runes of a cropped binary word image (white runes on black, first rune at x = 0)
+// The runes are placed on the word grid (height from the image, width from the default aspect ratio, vertical
+// position from the separator) and the ink is sampled along each segment with box sums on an integral image
+bool RuneClassifier::extract_features(const cv::Mat& word_image, cv::Mat& features)
+{
+	features.release();
+	if (word_image.empty() || word_image.channels() != 1) {
+		return false;
+	}
+
+	cv::Mat binary_image, ink, integral_image;
+	cv::threshold(word_image, binary_image, 100, 255, cv::THRESH_BINARY);
+	cv::threshold(word_image, ink, 100, 1, cv::THRESH_BINARY);
+	cv::integral(ink, integral_image, CV_32S);
+
+	// the word holds the runes and a margin of one stroke tickness above and below (see Word::generate_image)
+	double rune_height = word_image.rows / (1.0 + 2.0 * RUNE_SEGMENT_DRAW_DEFAULT_TICKNESS);
+	double rune_width = rune_height * RUNE_DEFAULT_SIZE.aspectRatio();
+	double tickness = RUNE_SEGMENT_DRAW_DEFAULT_TICKNESS * rune_height;
+	int nb_runes = (std::max)(1, (int)std::round((word_image.cols - tickness) / rune_width));
+
+	// align the layout on the separator when it is found
+	int line_center_y = 0;
+	int separator_tickness = 0;
+	double separator_y = tickness + 0.01 * RUNE_POINT_E.y * rune_height;
+	if (find_horizontal_separator(binary_image, line_center_y, separator_tickness)) {
+		separator_y = line_center_y;
+	}
+	int radius = (std::max)(1, (int)std::round(0.5 * RUNE_SEGMENT_DETECTION_DETECTION_MASK_TICKNESS * rune_height));
+
+	features.create(nb_runes, RUNE_CLASSIFIER_NB_FEATURES, CV_32F);
+	for (int r = 0; r < nb_runes; r++) {
+		float* rune_features = features.ptr<float>(r);
+		// the separator starts half a stroke before point E
+		double origin_x = 0.5 * tickness + r * rune_width;
+		auto to_pixel = [&](const cv::Point2d& point) {
+			return cv::Point2d(origin_x + 0.01 * point.x * rune_width, separator_y + 0.01 * (point.y - RUNE_POINT_E.y) * rune_height);
+		};
+
+		for (int s = 0; s < RUNE_CLASSIFIER_NB_SEGMENTS; s++) {
+			cv::Point2d p0 = to_pixel(*RUNE_CLASSIFIER_SEGMENTS[s].begin());
+			cv::Point2d p1 = to_pixel(*(RUNE_CLASSIFIER_SEGMENTS[s].begin() + 1));
+			bool circle = RUNE_CLASSIFIER_SEGMENT_BITS[s] == 15;
+			double circle_radius = cv::norm(p1 - p0);
+
+			float ink_sum = 0.0f;
+			for (int k = 0; k < RUNE_CLASSIFIER_SAMPLES_PER_SEGMENT; k++) {
+				cv::Point2d sample;
+				if (circle) {
+					double angle = 2.0 * CV_PI * k / RUNE_CLASSIFIER_SAMPLES_PER_SEGMENT;
+					sample = p0 + circle_radius * cv::Point2d(std::cos(angle), std::sin(angle));
+				}
+				else {
+					// stay away from the end points, they are shared with the neighbour segments
+					double t = 0.15 + 0.7 * k / (RUNE_CLASSIFIER_SAMPLES_PER_SEGMENT - 1);
+					sample = p0 + t * (p1 - p0);
+				}
+				ink_sum += box_mean(integral_image, cvRound(sample.x), cvRound(sample.y), radius);
+			}
+			rune_features[s] = ink_sum / RUNE_CLASSIFIER_SAMPLES_PER_SEGMENT;
+		}
+
+		// coarse projections of the rune box
+		float* profile = rune_features + RUNE_CLASSIFIER_NB_SEGMENTS;
+		std::fill(profile, profile + RUNE_CLASSIFIER_PROFILE_ROWS + RUNE_CLASSIFIER_PROFILE_COLS, 0.0f);
+		cv::Point top_left(cvRound(origin_x), cvRound(separator_y - 0.01 * RUNE_POINT_E.y * rune_height));
+		cv::Point bottom_right(cvRound(origin_x + rune_width), cvRound(separator_y + 0.01 * (100.0 - RUNE_POINT_E.y) * rune_height));
+		cv::Rect rune_rect = cv::Rect(top_left, bottom_right) & cv::Rect(0, 0, ink.cols, ink.rows);
+		if (rune_rect.empty()) {
+			continue;
+		}
+		cv::Mat ink_float, small_image;
+		ink(rune_rect).convertTo(ink_float, CV_32F);
+		cv::resize(ink_float, small_image, cv::Size(RUNE_CLASSIFIER_PROFILE_COLS, RUNE_CLASSIFIER_PROFILE_ROWS), 0, 0, cv::INTER_AREA);
+		for (int row = 0; row < RUNE_CLASSIFIER_PROFILE_ROWS; row++) {
+			profile[row] = (float)cv::mean(small_image.row(row))[0];
+		}
+		for (int col = 0; col < RUNE_CLASSIFIER_PROFILE_COLS; col++) {
+			profile[RUNE_CLASSIFIER_PROFILE_ROWS + col] = (float)cv::mean(small_image.col(col))[0];
+		}
+	}
+
+	return true;
+}
+
+bool RuneClassifier::extract_features(const std::vector<cv::Mat>& word_images, cv::Mat& features, std::vector<int>& nb_runes)
+{
+	std::vector<cv::Mat> word_features(word_images.size());
+	std::atomic<bool> result = true;
+	cv::parallel_for_(cv::Range(0, (int)word_images.size()), [&](const cv::Range& range) {
+		for (int i = range.start; i < range.end; i++) {
+			if (!extract_features(word_images[i], word_features[i])) {
+				result = false;
+			}
+		}
+	});
+
+	nb_runes.assign(word_images.size(), 0);
+	std::vector<cv::Mat> rows;
+	for (size_t i = 0; i < word_features.size(); i++) {
+		nb_runes[i] = word_features[i].rows;
+		if (!word_features[i].empty()) {
+			rows.push_back(word_features[i]);
+		}
+	}
+	if (rows.empty()) {
+		features.create(0, RUNE_CLASSIFIER_NB_FEATURES, CV_32F);
+	}
+	else {
+		cv::vconcat(rows, features);
+	}
+	return result;
+}
+
+bool RuneClassifier::load(const fs::path& model_file)
+{
+	if (!fs::exists(model_file)) {
+		std::cerr << "Error: Rune classifier model not found: " << model_file << std::endl;
+		return false;
+	}
+	m_model = cv::ml::ANN_MLP::load(model_file.string());
+	if (!is_trained()) {
+		std::cerr << "Error: Could not load rune classifier model from " << model_file << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool RuneClassifier::save(const fs::path& model_file) const
+{
+	if (!is_trained()) {
+		std::cerr << "Error: Cannot save an untrained rune classifier." << std::endl;
+		return false;
+	}
+	m_model->save(model_file.string());
+	return true;
+}
+
+bool RuneClassifier::is_trained() const
+{
+	return !m_model.empty() && m_model->isTrained();
+}
+
+bool RuneClassifier::predict(const cv::Mat& features, std::vector<Rune>& runes) const
+{
+	runes.clear();
+	if (!is_trained()) {
+		std::cerr << "Error: Rune classifier is not trained." << std::endl;
+		return false;
+	}
+	if (features.empty()) {
+		return true;
+	}
+
+	cv::Mat outputs;
+	m_model->predict(features, outputs);
+
+	runes.reserve(outputs.rows);
+	for (int i = 0; i < outputs.rows; i++) {
+		const float* output = outputs.ptr<float>(i);
+		unsigned long value = 0;
+		for (int s = 0; s < RUNE_CLASSIFIER_NB_SEGMENTS; s++) {
+			if (output[s] > RUNE_CLASSIFIER_BIT_THRESHOLD) {
+				value |= (0x1ul << RUNE_CLASSIFIER_SEGMENT_BITS[s]);
+			}
+		}
+		runes.push_back(Rune(value));
+	}
+	return true;
+}
+
+bool RuneClassifier::decode_words(const std::vector<cv::Mat>& word_images, std::vector<Word>& words, std::vector<bool>& decoded) const
+{
+	words.assign(word_images.size(), Word());
+	decoded.assign(word_images.size(), false);
+
+	// features of all the runes of the page, then a single predict
+	cv::Mat features;
+	std::vector<int> nb_runes;
+	extract_features(word_images, features, nb_runes);
+	std::vector<Rune> runes;
+	if (!predict(features, runes)) {
+		return false;
+	}
+
+	size_t first = 0;
+	for (size_t i = 0; i < word_images.size(); i++) {
+		words[i] = Word(std::vector<Rune>(runes.begin() + first, runes.begin() + first + nb_runes[i]));
+		decoded[i] = nb_runes[i] > 0;
+		first += nb_runes[i];
+	}
+	return true;
+}
+
+// Labelled word images are named like the rune folder: <word hash>[_<translation>].<ext>
+bool RuneClassifier::load_labelled_words(const std::vector<fs::path>& labelled_folders, std::vector<cv::Mat>& word_images, std::vector<Word>& labels)
+{
+	for (const auto& folder : labelled_folders) {
+		if (!fs::exists(folder) || !fs::is_directory(folder)) {
+			std::cerr << "Error: Labelled folder does not exist or is not a directory: " << folder << std::endl;
+			return false;
+		}
+
+		// sorted for reproducible training sets
+		std::vector<fs::path> files;
+		for (const auto& entry : fs::directory_iterator(folder)) {
+			if (entry.is_regular_file()) {
+				files.push_back(entry.path());
+			}
+		}
+		std::sort(files.begin(), files.end());
+
+		for (const auto& file : files) {
+			auto filename = file.stem().string();
+			Word label(filename.substr(0, filename.find(RUNE_WORD_TRANSLATION_SEPARATOR)));
+			if (label.size() == 0) {
+				std::cerr << "Skipping unlabelled image: " << file << std::endl;
+				continue;
+			}
+
+			cv::Mat word_image, cropped_image;
+			if (!load_gray_image(file, word_image)) {
+				continue;
+			}
+			make_white_rune_black_background(word_image);
+			if (!crop_word_image(word_image, cropped_image)) {
+				std::cerr << "Skipping " << file.filename() << ": no separator" << std::endl;
+				continue;
+			}
+			word_images.push_back(cropped_image);
+			labels.push_back(label);
+		}
+	}
+	return true;
+}
+
+// The labelled images are few: a fixed stride over the sorted files (instead of a random split) keeps the same
+// words held out between a training and a later evaluation of the saved model
+void RuneClassifier::split_labelled_words(int holdout_stride, bool held_out, std::vector<cv::Mat>& word_images, std::vector<Word>& labels)
+{
+	if (holdout_stride <= 0) {
+		return; // no hold out: every word is trained on and evaluated
+	}
+	std::vector<cv::Mat> kept_images;
+	std::vector<Word> kept_labels;
+	for (size_t i = 0; i < word_images.size(); i++) {
+		if ((i % holdout_stride == (size_t)holdout_stride - 1) == held_out) {
+			kept_images.push_back(word_images[i]);
+			kept_labels.push_back(labels[i]);
+		}
+	}
+	word_images = kept_images;
+	labels = kept_labels;
+}
+
+// Random words rendered with Word::generate_image then degraded (size, tickness, blur, noise, jpeg)
+// and cropped with the same pipeline as the real images
+bool RuneClassifier::generate_synthetic_words(int nb_words, unsigned int seed, std::vector<cv::Mat>& word_images, std::vector<Word>& labels)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+	for (int w = 0; w < nb_words; w++) {
+		std::vector<Rune> runes;
+		int nb_runes = 1 + (int)(uniform(rng) * 4);
+		for (int r = 0; r < nb_runes; r++) {
+			unsigned long value = 0;
+			while (value == 0) {
+				for (int s = 0; s < RUNE_CLASSIFIER_NB_SEGMENTS; s++) {
+					if (uniform(rng) < 0.4) {
+						value |= (0x1ul << RUNE_CLASSIFIER_SEGMENT_BITS[s]);
+					}
+				}
+			}
+			runes.push_back(Rune(value));
+		}
+		Word word(runes);
+
+		double rune_height = 30.0 + uniform(rng) * 90.0;
+		double tickness = (std::max)(1.0, RUNE_SEGMENT_DRAW_DEFAULT_TICKNESS * rune_height * (0.7 + 0.6 * uniform(rng)));
+		cv::Size2i rune_size((int)std::round(rune_height * RUNE_DEFAULT_SIZE.aspectRatio()), (int)std::round(rune_height));
+
+		cv::Mat word_image;
+		word.generate_image(rune_size, tickness, word_image);
+
+		if (uniform(rng) < 0.5) {
+			cv::GaussianBlur(word_image, word_image, cv::Size(3, 3), 0);
+		}
+		if (uniform(rng) < 0.5) {
+			cv::Mat noise(word_image.size(), CV_16S);
+			cv::randn(noise, 0, 10.0 + uniform(rng) * 30.0);
+			cv::Mat noisy_image;
+			word_image.convertTo(noisy_image, CV_16S);
+			noisy_image += noise;
+			noisy_image.convertTo(word_image, CV_8U);
+		}
+		if (uniform(rng) < 0.5) {
+			std::vector<uchar> buffer;
+			cv::imencode(".jpg", word_image, buffer, { cv::IMWRITE_JPEG_QUALITY, 40 + (int)(uniform(rng) * 55) });
+			word_image = cv::imdecode(buffer, cv::IMREAD_GRAYSCALE);
+		}
+
+		cv::Mat cropped_image;
+		make_white_rune_black_background(word_image);
+		if (!crop_word_image(word_image, cropped_image)) {
+			continue;
+		}
+		word_images.push_back(cropped_image);
+		labels.push_back(word);
+	}
+	return true;
+}
+
+bool RuneClassifier::train(const std::vector<fs::path>& labelled_folders, int nb_synthetic_words, unsigned int seed, int holdout_stride)
+{
+	std::vector<cv::Mat> word_images;
+	std::vector<Word> labels;
+	if (!load_labelled_words(labelled_folders, word_images, labels)) {
+		return false;
+	}
+	split_labelled_words(holdout_stride, false, word_images, labels);
+	size_t nb_labelled_words = word_images.size();
+	generate_synthetic_words(nb_synthetic_words, seed, word_images, labels);
+
+	cv::Mat features;
+	std::vector<int> nb_runes;
+	extract_features(word_images, features, nb_runes);
+
+	// keep the words whose rune count is found back in the image
+	cv::Mat samples, responses;
+	int first = 0;
+	int nb_training_words = 0;
+	for (size_t i = 0; i < word_images.size(); i++) {
+		auto runes = labels[i].get_runes();
+		if (nb_runes[i] == (int)runes.size()) {
+			samples.push_back(features.rowRange(first, first + nb_runes[i]));
+			for (const auto& rune : runes) {
+				cv::Mat response(1, RUNE_CLASSIFIER_NB_SEGMENTS, CV_32F);
+				for (int s = 0; s < RUNE_CLASSIFIER_NB_SEGMENTS; s++) {
+					response.at<float>(0, s) = (rune.get_value() & (0x1ul << RUNE_CLASSIFIER_SEGMENT_BITS[s])) ? 1.0f : 0.0f;
+				}
+				responses.push_back(response);
+			}
+			nb_training_words++;
+		}
+		first += nb_runes[i];
+	}
+	if (samples.empty()) {
+		std::cerr << "Error: No training runes." << std::endl;
+		return false;
+	}
+	std::cout << "Training rune classifier on " << samples.rows << " runes from " << nb_training_words << " words ("
+		<< nb_labelled_words << " labelled images, " << word_images.size() - nb_labelled_words << " synthetic words)" << std::endl;
+
+	m_model = cv::ml::ANN_MLP::create();
+	cv::Mat layer_sizes = (cv::Mat_<int>(1, 3) << RUNE_CLASSIFIER_NB_FEATURES, RUNE_CLASSIFIER_HIDDEN_LAYER_SIZE, RUNE_CLASSIFIER_NB_SEGMENTS);
+	m_model->setLayerSizes(layer_sizes);
+	m_model->setActivationFunction(cv::ml::ANN_MLP::SIGMOID_SYM, 1.0, 1.0);
+	m_model->setTrainMethod(cv::ml::ANN_MLP::RPROP);
+	m_model->setTermCriteria(cv::TermCriteria(cv::TermCriteria::MAX_ITER + cv::TermCriteria::EPS, 1000, 1e-6));
+
+	auto start = std::chrono::high_resolution_clock::now();
+	bool result = m_model->train(cv::ml::TrainData::create(samples, cv::ml::ROW_SAMPLE, responses));
+	auto end = std::chrono::high_resolution_clock::now();
+	std::cout << "Rune classifier trained in " << std::chrono::duration<double, std::milli>(end - start).count() << " ms" << std::endl;
+
+	return result && is_trained();
+}
+
+bool RuneClassifier::evaluate(const std::vector<fs::path>& labelled_folders, RuneClassifierReport& report, int holdout_stride) const
+{
+	report = RuneClassifierReport();
+
+	std::vector<cv::Mat> word_images;
+	std::vector<Word> labels;
+	if (!load_labelled_words(labelled_folders, word_images, labels)) {
+		return false;
+	}
+	split_labelled_words(holdout_stride, true, word_images, labels);
+	if (word_images.empty()) {
+		std::cerr << "Error: No held out labelled words to evaluate the rune classifier." << std::endl;
+		return false;
+	}
+	report.nb_words = (int)word_images.size();
+	unsigned long segment_mask = rune_segment_mask();
+
+	// classifier: features + one batched predict
+	auto start = std::chrono::high_resolution_clock::now();
+	std::vector<Word> predicted;
+	std::vector<bool> decoded;
+	if (!decode_words(word_images, predicted, decoded)) {
+		return false;
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	report.classifier_ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+	// reference: mask rasterisation decoder
+	std::vector<Word> reference(word_images.size());
+	start = std::chrono::high_resolution_clock::now();
+	for (size_t i = 0; i < word_images.size(); i++) {
+		reference[i].decode_image(word_images[i]);
+	}
+	end = std::chrono::high_resolution_clock::now();
+	report.reference_ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+	for (size_t i = 0; i < labels.size(); i++) {
+		auto expected = labels[i].get_runes();
+		auto predicted_runes = predicted[i].get_runes();
+		auto reference_runes = reference[i].get_runes();
+		report.nb_runes += (int)expected.size();
+
+		// a word cut in the wrong number of runes counts as all wrong
+		if (predicted_runes.size() != expected.size()) {
+			report.nb_rune_errors += (int)expected.size();
+		}
+		else {
+			for (size_t r = 0; r < expected.size(); r++) {
+				unsigned long diff = (predicted_runes[r].get_value() ^ expected[r].get_value()) & segment_mask;
+				if (diff != 0) {
+					report.nb_rune_errors++;
+				}
+				for (int s = 0; s < RUNE_CLASSIFIER_NB_SEGMENTS; s++) {
+					if (diff & (0x1ul << RUNE_CLASSIFIER_SEGMENT_BITS[s])) {
+						report.nb_bit_errors++;
+					}
+				}
+			}
+		}
+
+		if (reference_runes.size() != expected.size()) {
+			report.nb_reference_rune_errors += (int)expected.size();
+		}
+		else {
+			for (size_t r = 0; r < expected.size(); r++) {
+				if (((reference_runes[r].get_value() ^ expected[r].get_value()) & segment_mask) != 0) {
+					report.nb_reference_rune_errors++;
+				}
+			}
+		}
+	}
+
+	std::cout << "Rune classifier evaluation: " << report.nb_runes << " runes in " << report.nb_words
+		<< (holdout_stride > 0 ? " held out words" : " training words") << std::endl
+		<< "  classifier: " << report.nb_rune_errors << " rune errors, " << report.nb_bit_errors << " bit errors, " << report.classifier_ms << " ms" << std::endl
+		<< "  reference : " << report.nb_reference_rune_errors << " rune errors, " << report.reference_ms << " ms" << std::endl;
+
+	return true;
+}
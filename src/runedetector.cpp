@@ -1,6 +1,8 @@
 #include "runedetector.h"
 
 #include <iostream>
+#include <chrono>
+#include <limits>
 #include <word.h>
 #include <toolbox.h>
 
@@ -80,66 +82,257 @@ bool RuneDetector::register_word_image(const fs::path& word_image)
 
 bool RuneDetector::decode_word_image(const fs::path& file_path, Word& word)
 {
-	auto word_image = cv::imread(file_path.string(), cv::IMREAD_COLOR_BGR);
-	if (word_image.empty()) {
-		std::cerr << "Error: Could not load rune image from " << word_image << std::endl;
+	cv::Mat word_image;
+	if (!load_gray_image(file_path, word_image)) {
 		return false;
 	}
+	make_white_rune_black_background(word_image);
 
-	//cv::imshow("word_image before", word_image);
+	// the rune grid starts at the separator: no crop, the separator is only searched once
+	bool result = word.decode_image(word_image);
 
+	// last step: an image of the decoded word is generated and a detection is done on original image
+	// TODO: launch a detection on originial image to confirm crrectness of the decoding
+	return result;
+}
 
-	make_white_rune_black_background(word_image);
-	//cv::imshow("word_image after", word_image);
-	//cv::waitKey(1000);
-	//cv::destroyAllWindows();
+// Strict weak ordering of two zones of the same text line: left to right, then every rect field and the word hash as tie-breaks
+// (the previous tolerance based comparator was not transitive, so std::sort could return a different order on each run)
+static bool compare_rune_zones_in_line(const RuneZone& a, const std::string& hash_a, const RuneZone& b, const std::string& hash_b) {
+	if (a.rect.x != b.rect.x) return a.rect.x < b.rect.x;
+	if (a.rect.y != b.rect.y) return a.rect.y < b.rect.y;
+	if (a.rect.width != b.rect.width) return a.rect.width < b.rect.width;
+	if (a.rect.height != b.rect.height) return a.rect.height < b.rect.height;
+	return hash_a < hash_b;
+}
 
+// y of the word separator line inside a zone (the separator goes through points E and G of the rune layout)
+static double rune_zone_separator_y(const RuneZone& zone) {
+	return zone.rect.y + zone.rect.height * RUNE_POINT_E.y / 100.0;
+}
 
-	int line_center_y = 0;
-	int tickness = 0;
-	if (!find_horizontal_separator(word_image, line_center_y, tickness)) {
-		std::cerr << "No horizontal separator found in the rune image." << std::endl;
-		return false; // No separator line found
+static double rune_zone_iou(const cv::Rect& a, const cv::Rect& b) {
+	double inter = (a & b).area();
+	if (inter <= 0) {
+		return 0.0;
 	}
+	return inter / ((double)a.area() + (double)b.area() - inter);
+}
 
-	int line_center_x_min = 0;
-	int line_center_x_max = word_image.cols;
-	if (!find_horizontal_separator_bounds(word_image, line_center_y, line_center_x_min, line_center_x_max)) {
-		std::cerr << "Error when trying to find word width" << std::endl;
-		return false;
+// Rebuild the reading order of detected zones
+// 1. duplicates (same zone matched several times, neighbour positions, other scale) are suppressed with a grid hash over the rects,
+//    the best scored detection wins (then the leftmost / topmost one, so the survivor does not depend on the input order)
+// 2. remaining zones are clustered into text lines by separator y
+// 3. lines are emitted top to bottom, zones inside a line left to right
+// Every step is O(n log n) (grid queries only visit the cells covered by a rect) and the output does not depend on ties
+bool order_rune_zones(const std::vector<RuneZone>& zones, std::vector<RuneZone>& ordered_zones, double duplicate_iou)
+{
+	ordered_zones.clear();
+	if (zones.empty()) {
+		return true;
 	}
 
-	// crop size - we only crop the left size of the word image
-	int height = word_image.rows;
-	int width = word_image.cols - line_center_x_min; 
-	cv::Rect roi(line_center_x_min, 0, width, height);
-	cv::Mat cropped_image = word_image(roi);
+	std::vector<std::string> hashes;
+	hashes.reserve(zones.size());
+	for (const auto& zone : zones) {
+		hashes.push_back(zone.word.get_hash());
+	}
 
-	bool word_decoding_result = word.decode_image(cropped_image);
+	// grid cell size: the median zone, so a typical rect covers at most 2x2 cells (a big zone is inserted in all the cells
+	// it covers, one outlier does not put every zone in the same cell)
+	std::vector<int> zone_sizes;
+	zone_sizes.reserve(zones.size());
+	for (const auto& zone : zones) {
+		zone_sizes.push_back((std::max)(zone.rect.width, zone.rect.height));
+	}
+	std::nth_element(zone_sizes.begin(), zone_sizes.begin() + zone_sizes.size() / 2, zone_sizes.end());
+	int cell_size = (std::max)(1, zone_sizes[zone_sizes.size() / 2]);
+	auto cell_key = [](int cx, int cy) -> long long {
+		return ((long long)cy << 32) ^ (unsigned int)cx;
+	};
+
+	// --- duplicate suppression, best score first ---
+	std::vector<int> candidates(zones.size());
+	for (int i = 0; i < (int)zones.size(); i++) {
+		candidates[i] = i;
+	}
+	std::sort(candidates.begin(), candidates.end(), [&](int a, int b) {
+		if (zones[a].score != zones[b].score) return zones[a].score > zones[b].score;
+		return compare_rune_zones_in_line(zones[a], hashes[a], zones[b], hashes[b]);
+	});
+	std::unordered_map<long long, std::vector<int>> grid;
+	std::vector<int> kept;
+	kept.reserve(zones.size());
+	for (int i : candidates) {
+		const auto& rect = zones[i].rect;
+		int cx0 = (int)std::floor((double)rect.x / cell_size);
+		int cy0 = (int)std::floor((double)rect.y / cell_size);
+		int cx1 = (int)std::floor((double)(rect.x + rect.width - 1) / cell_size);
+		int cy1 = (int)std::floor((double)(rect.y + rect.height - 1) / cell_size);
+
+		bool duplicate = false;
+		for (int cy = cy0; cy <= cy1 && !duplicate; cy++) {
+			for (int cx = cx0; cx <= cx1 && !duplicate; cx++) {
+				auto it = grid.find(cell_key(cx, cy));
+				if (it == grid.end()) {
+					continue;
+				}
+				for (int k : it->second) {
+					if (rune_zone_iou(rect, zones[k].rect) > duplicate_iou) {
+						duplicate = true;
+						break;
+					}
+				}
+			}
+		}
+		if (duplicate) {
+			continue;
+		}
 
-	// last step: an image of the decoded word is generated and a detection is done on original image
-	// TODO: launch a detection on originial image to confirm crrectness of the decoding
-	bool result = word_decoding_result;
+		kept.push_back(i);
+		for (int cy = cy0; cy <= cy1; cy++) {
+			for (int cx = cx0; cx <= cx1; cx++) {
+				grid[cell_key(cx, cy)].push_back(i);
+			}
+		}
+	}
 
-	return result;
+	// --- line clustering by separator y ---
+	struct ZoneEntry {
+		int index;
+		double separator_y;
+		std::string hash;
+	};
+	std::vector<ZoneEntry> entries;
+	entries.reserve(kept.size());
+	for (int i : kept) {
+		entries.push_back({ i, rune_zone_separator_y(zones[i]), hashes[i] });
+	}
+	std::sort(entries.begin(), entries.end(), [&](const ZoneEntry& a, const ZoneEntry& b) {
+		if (a.separator_y != b.separator_y) return a.separator_y < b.separator_y;
+		return compare_rune_zones_in_line(zones[a.index], a.hash, zones[b.index], b.hash);
+	});
+
+	// a zone joins the current line while its separator stays within RUNE_ZONE_LINE_TOLERANCE * height of the line mean
+	std::vector<std::pair<size_t, size_t>> lines; // [begin, end) in entries
+	size_t line_begin = 0;
+	double line_sum_y = entries[0].separator_y;
+	double line_sum_height = zones[entries[0].index].rect.height;
+	for (size_t i = 1; i < entries.size(); i++) {
+		double count = (double)(i - line_begin);
+		double line_y = line_sum_y / count;
+		double line_height = line_sum_height / count;
+		if (entries[i].separator_y - line_y > RUNE_ZONE_LINE_TOLERANCE * line_height) {
+			lines.push_back({ line_begin, i });
+			line_begin = i;
+			line_sum_y = 0.0;
+			line_sum_height = 0.0;
+		}
+		line_sum_y += entries[i].separator_y;
+		line_sum_height += zones[entries[i].index].rect.height;
+	}
+	lines.push_back({ line_begin, entries.size() });
+
+	// --- reading order inside each line ---
+	ordered_zones.reserve(entries.size());
+	for (size_t line = 0; line < lines.size(); line++) {
+		auto first = entries.begin() + lines[line].first;
+		auto last = entries.begin() + lines[line].second;
+		std::sort(first, last, [&](const ZoneEntry& a, const ZoneEntry& b) {
+			return compare_rune_zones_in_line(zones[a.index], a.hash, zones[b.index], b.hash);
+		});
+		for (auto it = first; it != last; it++) {
+			RuneZone zone = zones[it->index];
+			zone.line = (int)line;
+			ordered_zones.push_back(zone);
+		}
+	}
+
+	return true;
 }
 
-// Custom comparison function for sorting character zones
-bool compareCharacterZones(const RuneZone& a, const RuneZone& b) {
-	// Define a small tolerance for vertical alignment to consider characters on the same line
-	// You might need to adjust this value based on your font sizes and image resolution.
-	const int verticalTolerance = 10; // Example tolerance in pixels
+// The scores of every word matched over a zone are kept: a rescoring (dictionary, language model) picks among them
+// without matching the templates again
+bool attach_word_hypotheses(std::vector<RuneZone>& zones, const std::vector<WordHypothesis>& hypotheses, size_t top_k, double duplicate_iou)
+{
+	std::vector<std::string> hashes;
+	hashes.reserve(hypotheses.size());
+	for (const auto& hypothesis : hypotheses) {
+		hashes.push_back(hypothesis.word.get_hash());
+	}
+	for (auto& zone : zones) {
+		std::unordered_map<std::string, const WordHypothesis*> best_hypotheses;
+		for (size_t i = 0; i < hypotheses.size(); i++) {
+			if (rune_zone_iou(zone.rect, hypotheses[i].rect) <= duplicate_iou) {
+				continue;
+			}
+			auto it = best_hypotheses.find(hashes[i]);
+			if (it == best_hypotheses.end()) {
+				best_hypotheses[hashes[i]] = &hypotheses[i];
+			}
+			else if (hypotheses[i].score > it->second->score) {
+				it->second = &hypotheses[i];
+			}
+		}
+		zone.hypotheses.clear();
+		for (const auto& [hash, hypothesis] : best_hypotheses) {
+			zone.hypotheses.push_back(*hypothesis);
+		}
+		std::sort(zone.hypotheses.begin(), zone.hypotheses.end(), [](const WordHypothesis& a, const WordHypothesis& b) {
+			if (a.score != b.score) return a.score > b.score;
+			return a.word.get_hash() < b.word.get_hash();
+		});
+		if (zone.hypotheses.size() > top_k) {
+			zone.hypotheses.resize(top_k);
+		}
+	}
+	return true;
+}
 
-	// First, compare by vertical position (top to bottom)
-	// If they are on roughly the same line, then compare by horizontal position.
-	if (std::abs(a.rect.y - b.rect.y) < verticalTolerance) {
-		// If on the same "line" (within tolerance), sort by horizontal position (left to right)
-		return a.rect.x < b.rect.x;
+// Ambiguous regions: no word went over the detection threshold there, but they stay recoverable by a rescoring
+bool find_uncertain_zones(const std::vector<RuneZone>& zones, const std::vector<WordHypothesis>& hypotheses, std::vector<RuneZone>& uncertain_zones, size_t top_k, double duplicate_iou)
+{
+	uncertain_zones.clear();
+	std::vector<size_t> order(hypotheses.size());
+	for (size_t i = 0; i < order.size(); i++) {
+		order[i] = i;
 	}
-	else {
-		// Sort by vertical position
-		return a.rect.y < b.rect.y;
+	std::stable_sort(order.begin(), order.end(), [&hypotheses](size_t a, size_t b) {
+		return hypotheses[a].score > hypotheses[b].score;
+	});
+
+	auto overlaps = [duplicate_iou](const std::vector<RuneZone>& zone_list, const cv::Rect& rect) {
+		return std::any_of(zone_list.begin(), zone_list.end(), [&rect, duplicate_iou](const RuneZone& zone) {
+			return rune_zone_iou(zone.rect, rect) > duplicate_iou;
+		});
+	};
+	for (size_t i : order) {
+		const auto& hypothesis = hypotheses[i];
+		if (overlaps(zones, hypothesis.rect) || overlaps(uncertain_zones, hypothesis.rect)) {
+			continue;
+		}
+		RuneZone zone;
+		zone.word = hypothesis.word;
+		zone.rect = hypothesis.rect;
+		zone.score = hypothesis.score;
+		zone.scale_factor = hypothesis.scale_factor;
+		uncertain_zones.push_back(zone);
+	}
+	return attach_word_hypotheses(uncertain_zones, hypotheses, top_k, duplicate_iou);
+}
+
+// Local maximum of a template matching score map (the 8 neighbours must lie inside the map)
+static bool is_score_peak(const cv::Mat& result, int i, int j)
+{
+	float score = result.at<float>(j, i);
+	for (int dj = -1; dj <= 1; dj++) {
+		for (int di = -1; di <= 1; di++) {
+			if ((di != 0 || dj != 0) && result.at<float>(j + dj, i + di) > score) {
+				return false;
+			}
+		}
 	}
+	return true;
 }
 
 cv::Mat RuneDetector::get_image_lines(const cv::Mat& src) {
@@ -205,42 +398,27 @@ cv::Mat RuneDetector::crop_black_borders(const cv::Mat& image) {
 	int threshold_value = 10; // Adjust this value if your "black" border isn't pure black
 	cv::threshold(grayImage, binaryImage, threshold_value, 255, cv::THRESH_BINARY);
 
-	// Optional: Morphological operations to clean up small noise or gaps
-	// cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(3, 3));
-	// cv::morphologyEx(binaryImage, binaryImage, cv::MORPH_OPEN, kernel, cv::Point(-1,-1), 2); // Remove small black dots
-	// cv::morphologyEx(binaryImage, binaryImage, cv::MORPH_CLOSE, kernel, cv::Point(-1,-1), 2); // Fill small white gaps
-
-	// 3. Find contours in the binary image
-	std::vector<std::vector<cv::Point>> contours;
-	cv::findContours(binaryImage, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
-
-	// 4. Find the bounding rectangle of the largest contour (assumed to be the content)
-	cv::Rect boundingBox;
-	if (!contours.empty()) {
-		double maxArea = 0;
-		int largestContourIdx = -1;
-
-		for (size_t i = 0; i < contours.size(); i++) {
-			double area = cv::contourArea(contours[i]);
-			if (area > maxArea) {
-				maxArea = area;
-				largestContourIdx = i;
-			}
-		}
-
-		if (largestContourIdx != -1) {
-			boundingBox = cv::boundingRect(contours[largestContourIdx]);
-		}
-		else {
-			// This case should ideally not be hit if contours is not empty
-			std::cerr << "No valid largest contour found. Returning original image." << std::endl;
-			return image.clone();
+	// 3. Connected components of the content pixels with their stats, in one labelling pass
+	// (no contour is traced, components are compared by their number of pixels)
+	cv::Mat labels, stats, centroids;
+	int nb_labels = cv::connectedComponentsWithStats(binaryImage, labels, stats, centroids, 8);
+
+	// 4. The bounding box of the largest component (assumed to be the content): noise pixels near the edges do not count
+	int largest_label = -1;
+	int largest_area = 0;
+	for (int label = 1; label < nb_labels; label++) {
+		int area = stats.at<int>(label, cv::CC_STAT_AREA);
+		if (area > largest_area) {
+			largest_area = area;
+			largest_label = label;
 		}
 	}
-	else {
-		std::cerr << "No contours found in the image. It might be all black or all white. Returning original image." << std::endl;
+	if (largest_label < 0) {
+		std::cerr << "No content found in the image. It might be all black. Returning original image." << std::endl;
 		return image.clone(); // Or return an empty Mat if an empty image is desired
 	}
+	cv::Rect boundingBox(stats.at<int>(largest_label, cv::CC_STAT_LEFT), stats.at<int>(largest_label, cv::CC_STAT_TOP),
+		stats.at<int>(largest_label, cv::CC_STAT_WIDTH), stats.at<int>(largest_label, cv::CC_STAT_HEIGHT));
 
 	// 5. Crop the original image using the detected bounding box
 	// Ensure the bounding box is valid before cropping
@@ -257,8 +435,17 @@ cv::Mat RuneDetector::crop_black_borders(const cv::Mat& image) {
 // Take an image, partition it into potential rune words zones, try to parse and store them in the dictionary if not already present
 bool RuneDetector::dictionarize(const fs::path& image_path, bool debug_mode)
 {
-	// Load the image
-	auto original_img = cv::imread(image_path.string(), cv::IMREAD_COLOR_BGR);
+	if (!debug_mode) {
+		// headless: decode every block concurrently
+		std::vector<DictionarizeBlockReport> report;
+		return dictionarize_batch(image_path, report);
+	}
+
+	// Load the image (gray, full resolution: blocks are decoded rune by rune)
+	cv::Mat original_img;
+	if (!load_gray_image(image_path, original_img)) {
+		return false;
+	}
 
 	// prepare the image
 	make_white_rune_black_background(original_img);
@@ -286,22 +473,20 @@ bool RuneDetector::dictionarize(const fs::path& image_path, bool debug_mode)
 		//cv::imshow("Extracted Block " + std::to_string(block_count), extracted_block); 
 		//cv::imwrite("extracted_block_" + std::to_string(block_count) + ".jpg", extracted_block); // Save to file
 
-		if (debug_mode) {
-			// for debugging purposes, display the image
-			cv::imshow("Part " + i, extracted_block);
-			cv::waitKey(1000); // Wait for a key press to close the window
-			cv::destroyAllWindows();
-		}
+		// for debugging purposes, display the image
+		cv::imshow("Part " + std::to_string(i), extracted_block);
+		cv::waitKey(1000); // Wait for a key press to close the window
+		cv::destroyAllWindows();
 
 		// Decode the word image
 		Word word;
-		if (!word.decode_image(extracted_block)) {
+		if (!word.decode_image(extracted_block, debug_mode)) {
 			std::cerr << "Error: Could not decode word image." << std::endl;
 			continue; // Skip to the next image if decoding fails
 		}
 		// Check if the word is already in the dictionary
 		std::string translation;
-		if (m_dictionary->has_hash(word.get_hash())) {
+		if (m_dictionary->get_translation(word.get_hash(), translation)) {
 			std::cout << "Word '" << word.get_hash() << "' already exists in the dictionary with translation: " << translation << std::endl;
 			continue; // Skip if the word is already in the dictionary
 		}
@@ -312,7 +497,115 @@ bool RuneDetector::dictionarize(const fs::path& image_path, bool debug_mode)
 		i++;
 	}
 
-	return false;
+	return true;
+}
+
+// Batch version of dictionarize: all partitioned blocks are decoded in parallel with the headless decoder,
+// new words are merged into the dictionary under m_dictionary_mutex and the decode time of every block is reported
+bool RuneDetector::dictionarize_batch(const fs::path& image_path, std::vector<DictionarizeBlockReport>& report)
+{
+	report.clear();
+
+	if (m_dictionary == nullptr) {
+		std::cerr << "Error: No dictionary attached to the rune detector." << std::endl;
+		return false;
+	}
+
+	auto start_total = std::chrono::high_resolution_clock::now();
+
+	cv::Mat original_img;
+	if (!load_gray_image(image_path, original_img)) {
+		return false;
+	}
+
+	// prepare the image
+	make_white_rune_black_background(original_img);
+
+	std::vector<cv::Rect> partition;
+	if (!partition_image(original_img, partition)) {
+		std::cerr << "Error: Could not partition the image into potential rune words zones." << std::endl;
+		return false;
+	}
+
+	report.resize(partition.size());
+
+	if (m_rune_classifier.is_trained()) {
+		// learned decoder: every block is cropped, then all the runes of the page go through one predict call
+		// (the batch time is shared evenly between the blocks)
+		auto start_batch = std::chrono::high_resolution_clock::now();
+		std::vector<cv::Mat> word_images(partition.size());
+		std::vector<uchar> cropped(partition.size(), 0); // not vector<bool>: its packed bits are not safe to write concurrently
+		cv::parallel_for_(cv::Range(0, (int)partition.size()), [&](const cv::Range& range) {
+			for (int i = range.start; i < range.end; i++) {
+				cropped[i] = crop_word_image(original_img(partition[i]), word_images[i]);
+			}
+		});
+
+		std::vector<Word> words;
+		std::vector<bool> decoded;
+		m_rune_classifier.decode_words(word_images, words, decoded);
+
+		auto end_batch = std::chrono::high_resolution_clock::now();
+		double block_ms = std::chrono::duration<double, std::milli>(end_batch - start_batch).count() / (std::max)((size_t)1, partition.size());
+		for (size_t i = 0; i < partition.size(); i++) {
+			auto& block_report = report[i];
+			block_report.rect = partition[i];
+			block_report.duration_ms = block_ms;
+			block_report.decoded = cropped[i] && decoded[i] && words[i].is_valid();
+			if (block_report.decoded) {
+				block_report.word_hash = words[i].get_hash();
+				if (!m_dictionary->has_hash(block_report.word_hash)) {
+					block_report.added = m_dictionary->add_word(block_report.word_hash, words[i].to_pseudophonetic());
+				}
+			}
+		}
+	}
+	else {
+		// every block only reads the shared image and writes its own report slot
+		cv::parallel_for_(cv::Range(0, (int)partition.size()), [&](const cv::Range& range) {
+			for (int i = range.start; i < range.end; i++) {
+				auto start_block = std::chrono::high_resolution_clock::now();
+				auto& block_report = report[i];
+				block_report.rect = partition[i];
+
+				Word word;
+				block_report.decoded = word.decode_image(original_img(partition[i]), false) && word.is_valid();
+				if (block_report.decoded) {
+					block_report.word_hash = word.get_hash();
+
+					std::lock_guard<std::mutex> lock(m_dictionary_mutex);
+					if (!m_dictionary->has_hash(block_report.word_hash)) {
+						block_report.added = m_dictionary->add_word(block_report.word_hash, word.to_pseudophonetic());
+					}
+				}
+
+				auto end_block = std::chrono::high_resolution_clock::now();
+				block_report.duration_ms = std::chrono::duration<double, std::milli>(end_block - start_block).count();
+			}
+		});
+	}
+
+	auto end_total = std::chrono::high_resolution_clock::now();
+	double total_ms = std::chrono::duration<double, std::milli>(end_total - start_total).count();
+
+	// report in block order once all workers are done (keeps the log readable)
+	int nb_added = 0;
+	for (size_t i = 0; i < report.size(); i++) {
+		const auto& block_report = report[i];
+		std::cout << "Block " << i << " (x=" << block_report.rect.x << ", y=" << block_report.rect.y
+			<< ", width=" << block_report.rect.width << ", height=" << block_report.rect.height << "): ";
+		if (!block_report.decoded) {
+			std::cout << "not decoded";
+		}
+		else {
+			std::cout << "'" << block_report.word_hash << "'" << (block_report.added ? " added" : " already known");
+		}
+		std::cout << " [" << block_report.duration_ms << " ms]" << std::endl;
+		nb_added += block_report.added ? 1 : 0;
+	}
+	std::cout << "Dictionarized " << report.size() << " blocks (" << nb_added << " new words) in " << total_ms << " ms" << std::endl;
+
+	return true;
 }
 
 #include <opencv2/opencv.hpp>
@@ -476,6 +769,211 @@ cv::Mat draw_text_in_rect(
 
 bool RuneDetector::detect_words(cv::Mat& original_img, std::vector<Word>& detected_words, int adaptative_cycles, bool debug_mode, bool useGeneratedRunes, bool overwriteOnDetection)
 {
+	DetectionResult detection_result;
+	if (!detect_words(original_img, detection_result, DetectionBudget(), adaptative_cycles, debug_mode, useGeneratedRunes)) {
+		return false;
+	}
+	for (const auto& zone : detection_result.zones) {
+		detected_words.push_back(zone.word);
+	}
+	return true;
+}
+
+// Likely first: words already found on previous pages, then the short words (the most frequent ones)
+void RuneDetector::order_words_by_payoff(std::vector<std::string>& hash_list) const
+{
+	// hits are counted per detected word hash (see detect_words), the dictionary keys are unified the same way
+	std::unordered_map<std::string, std::pair<int, size_t>> payoffs; // hits, word size
+	for (const auto& key : hash_list) {
+		Word word(key);
+		auto hits = m_word_hits.find(word.get_hash());
+		payoffs[key] = { hits == m_word_hits.end() ? 0 : hits->second, word.size() };
+	}
+	std::stable_sort(hash_list.begin(), hash_list.end(), [&payoffs](const std::string& a, const std::string& b) {
+		const auto& payoff_a = payoffs.at(a);
+		const auto& payoff_b = payoffs.at(b);
+		if (payoff_a.first != payoff_b.first) {
+			return payoff_a.first > payoff_b.first;
+		}
+		return payoff_a.second < payoff_b.second;
+	});
+}
+
+// Likely first: scales close (in ratio) to a scale that already gave detections, else to the middle of the range
+void RuneDetector::order_scale_factors_by_payoff(std::vector<double>& scale_factors, const std::vector<double>& confirmed_scale_factors) const
+{
+	if (scale_factors.empty()) {
+		return;
+	}
+	std::vector<double> references = confirmed_scale_factors;
+	references.insert(references.end(), m_scale_hits.begin(), m_scale_hits.end());
+	if (references.empty()) {
+		auto [min_factor, max_factor] = std::minmax_element(scale_factors.begin(), scale_factors.end());
+		references.push_back(std::sqrt(*min_factor * *max_factor));
+	}
+	auto distance = [&references](double scale_factor) {
+		double min_distance = std::numeric_limits<double>::max();
+		for (double reference : references) {
+			min_distance = (std::min)(min_distance, std::abs(std::log(scale_factor / reference)));
+		}
+		return min_distance;
+	};
+	std::stable_sort(scale_factors.begin(), scale_factors.end(), [&distance](double a, double b) {
+		return distance(a) < distance(b);
+	});
+}
+
+// Zone of a detected word where its translation is written (also blanked in the matched image)
+cv::Rect get_translation_zone(const cv::Rect& bounding_box)
+{
+	double text_relative_width = 98.0 / 100.0;
+	double text_relative_height = 70.0 / 100.0;
+	return cv::Rect(
+		bounding_box.x + ((1.0 - text_relative_width) / 2.0) * bounding_box.width,
+		bounding_box.y + ((1.0 - text_relative_height) / 2.0) * bounding_box.height, // Position below the rune
+		bounding_box.width * text_relative_width,
+		bounding_box.height * text_relative_height // Fixed height for the text zone
+	);
+}
+
+// Successive captures of the same scene: only the tiles whose content changed since the previous call are matched
+// again, the zones lying in the unchanged tiles are kept (the matching cost follows the changed area)
+bool RuneDetector::detect_words_incremental(cv::Mat& original_img, DetectionResult& detection_result, int adaptative_cycles, bool useGeneratedRunes)
+{
+	auto start_detection = std::chrono::steady_clock::now();
+	detection_result = DetectionResult();
+	if (original_img.empty()) {
+		std::cerr << "Error: Cannot detect words in an empty image." << std::endl;
+		return false;
+	}
+
+	auto hash_tiles = [](const cv::Mat& image, std::vector<uint64_t>& tile_hashes) {
+		cv::Mat gray;
+		if (image.channels() == 1) {
+			gray = image;
+		}
+		else {
+			cv::cvtColor(image, gray, cv::COLOR_BGR2GRAY);
+		}
+		return compute_tile_hashes(gray, INCREMENTAL_TILE_SIZE, tile_hashes);
+	};
+
+	// a new scene (first capture or other size) is detected as a whole
+	bool new_scene = m_page_state.tile_hashes.empty() || m_page_state.size != original_img.size();
+	std::vector<uint64_t> tile_hashes;
+	std::vector<cv::Rect> dirty_regions;
+	double dirty_ratio = 1.0;
+	if (!new_scene) {
+		// the page angle of the previous captures is reused: the tiles of the next captures stay comparable
+		cv::Mat capture;
+		if (m_detection_options.deskew && m_page_state.skew_angle != 0.0) {
+			capture = original_img.clone();
+			rotate_image(original_img, m_page_state.skew_angle);
+		}
+		if (!hash_tiles(original_img, tile_hashes) ||
+			!find_dirty_regions(m_page_state.tile_hashes, tile_hashes, original_img.size(), INCREMENTAL_TILE_SIZE, dirty_regions, dirty_ratio)) {
+			return false;
+		}
+		// most of the page changed (other page, moved camera): a new scene, whose angle is estimated again
+		if (dirty_ratio >= INCREMENTAL_NEW_SCENE_RATIO) {
+			new_scene = true;
+			if (!capture.empty()) {
+				capture.copyTo(original_img);
+			}
+		}
+	}
+	if (new_scene) {
+		m_page_state = PageState();
+		if (m_detection_options.deskew) {
+			deskew_image(original_img, m_page_state.skew_angle);
+		}
+		if (!hash_tiles(original_img, tile_hashes)) {
+			return false;
+		}
+		dirty_regions = { cv::Rect(0, 0, original_img.cols, original_img.rows) };
+		dirty_ratio = 1.0;
+	}
+
+	// zones touching a changed tile are detected again, the others are kept
+	std::vector<RuneZone> zones;
+	for (const auto& zone : m_page_state.zones) {
+		bool dirty = std::any_of(dirty_regions.begin(), dirty_regions.end(), [&zone](const cv::Rect& dirty_region) {
+			return (zone.rect & dirty_region).area() > 0;
+		});
+		if (!dirty) {
+			zones.push_back(zone);
+		}
+	}
+	size_t nb_kept_zones = zones.size();
+	std::vector<RuneZone> uncertain_zones;
+	std::copy_if(m_page_state.uncertain_zones.begin(), m_page_state.uncertain_zones.end(), std::back_inserter(uncertain_zones), [&dirty_regions](const RuneZone& zone) {
+		return std::none_of(dirty_regions.begin(), dirty_regions.end(), [&zone](const cv::Rect& dirty_region) {
+			return (zone.rect & dirty_region).area() > 0;
+		});
+	});
+
+	// the dirty regions (grown by the pattern size) are matched on the capture before any translation is drawn,
+	// the kept translations are drawn afterwards so they are never matched
+	if (!dirty_regions.empty()) {
+		DetectionResult dirty_result;
+		if (!detect_words(original_img, dirty_result, DetectionBudget(), adaptative_cycles, false, useGeneratedRunes, &dirty_regions)) {
+			return false;
+		}
+		zones.insert(zones.end(), dirty_result.zones.begin(), dirty_result.zones.end());
+		uncertain_zones.insert(uncertain_zones.end(), dirty_result.uncertain_zones.begin(), dirty_result.uncertain_zones.end());
+	}
+	for (size_t i = 0; i < nb_kept_zones; i++) {
+		m_annotation_renderer.draw(original_img, m_dictionary->translate(zones[i].word), get_translation_zone(zones[i].rect));
+	}
+	order_rune_zones(zones, detection_result.zones);
+	order_rune_zones(uncertain_zones, detection_result.uncertain_zones);
+
+	m_page_state.size = original_img.size();
+	m_page_state.tile_hashes = tile_hashes;
+	m_page_state.zones = detection_result.zones;
+	m_page_state.uncertain_zones = detection_result.uncertain_zones;
+
+	detection_result.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_detection).count();
+	std::cout << "Incremental detection: " << dirty_ratio * 100.0 << "% of the page changed (" << dirty_regions.size() << " regions), "
+		<< nb_kept_zones << " zones kept, " << detection_result.zones.size() << " zones in " << detection_result.elapsed_ms << " ms" << std::endl;
+	return true;
+}
+
+// Localised outputs of one detection: the translations of every dictionary are drawn over the detected zones of the
+// (not annotated) page, the text patches are shared between the languages through the renderer cache
+bool RuneDetector::annotate_languages(const cv::Mat& page, const std::vector<RuneZone>& zones, const std::vector<fs::path>& dictionary_files,
+	const fs::path& output_folder, const std::string& output_stem, std::vector<fs::path>& output_files)
+{
+	std::vector<Annotation> annotations;
+	for (const auto& zone : zones) {
+		annotations.push_back({ zone.word, get_translation_zone(zone.rect) });
+	}
+	return m_annotation_renderer.render_languages(page, annotations, dictionary_files, output_folder, output_stem, output_files);
+}
+
+// Anytime detection: with a limited budget the (word, scale) matches are done by expected payoff and the budget is
+// checked before each of them (and before the preprocessing), so the zones found so far are returned when the deadline
+// is reached or the detection is cancelled. Without a budget the dictionary order is kept: the same page always gives
+// the same words, whatever was detected before.
+// With dirty_regions (see detect_words_incremental) only these regions are searched and the page is not deskewed.
+bool RuneDetector::detect_words(cv::Mat& original_img, DetectionResult& detection_result, const DetectionBudget& budget, int adaptative_cycles, bool debug_mode, bool useGeneratedRunes, const std::vector<cv::Rect>* dirty_regions)
+{
+	auto start_detection = std::chrono::steady_clock::now();
+	detection_result = DetectionResult();
+	bool payoff_order = budget.is_limited();
+	auto stop_before_matching = [&]() {
+		if (!budget.exhausted()) {
+			return false;
+		}
+		detection_result.complete = false;
+		detection_result.completeness = 0.0;
+		detection_result.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_detection).count();
+		std::cout << "Detection stopped by its budget before matching, after " << detection_result.elapsed_ms << " ms" << std::endl;
+		return true;
+	};
+	if (stop_before_matching()) {
+		return true;
+	}
 
     //	// detect straight lines main color (dark or bright)
 	//std::vector<cv::Vec4i> detectedLines;
@@ -495,19 +993,104 @@ bool RuneDetector::detect_words(cv::Mat& original_img, std::vector<Word>& detect
 
 
 
+	// rotated photos / screenshots: one warp of the page instead of rotated templates
+	// (the translations are drawn on the straightened page)
+	if (m_detection_options.deskew && dirty_regions == nullptr) {
+		double skew_angle = 0.0;
+		if (deskew_image(original_img, skew_angle) && skew_angle != 0.0) {
+			std::cout << "Page deskewed by " << skew_angle << " degrees" << std::endl;
+		}
+		if (stop_before_matching()) {
+			return true;
+		}
+	}
+
 	//const auto ADAPTATIVE_DETECTIONS_THRESHOLD = 5;
 	std::vector<double> scale_factors, adapt_scale_factors_confirmed;
 	int adapt_detections = 0;
 	cv::Mat image;
-	cv::cvtColor(original_img, image, cv::COLOR_BGR2GRAY);
+	if (original_img.channels() == 1) {
+		// gray ingest (see load_gray_image): matching works on a copy since detected zones are blanked
+		image = original_img.clone();
+	}
+	else {
+		cv::cvtColor(original_img, image, cv::COLOR_BGR2GRAY);
+	}
 	image.convertTo(image, CV_8U);
 	std::vector<RuneZone> detected_runes_zones;
 
+	// restrict the matching to the tiles that may contain text (illustrations are skipped)
+	cv::Rect image_rect(0, 0, image.cols, image.rows);
+	std::vector<cv::Rect> search_regions;
+	double skipped_ratio = 0.0;
+	if (dirty_regions != nullptr) {
+		// only the changed regions, classified one by one
+		double searched_area = 0.0;
+		for (const auto& dirty_region : *dirty_regions) {
+			cv::Rect region = dirty_region & image_rect;
+			std::vector<cv::Rect> region_text_regions;
+			double region_skipped_ratio = 0.0;
+			if (!m_detection_options.text_regions_only || !find_text_regions(image(region), region_text_regions, region_skipped_ratio, m_detection_options.text_tile_size, debug_mode)) {
+				region_text_regions = { cv::Rect(0, 0, region.width, region.height) };
+			}
+			for (const auto& text_region : region_text_regions) {
+				search_regions.push_back(text_region + region.tl());
+				searched_area += text_region.area();
+			}
+		}
+		skipped_ratio = 1.0 - searched_area / image_rect.area();
+	}
+	else if (!m_detection_options.text_regions_only || !find_text_regions(image, search_regions, skipped_ratio, m_detection_options.text_tile_size, debug_mode)) {
+		search_regions = { image_rect };
+		skipped_ratio = 0.0;
+	}
+	if (stop_before_matching()) {
+		return true;
+	}
+	std::chrono::high_resolution_clock::duration match_duration(0);
+	double matched_area = 0.0, full_area = 0.0; // correlated pixels, page pixels, summed over the (word, scale) matches
+
+	// chamfer backend: the distance transform of the page is computed once for all the words and scales
+	ChamferMatcher chamfer_matcher;
+	bool use_chamfer = m_detection_options.backend == MatchingBackend::Chamfer && chamfer_matcher.set_image(image);
+	if (use_chamfer && stop_before_matching()) {
+		return true;
+	}
+	double detection_threshold = m_detection_options.detection_threshold > 0.0 ? m_detection_options.detection_threshold
+		: (use_chamfer ? CHAMFER_DETECTION_THRESHOLD : RUNE_DETECTION_THRESHOLD);
+	// every match over the hypothesis threshold is scored, the detections and the score peaks below the detection threshold
+	bool keep_hypotheses = m_detection_options.top_k > 0;
+	double hypothesis_threshold = (std::min)(m_detection_options.hypothesis_threshold, detection_threshold);
+	std::vector<WordHypothesis> hypotheses;
+	// detected zones are blanked so they are not found again, but every word is scored as a hypothesis on the page as it
+	// was: near the blanked zones the hypotheses are matched again on an unblanked copy
+	cv::Mat unblanked_image;
+	ChamferMatcher unblanked_chamfer_matcher;
+	std::vector<cv::Rect> blanked_zones;
+	if (keep_hypotheses) {
+		unblanked_image = image.clone();
+		if (use_chamfer) {
+			unblanked_chamfer_matcher.set_image(image);
+		}
+	}
+	int scale_factor_steps = use_chamfer ? CHAMFER_SCALE_FACTOR_STEPS : RUNE_SCALE_FACTOR_STEPS;
+
 	// detect word in image
 	std::vector<std::string> hash_list;
 	this->m_dictionary->get_hash_list(hash_list);
+	if (payoff_order) {
+		order_words_by_payoff(hash_list);
+	}
+	size_t nb_words_done = 0;
+	double current_word_done = 0.0; // part of the scales done for the word being matched
+	bool budget_exhausted = false;
 	for(const auto& key : hash_list) {
 	//for (const auto& [key, pattern_image_original] : m_rune_images) {
+		if (budget.exhausted()) {
+			budget_exhausted = true;
+			break;
+		}
+		current_word_done = 0.0;
 
 		cv::Mat& pattern_image_original = m_rune_images[key];
 		auto word = Word(key);
@@ -524,14 +1107,31 @@ bool RuneDetector::detect_words(cv::Mat& original_img, std::vector<Word>& detect
 			scale_factors = adapt_scale_factors_confirmed;
 		}
 		else {
-			generate_scale_factors(image, pattern_image_original, scale_factors);
+			scale_factors.clear();
+			generate_scale_factors(image, pattern_image_original, scale_factors, scale_factor_steps);
+		}
+		if (payoff_order) {
+			order_scale_factors_by_payoff(scale_factors, adapt_scale_factors_confirmed);
 		}
 
-
-		for (const auto& scale_factor : scale_factors) {
+		for (size_t scale_index = 0; scale_index < scale_factors.size(); scale_index++) {
+			double scale_factor = scale_factors[scale_index];
+			if (budget.exhausted()) {
+				budget_exhausted = true;
+				break;
+			}
+			current_word_done = double(scale_index) / scale_factors.size();
 
 			cv::Mat pattern_image;
-			if (useGeneratedRunes) {
+			ChamferTemplate chamfer_template;
+			if (use_chamfer) {
+				// sparse center lines, tolerant to the stroke tickness: no PNG / generated variants
+				if (!ChamferMatcher::make_template(word, scale_factor, chamfer_template)) {
+					continue;
+				}
+				pattern_image = cv::Mat(chamfer_template.size, CV_8U, cv::Scalar(0));
+			}
+			else if (useGeneratedRunes) {
 				// Generate rune image on the fly with correct target size 
 				auto size = RUNE_DEFAULT_SIZE * scale_factor;
 				double thickness = (std::max)((double)1.0f, RUNE_SEGMENT_DRAW_DEFAULT_TICKNESS * RUNE_DEFAULT_SIZE.height * scale_factor);
@@ -561,72 +1161,146 @@ bool RuneDetector::detect_words(cv::Mat& original_img, std::vector<Word>& detect
 			//	cv::imshow("Try to find word : " + word.get_hash(), pattern_image);
 			//}
 
-			double pattern_area = pattern_image.rows * pattern_image.cols;
+			// top left positions of the template: a word whose separator lies in a region may start up to one pattern
+			// size before it. The positions of neighbour regions overlap, they are merged so each one is scored once
+			cv::Rect position_rect(0, 0, image.cols - pattern_image.cols + 1, image.rows - pattern_image.rows + 1);
+			std::vector<cv::Rect> positions, position_regions;
+			for (const auto& text_region : search_regions) {
+				positions.push_back(cv::Rect(text_region.x - pattern_image.cols, text_region.y - pattern_image.rows,
+					text_region.width + pattern_image.cols + 1, text_region.height + pattern_image.rows + 1) & position_rect);
+			}
+			merge_rects(positions, position_regions);
+			full_area += image_rect.area();
+
+			for (const auto& position_region : position_regions) {
+				// the scan skips the result border (score peak neighbours): the ROI is grown by it
+				cv::Rect search_roi = cv::Rect(position_region.x - RUNE_MATCH_RESULT_BORDER, position_region.y - RUNE_MATCH_RESULT_BORDER,
+					position_region.width + pattern_image.cols - 1 + 2 * RUNE_MATCH_RESULT_BORDER, position_region.height + pattern_image.rows - 1 + 2 * RUNE_MATCH_RESULT_BORDER) & image_rect;
+				if (search_roi.width < pattern_image.cols || search_roi.height < pattern_image.rows) {
+					continue;
+				}
+				matched_area += search_roi.area();
+
+				// Create the result matrix
+				int result_cols = search_roi.width - pattern_image.cols + 1;
+				int result_rows = search_roi.height - pattern_image.rows + 1;
+				cv::Mat result;
+				result.create(result_rows, result_cols, CV_32FC1); // Result is float type
+
+				auto start_match = std::chrono::high_resolution_clock::now();
+				if (use_chamfer) {
+					if (!chamfer_matcher.match(chamfer_template, search_roi, result)) {
+						continue;
+					}
+				}
+				else {
+					cv::matchTemplate(image(search_roi), pattern_image, result, cv::TM_CCOEFF_NORMED);
+				}
+
+				// scores of the hypotheses: the positions whose template overlaps a blanked zone are matched again unblanked
+				// (elsewhere the window holds the same pixels, the scores are the same)
+				cv::Mat hypothesis_result = result;
+				if (keep_hypotheses && !blanked_zones.empty()) {
+					cv::Rect result_rect(search_roi.x, search_roi.y, result_cols, result_rows);
+					std::vector<cv::Rect> blanked_positions, blanked_regions;
+					for (const auto& blanked_zone : blanked_zones) {
+						cv::Rect blanked_position = cv::Rect(blanked_zone.x - pattern_image.cols + 1, blanked_zone.y - pattern_image.rows + 1,
+							blanked_zone.width + pattern_image.cols - 1, blanked_zone.height + pattern_image.rows - 1) & result_rect;
+						if (blanked_position.area() > 0) {
+							blanked_positions.push_back(blanked_position);
+						}
+					}
+					merge_rects(blanked_positions, blanked_regions);
+					if (!blanked_regions.empty()) {
+						hypothesis_result = result.clone();
+					}
+					for (const auto& blanked_region : blanked_regions) {
+						cv::Rect unblanked_roi(blanked_region.x, blanked_region.y, blanked_region.width + pattern_image.cols - 1, blanked_region.height + pattern_image.rows - 1);
+						cv::Mat unblanked_result;
+						if (use_chamfer) {
+							if (!unblanked_chamfer_matcher.match(chamfer_template, unblanked_roi, unblanked_result)) {
+								continue;
+							}
+						}
+						else {
+							cv::matchTemplate(unblanked_image(unblanked_roi), pattern_image, unblanked_result, cv::TM_CCOEFF_NORMED);
+						}
+						unblanked_result.copyTo(hypothesis_result(blanked_region - result_rect.tl()));
+						matched_area += unblanked_roi.area();
+					}
+				}
+				match_duration += std::chrono::high_resolution_clock::now() - start_match;
 
-			// Create the result matrix
-			int result_cols = image.cols - pattern_image.cols + 1;
-			int result_rows = image.rows - pattern_image.rows + 1;
-			cv::Mat result;
-			result.create(result_rows, result_cols, CV_32FC1); // Result is float type
+				for (int i = RUNE_MATCH_RESULT_BORDER; i < result_cols - RUNE_MATCH_RESULT_BORDER; i++) {
+					for (int j = RUNE_MATCH_RESULT_BORDER; j < result_rows - RUNE_MATCH_RESULT_BORDER; j++) {
+						float score = result.at<float>(j, i);
 
-			cv::matchTemplate(image, pattern_image, result, cv::TM_CCOEFF_NORMED);
+						// keep correlation even is not good enough
+						if (score > best_scale_corr) {
+							best_scale_factor = scale_factor;
+							best_scale_corr = score;
+						}
 
-			for (int i = 2; i < result_cols - 2; i++) {
-				for (int j = 2; j < result_rows - 2; j++) {
+						// one hypothesis per score peak (detected or not), scored on the unblanked page
+						float hypothesis_score = hypothesis_result.at<float>(j, i);
+						if (keep_hypotheses && hypothesis_score > hypothesis_threshold && is_score_peak(hypothesis_result, i, j)) {
+							hypotheses.push_back({ word, hypothesis_score, scale_factor, cv::Rect(search_roi.x + i, search_roi.y + j, pattern_image.cols, pattern_image.rows) });
+						}
 
-					// keep correlation even is not good enough
-					if (result.at<float>(j, i) > best_scale_corr) {
-						best_scale_factor = scale_factor;
-						best_scale_corr = result.at<float>(j, i);
-					}
+						if (score > detection_threshold) {
+							if (adaptative_cycles > 0) {
+								adapt_detections++;
+								if (std::find(adapt_scale_factors_confirmed.begin(), adapt_scale_factors_confirmed.end(), scale_factor) == adapt_scale_factors_confirmed.end()) {
+									adapt_scale_factors_confirmed.push_back(scale_factor);
+								}
+							}
 
-					if (result.at<float>(j, i) > RUNE_DETECTION_THRESHOLD) {
-						if (adaptative_cycles > 0) {
-							adapt_detections++;
-							if (std::find(adapt_scale_factors_confirmed.begin(), adapt_scale_factors_confirmed.end(), scale_factor) == adapt_scale_factors_confirmed.end()) {
-								adapt_scale_factors_confirmed.push_back(scale_factor);
+							cv::Rect bounding_box = cv::Rect(search_roi.x + i, search_roi.y + j, pattern_image.cols, pattern_image.rows);
+							RuneZone zone;
+							zone.word = word;
+							zone.rect = bounding_box;
+							zone.score = score;
+							zone.scale_factor = scale_factor;
+							detected_runes_zones.push_back(zone);
+
+							cv::Rect text_zone = get_translation_zone(bounding_box);
+							std::string translation = m_dictionary->translate(word);
+
+							//if (overwriteOnDetection) {
+								// overwrite to prevent from extra detection
+								cv::rectangle(image, text_zone, cv::Scalar(0, 0, 0), cv::FILLED);
+								chamfer_matcher.erase(text_zone);
+								if (keep_hypotheses) {
+									// the neighbour positions of a detection blank about the same zone: kept as one bounding rect
+									auto blanked_zone = std::find_if(blanked_zones.begin(), blanked_zones.end(), [&text_zone](const cv::Rect& zone) {
+										return (zone & text_zone).area() > 0;
+									});
+									if (blanked_zone != blanked_zones.end()) {
+										*blanked_zone = (*blanked_zone | text_zone) & image_rect;
+									}
+									else {
+										blanked_zones.push_back(text_zone & image_rect);
+									}
+								}
+							//}
+							m_annotation_renderer.draw(original_img, translation, text_zone);
+
+							//debug_mode = true;
+							//if (debug_mode) {
+							//	// overwrite to prevent from extra detection
+							//	cv::rectangle(image, text_zone, bgColor, cv::FILLED);
+							//	cv::imshow("new", image);
+							//	cv::imshow("original", original_img);
+							//	cv::waitKey(0);
+							//	cv::destroyAllWindows();
+							//}
+							if (debug_mode) {
+								cv::imshow("translation", original_img);
+								cv::waitKey(1);
 							}
 						}
-
-						cv::Rect bounding_box = cv::Rect(i, j, pattern_image.cols, pattern_image.rows);
-						detected_runes_zones.push_back({ word, bounding_box });
-
-						double text_relative_width = 98.0 / 100.0;
-						double text_relative_height = 70.0 / 100.0;
-						cv::Rect text_zone = cv::Rect(
-							bounding_box.x + ((1.0 - text_relative_width) / 2.0) * bounding_box.width,
-							bounding_box.y + ((1.0 - text_relative_height) / 2.0) * bounding_box.height, // Position below the rune
-							bounding_box.width * text_relative_width,
-							bounding_box.height * text_relative_height // Fixed height for the text zone
-						);
-						std::string translation = m_dictionary->translate(word);
-
-						int fontFace = 0;
-						double tickness = 1;
-						int padding = 0;
-						auto fontColor = cv::Scalar(255, 255, 255);
-						auto bgColor = cv::Scalar(0, 0, 0);
-
-						//if (overwriteOnDetection) {
-							// overwrite to prevent from extra detection
-							cv::rectangle(image, text_zone, bgColor, cv::FILLED);
-						//}
-						draw_text_in_rect(original_img, translation, text_zone, fontFace, 1.0, tickness, fontColor, bgColor, padding);
-
-						//debug_mode = true;
-						//if (debug_mode) {
-						//	// overwrite to prevent from extra detection
-						//	cv::rectangle(image, text_zone, bgColor, cv::FILLED);
-						//	cv::imshow("new", image);
-						//	cv::imshow("original", original_img);
-						//	cv::waitKey(0);
-						//	cv::destroyAllWindows();
-						//}
-						cv::imshow("translation", original_img);
-						cv::waitKey(1);
 					}
 				}
-				std::cout << std::endl;
 			}
 		}
 		if (debug_mode) {
@@ -638,54 +1312,65 @@ bool RuneDetector::detect_words(cv::Mat& original_img, std::vector<Word>& detect
 			cv::waitKey(500); // Wait for a key press to close the window
 			cv::destroyAllWindows();
 		}
+		if (budget_exhausted) {
+			break;
+		}
+		nb_words_done++;
 	}
 
-	// Sort the character zones
-	std::sort(detected_runes_zones.begin(), detected_runes_zones.end(), compareCharacterZones);
-
-	std::vector<RuneZone> processed_rune_zones = detected_runes_zones;
-
-	//// --- Process runes at the same position ---
-
-	//std::vector<RuneZone> processed_rune_zones; // Renamed vector
-	//if (!detected_runes_zones.empty()) {
-	//	processed_rune_zones.push_back(detected_runes_zones[0]); // Add the first rune
-
-	//	for (size_t i = 1; i < detected_runes_zones.size(); ++i) {
-	//		// Check if the current rune is at the exact same position as the last processed one
-	//		if (detected_runes_zones[i] == processed_rune_zones.back()) {
-	//			std::cout << "Detected rune '" << detected_runes_zones[i].word.get_hash()
-	//				<< "' at the same position as '" << processed_rune_zones.back().word.get_hash()
-	//				<< "' (Rect: " << detected_runes_zones[i].rect.x << "," << detected_runes_zones[i].rect.y << "). ";
-
-	//			std::cout << "Skipping duplicate, keeping '" << processed_rune_zones.back().word.get_hash() << "'.\n";
+	detection_result.matched_ratio = full_area > 0.0 ? matched_area / full_area : 0.0;
+	std::cout << "Matching time: " << std::chrono::duration<double, std::milli>(match_duration).count() << " ms ("
+		<< search_regions.size() << " search regions, " << skipped_ratio * 100.0 << "% of the tiles skipped, "
+		<< detection_result.matched_ratio * 100.0 << "% of the image area matched)" << std::endl;
+
+	// Remove duplicate hits and sort the zones in reading order
+	std::vector<RuneZone>& processed_rune_zones = detection_result.zones;
+	order_rune_zones(detected_runes_zones, processed_rune_zones);
+
+	// payoff statistics for the next budgeted detections, once per accepted zone
+	for (const auto& zone : processed_rune_zones) {
+		m_word_hits[zone.word.get_hash()]++;
+		if (std::find(m_scale_hits.begin(), m_scale_hits.end(), zone.scale_factor) == m_scale_hits.end()) {
+			m_scale_hits.push_back(zone.scale_factor);
+			if (m_scale_hits.size() > RUNE_SCALE_HITS_HISTORY) {
+				m_scale_hits.erase(m_scale_hits.begin());
+			}
+		}
+	}
+	if (keep_hypotheses) {
+		attach_word_hypotheses(processed_rune_zones, hypotheses, m_detection_options.top_k);
+		std::vector<RuneZone> uncertain_zones;
+		find_uncertain_zones(processed_rune_zones, hypotheses, uncertain_zones, m_detection_options.top_k);
+		order_rune_zones(uncertain_zones, detection_result.uncertain_zones);
+	}
 
-	//		}
-	//		else {
-	//			// If not at the same position, add it to the processed list
-	//			processed_rune_zones.push_back(detected_runes_zones[i]);
-	//		}
-	//	}
-	//}
+	detection_result.complete = !budget_exhausted;
+	detection_result.completeness = hash_list.empty() || !budget_exhausted ? 1.0 : (nb_words_done + current_word_done) / hash_list.size();
+	detection_result.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_detection).count();
+	if (budget_exhausted) {
+		std::cout << "Detection stopped by its budget after " << detection_result.elapsed_ms << " ms ("
+			<< detection_result.completeness * 100.0 << "% of the matches done)" << std::endl;
+	}
 
 	// Print the sorted characters to demonstrate the order
 	std::cout << "Runes in occidental reading order:\n";
 	if (!processed_rune_zones.empty()) {
-		int current_line_y = processed_rune_zones[0].rect.y;
-		const int verticalTolerance = 10; // Same tolerance as in comparison function
-
 		for (size_t i = 0; i < processed_rune_zones.size(); ++i) {
-			// Check if we're starting a new line (with tolerance)
-			if (i > 0 && std::abs(processed_rune_zones[i].rect.y - current_line_y) >= verticalTolerance) {
-				current_line_y = processed_rune_zones[i].rect.y;
+			// Check if we're starting a new line
+			if (i > 0 && processed_rune_zones[i].line != processed_rune_zones[i - 1].line) {
+				std::cout << "\n";
+			}
+			else if (i > 0) {
+				std::cout << " ";
 			}
 			std::cout << processed_rune_zones[i].word.get_hash();
-			detected_words.push_back(Word(processed_rune_zones[i].word));
 		}
 		std::cout << "\n";
 	}
 
-	cv::destroyAllWindows();
+	if (debug_mode) {
+		cv::destroyAllWindows();
+	}
 	return true;
 }
 
@@ -767,10 +1452,9 @@ void RuneDetector::displayMatProperties(const cv::Mat& mat, const std::string& n
 	std::cout << "--------------------------" << std::endl;
 }
 
-bool RuneDetector::generate_scale_factors(const cv::Mat& image, const cv::Mat& pattern, std::vector<double>& scale_factors)
+bool RuneDetector::generate_scale_factors(const cv::Mat& image, const cv::Mat& pattern, std::vector<double>& scale_factors, int nb_values)
 {
 	// TODO: improve this method to use the size of the rune in the image to determine the scale factors
-	int nb_values = 20;
 
 	// ex: MIN SIZE rune 20x42 pix on a 1680x1280 screenshot of a page of the manual (horizontal: 0.011904761 vertical: 0.0328125 )
 	// ex: MAX SIZE rune 16x27 pix on a 342x255   screenshot of a page of the manual (horizontal: 0.046783626 vertical: 0.10588235)
@@ -815,14 +1499,13 @@ int RuneDetector::image_detection(const fs::path& image_file, const fs::path& ou
 
 	const auto RUNES_FOLDER = fs::path("../../../data/runes");
 
-	auto original_img = cv::imread(image_file.string(), cv::IMREAD_COLOR_BGR);
-	if (original_img.empty()) {
+	// decode at about the detection resolution, in color for the annotated output (matched in gray)
+	cv::Mat original_img;
+	if (!load_color_image(image_file, original_img, MAX_IMAGE_DETECTION_DIMENSIONS)) {
 		std::cerr << "Error: Could not load rune image from " << image_file << std::endl;
 		return false;
 	}
 
-	resize_to_fit_max_bounds(original_img, MAX_IMAGE_DETECTION_DIMENSIONS);
-
     std::vector<Word> detected_words;
     this->detect_words(original_img, detected_words, adaptative_cycles, debug_mode, generatedRunes, true);
 
@@ -0,0 +1,170 @@
+#include "stft.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <numbers>
+
+void Stft::make_window(WindowType type, size_t size, std::vector<double>& window)
+{
+    window.assign(size, 1.0);
+    if (size < 2 || type == WindowType::Rectangular) {
+        return;
+    }
+    for (size_t j = 0; j < size; j++) {
+        double phase = 2 * std::numbers::pi * j / (size - 1);
+        switch (type) {
+        case WindowType::Hann:
+            window[j] = 0.5 * (1 - cos(phase));
+            break;
+        case WindowType::Hamming:
+            window[j] = 0.54 - 0.46 * cos(phase);
+            break;
+        case WindowType::Blackman:
+            window[j] = 0.42 - 0.5 * cos(phase) + 0.08 * cos(2 * phase);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+Stft::FrameSlot& Stft::FrameSlot::operator=(const FrameSlot& other)
+{
+    samples = other.samples;
+    magnitudes = other.magnitudes;
+    frame = other.frame;
+    bind();
+    return *this;
+}
+
+void Stft::FrameSlot::bind()
+{
+    frame.samples = samples.empty() ? nullptr : samples.data();
+    frame.magnitudes = magnitudes.empty() ? nullptr : magnitudes.data();
+}
+
+bool Stft::init(const StftConfig& config)
+{
+    m_window_size = 0;
+    if (config.window_size == 0 || config.ring_size == 0) {
+        std::cerr << "Error: STFT window size and ring size must be positive." << std::endl;
+        return false;
+    }
+    size_t fft_size = config.fft_size > 0 ? config.fft_size : FftPlan<double>::next_power_of_two(config.window_size);
+    if (fft_size < config.window_size) {
+        std::cerr << "Error: STFT FFT size " << fft_size << " is smaller than the window (" << config.window_size << " samples)." << std::endl;
+        return false;
+    }
+    if (!config.compute_magnitudes) {
+        m_fft_plan = FftPlan<double>();
+    }
+    else if (!m_fft_plan.init(fft_size)) {
+        return false;
+    }
+
+    m_hop_size = config.hop_size > 0 ? config.hop_size : config.window_size;
+    m_compute_magnitudes = config.compute_magnitudes;
+    make_window(config.window, config.window_size, m_window);
+    m_history.assign(config.window_size, 0.0f);
+    m_slots.assign(config.ring_size, FrameSlot());
+    for (auto& slot : m_slots) {
+        slot.samples.assign(config.window_size, 0.0f);
+        if (m_compute_magnitudes) {
+            slot.magnitudes.assign(fft_size / 2 + 1, 0.0);
+        }
+        slot.bind();
+    }
+    if (m_compute_magnitudes) {
+        m_windowed.assign(fft_size, 0.0);
+        m_spectrum.assign(fft_size / 2 + 1, FftPlan<double>::Complex());
+    }
+    else {
+        m_windowed.clear();
+        m_spectrum.clear();
+    }
+    m_window_size = config.window_size;
+    reset();
+    return true;
+}
+
+void Stft::reset()
+{
+    m_nb_samples = 0;
+    m_next_frame_start = 0;
+    m_nb_frames = 0;
+}
+
+size_t Stft::push(const float* samples, size_t count, const std::function<void(const StftFrame&)>& on_frame)
+{
+    if (!is_valid()) {
+        return 0;
+    }
+    size_t nb_frames_before = m_nb_frames;
+    while (count > 0) {
+        // samples before the next frame (hop larger than the window) are never read
+        if (m_nb_samples < m_next_frame_start) {
+            size_t skipped = (std::min)(count, m_next_frame_start - m_nb_samples);
+            samples += skipped;
+            count -= skipped;
+            m_nb_samples += skipped;
+            continue;
+        }
+
+        // copy up to the end of the next frame, in at most two pieces of the ring
+        size_t frame_end = m_next_frame_start + m_window_size;
+        size_t nb_copied = (std::min)(count, frame_end - m_nb_samples);
+        size_t done = 0;
+        while (done < nb_copied) {
+            size_t position = (m_nb_samples + done) % m_window_size;
+            size_t piece = (std::min)(nb_copied - done, m_window_size - position);
+            std::memcpy(m_history.data() + position, samples + done, piece * sizeof(float));
+            done += piece;
+        }
+        samples += nb_copied;
+        count -= nb_copied;
+        m_nb_samples += nb_copied;
+
+        if (m_nb_samples == frame_end) {
+            emit_frame(on_frame);
+            m_next_frame_start += m_hop_size;
+        }
+    }
+    return m_nb_frames - nb_frames_before;
+}
+
+void Stft::emit_frame(const std::function<void(const StftFrame&)>& on_frame)
+{
+    FrameSlot& slot = m_slots[m_nb_frames % m_slots.size()];
+
+    // the oldest sample of the frame is where the next one would be written
+    size_t oldest = m_nb_samples % m_window_size;
+    std::memcpy(slot.samples.data(), m_history.data() + oldest, (m_window_size - oldest) * sizeof(float));
+    std::memcpy(slot.samples.data() + (m_window_size - oldest), m_history.data(), oldest * sizeof(float));
+
+    if (m_compute_magnitudes) {
+        for (size_t j = 0; j < m_window_size; j++) {
+            m_windowed[j] = slot.samples[j] * m_window[j];
+        }
+        m_fft_plan.forward_real(m_windowed.data(), m_spectrum.data());
+        for (size_t k = 0; k < m_spectrum.size(); k++) {
+            slot.magnitudes[k] = std::abs(m_spectrum[k]);
+        }
+    }
+
+    slot.frame.index = m_nb_frames;
+    slot.frame.start = m_next_frame_start;
+    m_nb_frames++;
+    if (on_frame) {
+        on_frame(slot.frame);
+    }
+}
+
+const StftFrame* Stft::get_frame(size_t age) const
+{
+    if (age >= (std::min)(m_nb_frames, m_slots.size())) {
+        return nullptr;
+    }
+    return &m_slots[(m_nb_frames - 1 - age) % m_slots.size()].frame;
+}
@@ -4,6 +4,7 @@
 #include <iostream>
 #include <vector>
 #include <queue>
+#include <set>
 #include <filesystem>
 #include <string>
 #include <cstdint>
@@ -13,10 +14,18 @@
 #include "arpeggiodetector.h"
 #include "rune.h"
 #include "runedetector.h"
+#include "runeclassifier.h"
+#include "pagegenerator.h"
 #include "word.h"
 #include "color_print.h"
 #include "note.h"
 #include "yin.h"
+#include "stft.h"
+#include "yindetector.h"
+#include "wavreader.h"
+#include "arpeggiostream.h"
+#include "resampler.h"
+#include "notequantizer.h"
 
 
 
@@ -130,6 +139,7 @@ void deleteFilesInFolder(const fs::path& folderPath) {
 ///////////////////////////////////////////////////////
 
 const auto RUNES_FOLDER = fs::path("../../../data/runes");
+const auto RUNES_CAPTURES_FOLDER = fs::path("../../../data/runes_captures");
 const auto DICTIONARY_ENG = fs::path("../../../lang/dictionary.eng.txt");
 
 
@@ -346,6 +356,149 @@ TEST_CASE("dictionary_image_gen", "[image]") {
 
 }
 
+TEST_CASE("order_rune_zones", "[image]") {
+
+    PRINT_TEST_HEADER("order_rune_zones");
+
+    // 3 lines of 4 words, every word detected twice (1 pixel shift) and lines slightly wavy
+    const int nb_lines = 3;
+    const int nb_words = 4;
+    const std::vector<std::string> hashes = { "2988-0304-03a0", "9317", "a08e-9f10", "23a3" };
+    auto make_zone = [](const std::string& hash, const cv::Rect& rect, double score) {
+        RuneZone zone;
+        zone.word = Word(hash);
+        zone.rect = rect;
+        zone.score = score;
+        return zone;
+    };
+    std::vector<RuneZone> zones;
+    for (int line = 0; line < nb_lines; line++) {
+        for (int w = 0; w < nb_words; w++) {
+            int y = line * 150 + (w % 2) * 6;
+            zones.push_back(make_zone(hashes[w], cv::Rect(w * 80, y, 46, 100), 0.0));
+            zones.push_back(make_zone(hashes[w], cv::Rect(w * 80 + 1, y + 1, 46, 100), 0.0));
+        }
+    }
+    // detections come in dictionary order, not reading order
+    std::reverse(zones.begin(), zones.end());
+
+    std::vector<RuneZone> ordered_zones;
+    CHECK(order_rune_zones(zones, ordered_zones));
+    REQUIRE(ordered_zones.size() == nb_lines * nb_words);
+    for (int i = 0; i < (int)ordered_zones.size(); i++) {
+        CHECK(ordered_zones[i].line == i / nb_words);
+        CHECK(ordered_zones[i].word.get_hash() == Word(hashes[i % nb_words]).get_hash());
+    }
+
+    // output must not depend on the input order
+    std::vector<RuneZone> ordered_zones_2;
+    std::rotate(zones.begin(), zones.begin() + 5, zones.end());
+    CHECK(order_rune_zones(zones, ordered_zones_2));
+    REQUIRE(ordered_zones_2.size() == ordered_zones.size());
+    for (size_t i = 0; i < ordered_zones.size(); i++) {
+        CHECK(ordered_zones[i].line == ordered_zones_2[i].line);
+        CHECK(ordered_zones[i].word.get_hash() == ordered_zones_2[i].word.get_hash());
+    }
+
+    // duplicates of other words: the best score survives whatever the input order, a huge zone does not merge the grid cells
+    std::vector<RuneZone> scored_zones;
+    for (int w = 0; w < nb_words; w++) {
+        scored_zones.push_back(make_zone(hashes[(w + 1) % nb_words], cv::Rect(w * 80 + 2, 1, 46, 100), 0.82));
+        scored_zones.push_back(make_zone(hashes[w], cv::Rect(w * 80, 0, 46, 100), 0.9));
+    }
+    const RuneZone huge_zone = make_zone(hashes[0], cv::Rect(0, 1000, 4000, 3000), 0.85);
+    scored_zones.push_back(huge_zone);
+    for (int order = 0; order < 2; order++) {
+        std::vector<RuneZone> ordered_scored_zones;
+        CHECK(order_rune_zones(scored_zones, ordered_scored_zones));
+        REQUIRE(ordered_scored_zones.size() == nb_words + 1);
+        for (int w = 0; w < nb_words; w++) {
+            CHECK(ordered_scored_zones[w].word.get_hash() == Word(hashes[w]).get_hash());
+            CHECK(ordered_scored_zones[w].score == 0.9);
+        }
+        CHECK(ordered_scored_zones[nb_words].rect == huge_zone.rect);
+        std::reverse(scored_zones.begin(), scored_zones.end());
+    }
+}
+
+TEST_CASE("word_hypotheses", "[image]") {
+
+    PRINT_TEST_HEADER("word_hypotheses");
+
+    // one region matched by 3 words (the detected one twice, at 2 scales), a second region below the detection threshold
+    std::vector<WordHypothesis> hypotheses = {
+        { Word("9317"), 0.85, 0.5, cv::Rect(100, 100, 46, 100) },
+        { Word("9317"), 0.92, 0.55, cv::Rect(101, 100, 47, 101) },
+        { Word("23a3"), 0.74, 0.5, cv::Rect(100, 101, 46, 100) },
+        { Word("a08e-9f10"), 0.65, 0.5, cv::Rect(99, 100, 46, 100) },
+        { Word("23a3"), 0.7, 0.5, cv::Rect(400, 100, 46, 100) },
+        { Word("9317"), 0.75, 0.5, cv::Rect(402, 99, 46, 100) },
+    };
+    RuneZone zone;
+    zone.word = Word("9317");
+    zone.rect = cv::Rect(101, 100, 47, 101);
+    zone.score = 0.92;
+    std::vector<RuneZone> zones = { zone };
+
+    CHECK(attach_word_hypotheses(zones, hypotheses, 2));
+    REQUIRE(zones[0].hypotheses.size() == 2);
+    CHECK(zones[0].hypotheses[0].word.get_hash() == Word("9317").get_hash());
+    CHECK(zones[0].hypotheses[0].score == 0.92);
+    CHECK(zones[0].hypotheses[0].scale_factor == 0.55);
+    CHECK(zones[0].hypotheses[1].word.get_hash() == Word("23a3").get_hash());
+
+    std::vector<RuneZone> uncertain_zones;
+    CHECK(find_uncertain_zones(zones, hypotheses, uncertain_zones));
+    REQUIRE(uncertain_zones.size() == 1);
+    CHECK(uncertain_zones[0].word.get_hash() == Word("9317").get_hash());
+    CHECK(uncertain_zones[0].score == 0.75);
+    REQUIRE(uncertain_zones[0].hypotheses.size() == 2);
+    CHECK(uncertain_zones[0].hypotheses[1].word.get_hash() == Word("23a3").get_hash());
+
+    // a stricter detection threshold keeps the regions it rejects as uncertain zones
+    auto image = cv::imread("../../../data/screenshots/manual_page_3_inverted.jpg", cv::IMREAD_COLOR_BGR);
+    REQUIRE(!image.empty());
+    resize_to_fit_max_bounds(image, MAX_IMAGE_DETECTION_DIMENSIONS);
+    RuneDictionary dictionary(DICTIONARY_ENG);
+    dictionary.load(DICTIONARY_ENG);
+
+    RuneDetector rune_detector(&dictionary);
+    DetectionResult result;
+    cv::Mat detection_image = image.clone();
+    REQUIRE(rune_detector.detect_words(detection_image, result, DetectionBudget(), 0, false, true));
+    for (const auto& detected_zone : result.zones) {
+        REQUIRE(!detected_zone.hypotheses.empty());
+        CHECK(detected_zone.hypotheses.size() <= RUNE_HYPOTHESES_TOP_K);
+        CHECK(detected_zone.score > RUNE_DETECTION_THRESHOLD);
+        CHECK(detected_zone.hypotheses[0].score >= detected_zone.score);
+        // one hypothesis per word, scored on the page before any zone was blanked
+        std::set<std::string> hypothesis_words;
+        for (const auto& hypothesis : detected_zone.hypotheses) {
+            CHECK(hypothesis_words.insert(hypothesis.word.get_hash()).second);
+        }
+    }
+
+    RuneDetector strict_rune_detector(&dictionary);
+    DetectionOptions strict_options;
+    strict_options.detection_threshold = 0.9;
+    strict_rune_detector.set_detection_options(strict_options);
+    DetectionResult strict_result;
+    cv::Mat strict_image = image.clone();
+    REQUIRE(strict_rune_detector.detect_words(strict_image, strict_result, DetectionBudget(), 0, false, true));
+    CHECK(strict_result.zones.size() <= result.zones.size());
+    size_t nb_recovered = 0;
+    for (const auto& detected_zone : result.zones) {
+        auto intersects = [&detected_zone](const RuneZone& other) { return (other.rect & detected_zone.rect).area() > 0; };
+        if (std::any_of(strict_result.zones.begin(), strict_result.zones.end(), intersects) ||
+            std::any_of(strict_result.uncertain_zones.begin(), strict_result.uncertain_zones.end(), intersects)) {
+            nb_recovered++;
+        }
+    }
+    CHECK(nb_recovered == result.zones.size());
+    printf("detection threshold %.2f: %zu zones, %zu uncertain zones\n", RUNE_DETECTION_THRESHOLD, result.zones.size(), result.uncertain_zones.size());
+    printf("detection threshold %.2f: %zu zones, %zu uncertain zones\n", strict_options.detection_threshold, strict_result.zones.size(), strict_result.uncertain_zones.size());
+}
+
 TEST_CASE("decode_word_image", "[image]") {
 
 
@@ -409,6 +562,45 @@ TEST_CASE("decode_word_image", "[image]") {
 }
 
 
+TEST_CASE("decode_word_grid", "[image][bench]") {
+
+    PRINT_TEST_HEADER("decode_word_grid");
+
+    const std::vector<std::string> hashes = { "0305-3c96", "3c96", "0305-3c96-0305-3c96-0305", "8c22-0305", "93b3-1eb4-0304-3c96" };
+    int nb_words = 0;
+    int nb_decoded = 0;
+    double decode_ms = 0.0;
+    for (double scale_factor : { 0.8, 1.0, 2.5 }) {
+        for (const auto& hash : hashes) {
+            Word word(hash);
+            cv::Mat word_image;
+            REQUIRE(word.generate_image(RUNE_DEFAULT_SIZE * scale_factor, RUNE_SEGMENT_DRAW_DEFAULT_TICKNESS * RUNE_DEFAULT_SIZE.height * scale_factor, word_image));
+            // not cropped: a few columns before and after the word
+            cv::copyMakeBorder(word_image, word_image, 0, 0, 2, 1, cv::BORDER_CONSTANT, cv::Scalar(0));
+
+            // the separator span gives the exact rune width
+            RuneGrid grid;
+            REQUIRE(Word::find_rune_grid(word_image, grid));
+            CHECK(grid.nb_runes == (int)word.size());
+            CHECK(std::abs(grid.rune_width - cvRound(RUNE_DEFAULT_SIZE.width * scale_factor)) <= 1.0);
+
+            Word decoded_word;
+            auto start_decode = std::chrono::high_resolution_clock::now();
+            REQUIRE(decoded_word.decode_image(word_image));
+            decode_ms += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_decode).count();
+            CHECK(decoded_word.get_hash() == word.get_hash());
+            nb_words++;
+            nb_decoded += decoded_word.get_hash() == word.get_hash() ? 1 : 0;
+        }
+    }
+
+    printf("============ BENCH RESULTS ============\n");
+    printf("nb_words_decoded: %d / %d\n", nb_decoded, nb_words);
+    printf("duration_decode_ms_per_word: %.2f\n", decode_ms / (std::max)(1, nb_words));
+    printf("\n");
+}
+
+
 TEST_CASE("dictionary_load_save", "[translate]") {
 
 
@@ -463,6 +655,76 @@ TEST_CASE("dictionarize", "[image][translate]") {
     CHECK(nb_fails == 0);
 }
 
+TEST_CASE("dictionarize_batch", "[image][translate][bench]") {
+
+    PRINT_TEST_HEADER("dictionarize_batch");
+
+    RuneDictionary dictionary;
+    RuneDetector rune_detector(&dictionary);
+
+    std::vector<DictionarizeBlockReport> report;
+    auto start = std::chrono::high_resolution_clock::now();
+    bool result = rune_detector.dictionarize_batch(fs::path("../../../data/screenshots/manual_page_10.jpg"), report);
+    auto end = std::chrono::high_resolution_clock::now();
+    long long duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+
+    CHECK(result);
+    CHECK(report.size() > 0);
+
+    // every added word must be present once in the dictionary
+    size_t nb_added = 0;
+    for (const auto& block_report : report) {
+        if (block_report.added) {
+            nb_added++;
+            CHECK(dictionary.has_hash(block_report.word_hash));
+        }
+    }
+    std::vector<std::string> word_list;
+    dictionary.get_hash_list(word_list);
+    CHECK(word_list.size() == nb_added);
+
+    // learned decoder: same blocks, mostly the words of the mask decoder
+    const auto MODEL_FILE = fs::temp_directory_path() / "dictionarize_batch_classifier.yml";
+    RuneClassifier rune_classifier;
+    REQUIRE(rune_classifier.train({ RUNES_FOLDER, RUNES_CAPTURES_FOLDER }));
+    REQUIRE(rune_classifier.save(MODEL_FILE));
+    RuneDictionary classifier_dictionary;
+    RuneDetector classifier_detector(&classifier_dictionary);
+    REQUIRE(classifier_detector.load_rune_classifier(MODEL_FILE));
+    fs::remove(MODEL_FILE);
+
+    std::vector<DictionarizeBlockReport> classifier_report;
+    auto start_classifier = std::chrono::high_resolution_clock::now();
+    REQUIRE(classifier_detector.dictionarize_batch(fs::path("../../../data/screenshots/manual_page_10.jpg"), classifier_report));
+    auto end_classifier = std::chrono::high_resolution_clock::now();
+    long long duration_classifier_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_classifier - start_classifier).count();
+    REQUIRE(classifier_report.size() == report.size());
+    size_t nb_classifier_decoded = 0, nb_both_decoded = 0, nb_same_words = 0;
+    for (size_t i = 0; i < report.size(); i++) {
+        CHECK(classifier_report[i].rect == report[i].rect);
+        if (!classifier_report[i].decoded) {
+            continue;
+        }
+        nb_classifier_decoded++;
+        CHECK(classifier_dictionary.has_hash(classifier_report[i].word_hash));
+        if (report[i].decoded) {
+            nb_both_decoded++;
+            nb_same_words += classifier_report[i].word_hash == report[i].word_hash ? 1 : 0;
+        }
+    }
+    CHECK(nb_classifier_decoded > 0);
+    CHECK(nb_same_words * 2 > nb_both_decoded);
+
+    printf("============ BENCH RESULTS ============\n");
+    printf("nb_blocks: %zu\n", report.size());
+    printf("nb_added: %zu\n", nb_added);
+    printf("duration_ms: %lld\n", duration_ms);
+    printf("classifier_decoded_blocks: %zu\n", nb_classifier_decoded);
+    printf("classifier_same_words: %zu / %zu\n", nb_same_words, nb_both_decoded);
+    printf("duration_classifier_ms: %lld (training excluded)\n", duration_classifier_ms);
+    printf("\n");
+}
+
 TEST_CASE("arpeggio_sequence", "[audio]") {
 
     PRINT_TEST_HEADER("arpeggio_sequence");
@@ -877,4 +1139,1885 @@ TEST_CASE("bench_image_detect_load_resize_word_vs_dynamic_draw", "[image][bench]
     printf("duration_loadandresize_ms: %lld\n", duration_loadandresize_ms);
     printf("duration_genimg_ms: %lld\n", duration_genimg_ms);
     printf("\n");
-}
\ No newline at end of file
+}
+TEST_CASE("bench_text_regions_vs_full_image", "[image][bench]")
+{
+    PRINT_TEST_HEADER("bench_text_regions_vs_full_image");
+
+    const auto SRC_IMG = "../../../data/screenshots/manual_page_3.jpg";
+
+    // the classifier alone
+    auto page = cv::imread(SRC_IMG, cv::IMREAD_COLOR_BGR);
+    REQUIRE(!page.empty());
+    resize_to_fit_max_bounds(page, MAX_IMAGE_DETECTION_DIMENSIONS);
+    std::vector<cv::Rect> text_regions;
+    double skipped_ratio = 0.0;
+    CHECK(find_text_regions(page, text_regions, skipped_ratio));
+    CHECK(text_regions.size() > 0);
+    CHECK(skipped_ratio > 0.0);
+
+    RuneDictionary dictionary(DICTIONARY_ENG);
+    dictionary.load(DICTIONARY_ENG);
+    RuneDetector rune_detector(&dictionary);
+    rune_detector.load_rune_folder(RUNES_FOLDER);
+
+    DetectionOptions options;
+    DetectionResult result_full, result_text;
+
+    // whole image
+    options.text_regions_only = false;
+    rune_detector.set_detection_options(options);
+    cv::Mat image_full = page.clone();
+    auto start_full = std::chrono::high_resolution_clock::now();
+    rune_detector.detect_words(image_full, result_full, DetectionBudget(), 7, false, true);
+    auto end_full = std::chrono::high_resolution_clock::now();
+    long long duration_full_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_full - start_full).count();
+
+    // text regions only
+    options.text_regions_only = true;
+    rune_detector.set_detection_options(options);
+    cv::Mat image_text = page.clone();
+    auto start_text = std::chrono::high_resolution_clock::now();
+    rune_detector.detect_words(image_text, result_text, DetectionBudget(), 7, false, true);
+    auto end_text = std::chrono::high_resolution_clock::now();
+    long long duration_text_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_text - start_text).count();
+
+    // the merged search regions never correlate more than the whole page
+    CHECK(result_text.matched_ratio <= result_full.matched_ratio);
+
+    printf("============ BENCH RESULTS ============\n");
+    printf("text_regions: %zu\n", text_regions.size());
+    printf("skipped_tiles_percent: %.1f\n", skipped_ratio * 100.0);
+    printf("matched_area_percent: %.1f\n", result_text.matched_ratio * 100.0);
+    printf("duration_full_image_ms: %lld (%zu words)\n", duration_full_ms, result_full.zones.size());
+    printf("duration_text_regions_ms: %lld (%zu words)\n", duration_text_ms, result_text.zones.size());
+    printf("\n");
+}
+
+TEST_CASE("bench_gray_reduced_ingest", "[image][bench]")
+{
+    PRINT_TEST_HEADER("bench_gray_reduced_ingest");
+
+    const auto SRC_IMG = fs::path("../../../data/screenshots/manual_page_3.jpg");
+
+    cv::Size file_size;
+    REQUIRE(read_image_size(SRC_IMG, file_size));
+    CHECK(file_size == cv::Size(2301, 1753));
+    CHECK(get_reduced_decode_factor(file_size, MAX_IMAGE_DETECTION_DIMENSIONS) == 2);
+    CHECK(get_reduced_decode_factor(cv::Size(342, 255), MAX_IMAGE_DETECTION_DIMENSIONS) == 1);
+    CHECK(read_image_size(fs::path("../../../data/screenshots/found_bracelet.png"), file_size));
+    CHECK(file_size == cv::Size(1536, 864));
+
+    // previous ingest: full resolution BGR, then resize
+    auto start_bgr = std::chrono::high_resolution_clock::now();
+    auto image_bgr = cv::imread(SRC_IMG.string(), cv::IMREAD_COLOR_BGR);
+    resize_to_fit_max_bounds(image_bgr, MAX_IMAGE_DETECTION_DIMENSIONS);
+    auto end_bgr = std::chrono::high_resolution_clock::now();
+    long long duration_bgr_us = std::chrono::duration_cast<std::chrono::microseconds>(end_bgr - start_bgr).count();
+
+    // gray reduced ingest
+    cv::Mat image_gray;
+    auto start_gray = std::chrono::high_resolution_clock::now();
+    REQUIRE(load_gray_image(SRC_IMG, image_gray, MAX_IMAGE_DETECTION_DIMENSIONS));
+    auto end_gray = std::chrono::high_resolution_clock::now();
+    long long duration_gray_us = std::chrono::duration_cast<std::chrono::microseconds>(end_gray - start_gray).count();
+
+    CHECK(image_gray.channels() == 1);
+    CHECK(image_gray.cols <= MAX_IMAGE_DETECTION_DIMENSIONS.width);
+    CHECK(image_gray.rows <= MAX_IMAGE_DETECTION_DIMENSIONS.height);
+
+    printf("============ BENCH RESULTS ============\n");
+    printf("duration_bgr_full_decode_us: %lld (%dx%d)\n", duration_bgr_us, image_bgr.cols, image_bgr.rows);
+    printf("duration_gray_reduced_decode_us: %lld (%dx%d)\n", duration_gray_us, image_gray.cols, image_gray.rows);
+    printf("\n");
+}
+
+TEST_CASE("rune_classifier_train_eval", "[image][bench]")
+{
+    PRINT_TEST_HEADER("rune_classifier_train_eval");
+
+    const auto MODEL_FILE = fs::path("rune_classifier.yml");
+    const std::vector<fs::path> labelled_folders = { RUNES_FOLDER, RUNES_CAPTURES_FOLDER };
+
+    // the word grid gives one feature row per rune
+    Word word("0305-3c96");
+    cv::Mat word_image, cropped_image, features;
+    REQUIRE(word.generate_image(RUNE_DEFAULT_SIZE, RUNE_SEGMENT_DRAW_DEFAULT_TICKNESS * RUNE_DEFAULT_SIZE.height, word_image));
+    REQUIRE(crop_word_image(word_image, cropped_image));
+    REQUIRE(RuneClassifier::extract_features(cropped_image, features));
+    CHECK(features.rows == (int)word.size());
+    CHECK(features.cols == RUNE_CLASSIFIER_NB_FEATURES);
+
+    RuneClassifier rune_classifier;
+    CHECK(!rune_classifier.is_trained());
+    REQUIRE(rune_classifier.train(labelled_folders));
+    REQUIRE(rune_classifier.save(MODEL_FILE));
+
+    RuneClassifier loaded_classifier;
+    REQUIRE(loaded_classifier.load(MODEL_FILE));
+    RuneClassifierReport report;
+    // held out images only (not trained on)
+    REQUIRE(loaded_classifier.evaluate(labelled_folders, report));
+    CHECK(report.nb_runes > 0);
+    CHECK(report.nb_rune_errors * 10 < report.nb_runes);
+
+    printf("============ BENCH RESULTS ============\n");
+    printf("held_out_runes: %d (%d words, 1 in %d labelled images)\n", report.nb_runes, report.nb_words, RUNE_CLASSIFIER_HOLDOUT_STRIDE);
+    printf("classifier_rune_errors: %d (%d bits)\n", report.nb_rune_errors, report.nb_bit_errors);
+    printf("reference_rune_errors: %d\n", report.nb_reference_rune_errors);
+    printf("duration_classifier_ms: %.2f\n", report.classifier_ms);
+    printf("duration_reference_ms: %.2f\n", report.reference_ms);
+    printf("\n");
+
+    fs::remove(MODEL_FILE);
+}
+
+TEST_CASE("bench_chamfer_vs_correlation", "[image][bench]")
+{
+    PRINT_TEST_HEADER("bench_chamfer_vs_correlation");
+
+    // a word drawn twice as thick as the templates on a noisy page
+    const double scale_factor = 0.5;
+    const cv::Point word_position(100, 50);
+    Word word("0305-3c96");
+    double tickness = RUNE_SEGMENT_DRAW_DEFAULT_TICKNESS * RUNE_DEFAULT_SIZE.height * scale_factor;
+    cv::Mat word_image, template_image;
+    REQUIRE(word.generate_image(RUNE_DEFAULT_SIZE * scale_factor, 2.0 * tickness, word_image));
+    REQUIRE(word.generate_image(RUNE_DEFAULT_SIZE * scale_factor, tickness, template_image));
+
+    cv::Mat page(200, 400, CV_8U, cv::Scalar(80));
+    cv::Mat word_zone = page(cv::Rect(word_position, word_image.size()));
+    cv::max(word_zone, word_image * (220.0 / 255.0), word_zone);
+    cv::Mat noise(page.size(), CV_8U);
+    cv::randn(noise, 0, 10);
+    page += noise;
+
+    ChamferMatcher chamfer_matcher;
+    ChamferTemplate chamfer_template;
+    cv::Mat chamfer_result, correlation_result;
+    REQUIRE(chamfer_matcher.set_image(page));
+    REQUIRE(ChamferMatcher::make_template(word, scale_factor, chamfer_template));
+    CHECK(chamfer_template.size == template_image.size());
+    REQUIRE(chamfer_matcher.match(chamfer_template, cv::Rect(0, 0, page.cols, page.rows), chamfer_result));
+    cv::matchTemplate(page, template_image, correlation_result, cv::TM_CCOEFF_NORMED);
+
+    double chamfer_score = 0.0, correlation_score = 0.0;
+    cv::Point chamfer_position, correlation_position;
+    cv::minMaxLoc(chamfer_result, nullptr, &chamfer_score, nullptr, &chamfer_position);
+    cv::minMaxLoc(correlation_result, nullptr, &correlation_score, nullptr, &correlation_position);
+    CHECK(chamfer_score > CHAMFER_DETECTION_THRESHOLD);
+    CHECK(chamfer_score > correlation_score);
+    CHECK(cv::norm(chamfer_position - word_position) <= 2.0 * tickness);
+
+    // erased words are not found again
+    chamfer_matcher.erase(cv::Rect(word_position, word_image.size()));
+    REQUIRE(chamfer_matcher.match(chamfer_template, cv::Rect(0, 0, page.cols, page.rows), chamfer_result));
+    double erased_score = 0.0;
+    cv::minMaxLoc(chamfer_result, nullptr, &erased_score);
+    CHECK(erased_score < CHAMFER_DETECTION_THRESHOLD);
+
+    // whole detection with both backends
+    auto image = cv::imread("../../../data/screenshots/manual_page_3_inverted.jpg", cv::IMREAD_COLOR_BGR);
+    REQUIRE(!image.empty());
+    resize_to_fit_max_bounds(image, MAX_IMAGE_DETECTION_DIMENSIONS);
+
+    RuneDictionary dictionary(DICTIONARY_ENG);
+    dictionary.load(DICTIONARY_ENG);
+    RuneDetector rune_detector(&dictionary);
+    rune_detector.load_rune_folder(RUNES_FOLDER);
+    DetectionOptions options;
+    std::vector<Word> detected_words_correlation, detected_words_chamfer;
+
+    options.backend = MatchingBackend::Correlation;
+    rune_detector.set_detection_options(options);
+    cv::Mat image_correlation = image.clone();
+    auto start_correlation = std::chrono::high_resolution_clock::now();
+    rune_detector.detect_words(image_correlation, detected_words_correlation, 7, false, true);
+    auto end_correlation = std::chrono::high_resolution_clock::now();
+    long long duration_correlation_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_correlation - start_correlation).count();
+
+    options.backend = MatchingBackend::Chamfer;
+    rune_detector.set_detection_options(options);
+    cv::Mat image_chamfer = image.clone();
+    auto start_chamfer = std::chrono::high_resolution_clock::now();
+    rune_detector.detect_words(image_chamfer, detected_words_chamfer, 7, false, true);
+    auto end_chamfer = std::chrono::high_resolution_clock::now();
+    long long duration_chamfer_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_chamfer - start_chamfer).count();
+
+    printf("============ BENCH RESULTS ============\n");
+    printf("thick_word_chamfer_score: %.3f\n", chamfer_score);
+    printf("thick_word_correlation_score: %.3f\n", correlation_score);
+    printf("duration_correlation_ms: %lld (%zu words)\n", duration_correlation_ms, detected_words_correlation.size());
+    printf("duration_chamfer_ms: %lld (%zu words)\n", duration_chamfer_ms, detected_words_chamfer.size());
+    printf("\n");
+}
+
+TEST_CASE("deskew_page", "[image][bench]")
+{
+    PRINT_TEST_HEADER("deskew_page");
+
+    cv::Mat page;
+    REQUIRE(load_gray_image(fs::path("../../../data/screenshots/manual_page_3_inverted.jpg"), page, MAX_IMAGE_DETECTION_DIMENSIONS));
+
+    // a straight page is left untouched
+    double angle = 0.0;
+    cv::Mat straight_page = page.clone();
+    REQUIRE(deskew_image(straight_page, angle));
+    CHECK(angle == 0.0);
+
+    for (double rotation : { 1.5, -3.0, 5.0, -8.0 }) {
+        cv::Mat rotated_page;
+        cv::Mat rotation_matrix = cv::getRotationMatrix2D(cv::Point2f(0.5f * page.cols, 0.5f * page.rows), rotation, 1.0);
+        cv::warpAffine(page, rotated_page, rotation_matrix, page.size(), cv::INTER_LINEAR, cv::BORDER_REPLICATE);
+
+        double skew_angle = 0.0;
+        auto start = std::chrono::high_resolution_clock::now();
+        REQUIRE(estimate_skew_angle(rotated_page, skew_angle));
+        auto end = std::chrono::high_resolution_clock::now();
+        // the page rotated by +rotation (counter clockwise) has its lines at -rotation in image coordinates
+        CHECK(std::abs(skew_angle + rotation) < 0.5);
+
+        REQUIRE(deskew_image(rotated_page, angle));
+        CHECK(angle == skew_angle);
+        double residual_angle = 0.0;
+        REQUIRE(estimate_skew_angle(rotated_page, residual_angle));
+        CHECK(std::abs(residual_angle) < 0.5);
+
+        printf("rotation: %.1f estimated: %.2f residual: %.2f (%lld ms)\n", rotation, -skew_angle, residual_angle,
+            (long long)std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count());
+    }
+}
+
+TEST_CASE("anytime_detect_words", "[image][bench]")
+{
+    PRINT_TEST_HEADER("anytime_detect_words");
+
+    auto image = cv::imread("../../../data/screenshots/manual_page_3_inverted.jpg", cv::IMREAD_COLOR_BGR);
+    REQUIRE(!image.empty());
+    resize_to_fit_max_bounds(image, MAX_IMAGE_DETECTION_DIMENSIONS);
+
+    RuneDictionary dictionary(DICTIONARY_ENG);
+    dictionary.load(DICTIONARY_ENG);
+    RuneDetector rune_detector(&dictionary);
+    rune_detector.load_rune_folder(RUNES_FOLDER);
+
+    // cancelled before starting: nothing is matched
+    std::atomic<bool> cancel(true);
+    DetectionBudget cancelled_budget;
+    cancelled_budget.cancel = &cancel;
+    DetectionResult cancelled_result;
+    cv::Mat cancelled_image = image.clone();
+    rune_detector.detect_words(cancelled_image, cancelled_result, cancelled_budget, 7, false, true);
+    CHECK(!cancelled_result.complete);
+    CHECK(cancelled_result.completeness == 0.0);
+    CHECK(cancelled_result.zones.empty());
+
+    // unlimited budget: the whole dictionary is tried
+    DetectionResult full_result;
+    cv::Mat full_image = image.clone();
+    rune_detector.detect_words(full_image, full_result, DetectionBudget(), 7, false, true);
+    CHECK(full_result.complete);
+    CHECK(full_result.completeness == 1.0);
+
+    // no budget: the dictionary order is kept, a second call (after the hits of the first one) gives the same words
+    DetectionResult repeated_result;
+    cv::Mat repeated_image = image.clone();
+    rune_detector.detect_words(repeated_image, repeated_result, DetectionBudget(), 7, false, true);
+    REQUIRE(repeated_result.zones.size() == full_result.zones.size());
+    for (size_t i = 0; i < full_result.zones.size(); i++) {
+        CHECK(repeated_result.zones[i].word.get_hash() == full_result.zones[i].word.get_hash());
+        CHECK(repeated_result.zones[i].rect == full_result.zones[i].rect);
+    }
+
+    // short deadline: best so far zones, returned shortly after the deadline (one word scale step at most)
+    const double deadline_ms = 50.0;
+    DetectionResult partial_result;
+    cv::Mat partial_image = image.clone();
+    rune_detector.detect_words(partial_image, partial_result, DetectionBudget::from_now(deadline_ms), 7, false, true);
+    if (full_result.elapsed_ms > deadline_ms) {
+        CHECK(!partial_result.complete);
+        CHECK(partial_result.completeness < 1.0);
+        CHECK(partial_result.elapsed_ms < full_result.elapsed_ms);
+    }
+    CHECK(partial_result.zones.size() <= full_result.zones.size());
+
+    printf("============ BENCH RESULTS ============\n");
+    printf("duration_full_ms: %.0f (%zu words)\n", full_result.elapsed_ms, full_result.zones.size());
+    printf("duration_deadline_%.0f_ms: %.0f (%zu words, %.1f%% done)\n", deadline_ms, partial_result.elapsed_ms,
+        partial_result.zones.size(), partial_result.completeness * 100.0);
+    printf("\n");
+}
+
+TEST_CASE("bench_projection_kernels", "[image][bench]")
+{
+    PRINT_TEST_HEADER("bench_projection_kernels");
+
+    // previous per pixel scans, kept as the reference of the kernels
+    auto scalar_row_counts = [](const cv::Mat& binary_image, std::vector<int>& counts) {
+        counts.assign(binary_image.rows, 0);
+        for (int y = 0; y < binary_image.rows; ++y) {
+            const uchar* row_ptr = binary_image.ptr<uchar>(y);
+            for (int x = 0; x < binary_image.cols; ++x) {
+                if (row_ptr[x] == 255) {
+                    counts[y]++;
+                }
+            }
+        }
+    };
+    auto scalar_bounds = [](const cv::Mat& binary_image, int y, int& x_min, int& x_max) {
+        x_min = -1;
+        x_max = -1;
+        const uchar* row_ptr = binary_image.ptr<uchar>(y);
+        for (int x = 0; x < binary_image.cols; ++x) {
+            if (row_ptr[x] == 255) { x_min = x; break; }
+        }
+        for (int x = binary_image.cols - 1; x >= 0; --x) {
+            if (row_ptr[x] == 255) { x_max = x; break; }
+        }
+    };
+
+    // word images of every size, with odd widths to exercise the vector tails
+    std::vector<cv::Mat> word_images;
+    for (const auto& hash : { "0305-3c96", "3c96", "0305-3c96-0305-3c96-0305", "8c22-0305" }) {
+        for (double scale_factor : { 0.3, 0.55, 1.0, 2.5 }) {
+            cv::Mat word_image;
+            Word word(hash);
+            REQUIRE(word.generate_image(RUNE_DEFAULT_SIZE * scale_factor, RUNE_SEGMENT_DRAW_DEFAULT_TICKNESS * RUNE_DEFAULT_SIZE.height * scale_factor, word_image));
+            cv::threshold(word_image, word_image, RUNE_IMAGE_BINARY_FILTER_THRESOLD, 255, cv::THRESH_BINARY);
+            word_images.push_back(word_image);
+        }
+    }
+
+    for (const auto& word_image : word_images) {
+        std::vector<int> counts, reference_counts;
+        REQUIRE(count_value_per_row(word_image, 255, counts));
+        scalar_row_counts(word_image, reference_counts);
+        CHECK(counts == reference_counts);
+
+        std::vector<int> column_counts;
+        REQUIRE(count_value_per_column(word_image, 255, column_counts));
+        CHECK(std::accumulate(column_counts.begin(), column_counts.end(), 0) == std::accumulate(counts.begin(), counts.end(), 0));
+
+        int line_center_y = 0, tickness = 0;
+        REQUIRE(find_horizontal_separator(word_image, line_center_y, tickness));
+        int x_min = 0, x_max = 0, reference_x_min = 0, reference_x_max = 0;
+        REQUIRE(find_horizontal_separator_bounds(word_image, line_center_y, x_min, x_max));
+        scalar_bounds(word_image, line_center_y, reference_x_min, reference_x_max);
+        CHECK(x_min == reference_x_min);
+        CHECK(x_max == reference_x_max);
+    }
+
+    // crop_black_borders on a framed word
+    RuneDictionary dictionary(DICTIONARY_ENG);
+    RuneDetector rune_detector(&dictionary);
+    cv::Mat framed_word = cv::Mat::zeros(word_images[2].rows + 40, word_images[2].cols + 60, CV_8U);
+    word_images[2].copyTo(framed_word(cv::Rect(25, 15, word_images[2].cols, word_images[2].rows)));
+    cv::Mat cropped_word = rune_detector.crop_black_borders(framed_word);
+    CHECK(cropped_word.cols <= word_images[2].cols);
+    CHECK(cropped_word.rows <= word_images[2].rows);
+    CHECK(cv::countNonZero(cropped_word) == cv::countNonZero(framed_word));
+    // a noise pixel near the frame edge does not stop the crop (largest component only)
+    framed_word.at<uchar>(2, framed_word.cols - 3) = 255;
+    cv::Mat noisy_cropped_word = rune_detector.crop_black_borders(framed_word);
+    CHECK(noisy_cropped_word.size() == cropped_word.size());
+
+    const int iterations = 2000;
+    std::vector<int> counts;
+    int x_min = 0, x_max = 0;
+    auto start_scalar = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        for (const auto& word_image : word_images) {
+            scalar_row_counts(word_image, counts);
+            scalar_bounds(word_image, word_image.rows / 2, x_min, x_max);
+        }
+    }
+    auto end_scalar = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        for (const auto& word_image : word_images) {
+            count_value_per_row(word_image, 255, counts);
+            find_value_bounds(word_image.ptr<uchar>(word_image.rows / 2), word_image.cols, 255, x_min, x_max);
+        }
+    }
+    auto end_kernels = std::chrono::high_resolution_clock::now();
+
+    long long duration_scalar_us = std::chrono::duration_cast<std::chrono::microseconds>(end_scalar - start_scalar).count();
+    long long duration_kernels_us = std::chrono::duration_cast<std::chrono::microseconds>(end_kernels - end_scalar).count();
+    printf("============ BENCH RESULTS ============\n");
+    printf("simd_width_bytes: %d\n", (int)(CV_SIMD_WIDTH));
+    printf("duration_scalar_us: %lld\n", duration_scalar_us);
+    printf("duration_kernels_us: %lld\n", duration_kernels_us);
+    printf("speedup: %.2fx\n", (double)duration_scalar_us / (std::max)(1LL, duration_kernels_us));
+    printf("\n");
+}
+
+TEST_CASE("bench_partition_image", "[image][bench]")
+{
+    PRINT_TEST_HEADER("bench_partition_image");
+
+    // previous contour search over the whole page, kept as the reference
+    auto contour_partition = [](const cv::Mat& image, std::vector<cv::Rect>& partition) {
+        partition.clear();
+        cv::Mat gray_image, binary_lines;
+        cv::cvtColor(image, gray_image, cv::COLOR_BGR2GRAY);
+        cv::threshold(gray_image, binary_lines, 50, 255, cv::THRESH_BINARY);
+        std::vector<std::vector<cv::Point>> contours;
+        std::vector<cv::Vec4i> hierarchy;
+        cv::findContours(binary_lines, contours, hierarchy, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+        for (const auto& contour : contours) {
+            std::vector<cv::Point> approx_poly;
+            cv::approxPolyDP(contour, approx_poly, cv::arcLength(contour, true) * 0.02, true);
+            if (approx_poly.size() == 4 && cv::isContourConvex(approx_poly) && cv::contourArea(contour) > RUNE_DEFAULT_SIZE.area() / 2.0) {
+                partition.push_back(cv::boundingRect(contour));
+            }
+        }
+    };
+    auto sort_rects = [](std::vector<cv::Rect>& rects) {
+        std::sort(rects.begin(), rects.end(), [](const cv::Rect& a, const cv::Rect& b) {
+            return std::tie(a.y, a.x, a.width, a.height) < std::tie(b.y, b.x, b.width, b.height);
+        });
+    };
+
+    std::vector<cv::Mat> pages;
+    for (const auto& page_file : { "../../../data/screenshots/manual_page_10.jpg", "../../../data/screenshots/manual_page_3.jpg" }) {
+        cv::Mat page = cv::imread(page_file, cv::IMREAD_COLOR_BGR);
+        REQUIRE(!page.empty());
+        pages.push_back(page.clone());
+        // as prepared by the rune detector
+        make_white_rune_black_background(page);
+        pages.push_back(page);
+    }
+
+    for (auto& page : pages) {
+        std::vector<cv::Rect> partition, reference_partition;
+        PartitionTiming timing;
+        REQUIRE(partition_image(page, partition, &timing));
+        contour_partition(page, reference_partition);
+        sort_rects(partition);
+        sort_rects(reference_partition);
+        CHECK(partition == reference_partition);
+        CHECK(timing.nb_candidates <= timing.nb_components);
+    }
+
+    // a block drawn in the hole of a frame is not a block of the page
+    cv::Mat nested_blocks = cv::Mat::zeros(600, 800, CV_8UC3);
+    cv::rectangle(nested_blocks, cv::Rect(20, 20, 760, 560), cv::Scalar(255, 255, 255), 4);
+    cv::rectangle(nested_blocks, cv::Rect(200, 150, 300, 250), cv::Scalar(255, 255, 255), cv::FILLED);
+    std::vector<cv::Rect> nested_partition, nested_reference_partition;
+    REQUIRE(partition_image(nested_blocks, nested_partition));
+    contour_partition(nested_blocks, nested_reference_partition);
+    CHECK(nested_partition == nested_reference_partition);
+
+    const int iterations = 20;
+    std::vector<cv::Rect> partition;
+    PartitionTiming total_timing, timing;
+    auto start_contours = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        for (const auto& page : pages) {
+            contour_partition(page, partition);
+        }
+    }
+    auto end_contours = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        for (auto& page : pages) {
+            partition_image(page, partition, &timing);
+            total_timing.threshold_ms += timing.threshold_ms;
+            total_timing.labelling_ms += timing.labelling_ms;
+            total_timing.filtering_ms += timing.filtering_ms;
+        }
+    }
+    auto end_components = std::chrono::high_resolution_clock::now();
+
+    long long duration_contours_us = std::chrono::duration_cast<std::chrono::microseconds>(end_contours - start_contours).count();
+    long long duration_components_us = std::chrono::duration_cast<std::chrono::microseconds>(end_components - end_contours).count();
+    printf("============ BENCH RESULTS ============\n");
+    printf("threads: %d\n", cv::getNumThreads());
+    printf("duration_contours_us: %lld\n", duration_contours_us);
+    printf("duration_components_us: %lld (threshold %.1f ms, labelling %.1f ms, filtering %.1f ms)\n", duration_components_us,
+        total_timing.threshold_ms, total_timing.labelling_ms, total_timing.filtering_ms);
+    printf("speedup: %.2fx\n", (double)duration_contours_us / (std::max)(1LL, duration_components_us));
+    printf("\n");
+}
+
+TEST_CASE("incremental_detect_words", "[image][bench]")
+{
+    PRINT_TEST_HEADER("incremental_detect_words");
+
+    auto image = cv::imread("../../../data/screenshots/manual_page_3_inverted.jpg", cv::IMREAD_COLOR_BGR);
+    REQUIRE(!image.empty());
+    resize_to_fit_max_bounds(image, MAX_IMAGE_DETECTION_DIMENSIONS);
+
+    RuneDictionary dictionary(DICTIONARY_ENG);
+    dictionary.load(DICTIONARY_ENG);
+    RuneDetector rune_detector(&dictionary);
+    rune_detector.load_rune_folder(RUNES_FOLDER);
+
+    // first capture: whole page
+    DetectionResult first_result;
+    cv::Mat first_capture = image.clone();
+    REQUIRE(rune_detector.detect_words_incremental(first_capture, first_result, 7, true));
+
+    // same capture: nothing to match again
+    DetectionResult same_result;
+    cv::Mat same_capture = image.clone();
+    REQUIRE(rune_detector.detect_words_incremental(same_capture, same_result, 7, true));
+    CHECK(same_result.zones.size() == first_result.zones.size());
+
+    // a cursor moved in a corner of the page
+    DetectionResult cursor_result;
+    cv::Mat cursor_capture = image.clone();
+    cv::rectangle(cursor_capture, cv::Rect(5, 5, 12, 18), cv::Scalar(255, 255, 255), cv::FILLED);
+    REQUIRE(rune_detector.detect_words_incremental(cursor_capture, cursor_result, 7, true));
+    CHECK(cursor_result.zones.size() == first_result.zones.size());
+    CHECK(cursor_result.elapsed_ms < first_result.elapsed_ms);
+
+    // tile hashes only differ where the page changed
+    cv::Mat gray, changed_gray;
+    cv::cvtColor(image, gray, cv::COLOR_BGR2GRAY);
+    changed_gray = gray.clone();
+    changed_gray.at<uchar>(100, 200) ^= 0xFF;
+    std::vector<uint64_t> hashes, changed_hashes;
+    REQUIRE(compute_tile_hashes(gray, INCREMENTAL_TILE_SIZE, hashes));
+    REQUIRE(compute_tile_hashes(changed_gray, INCREMENTAL_TILE_SIZE, changed_hashes));
+    std::vector<cv::Rect> dirty_regions;
+    double dirty_ratio = 0.0;
+    REQUIRE(find_dirty_regions(hashes, changed_hashes, gray.size(), INCREMENTAL_TILE_SIZE, dirty_regions, dirty_ratio));
+    REQUIRE(dirty_regions.size() == 1);
+    CHECK(dirty_regions[0].contains(cv::Point(200, 100)));
+    CHECK(dirty_regions[0].area() <= INCREMENTAL_TILE_SIZE * INCREMENTAL_TILE_SIZE);
+
+    printf("============ BENCH RESULTS ============\n");
+    printf("duration_first_capture_ms: %.0f (%zu words)\n", first_result.elapsed_ms, first_result.zones.size());
+    printf("duration_same_capture_ms: %.0f (%zu words)\n", same_result.elapsed_ms, same_result.zones.size());
+    printf("duration_moved_cursor_ms: %.0f (%zu words)\n", cursor_result.elapsed_ms, cursor_result.zones.size());
+    printf("\n");
+}
+
+TEST_CASE("bench_synthetic_pages", "[image][bench]")
+{
+    PRINT_TEST_HEADER("bench_synthetic_pages");
+
+    // same seed, same pages
+    PageGeneratorOptions clean_options;
+    SyntheticPageGenerator generator_a(clean_options, 42), generator_b(clean_options, 42);
+    REQUIRE(generator_a.load_dictionary(DICTIONARY_ENG));
+    REQUIRE(generator_b.load_dictionary(DICTIONARY_ENG));
+    GeneratedPage page_a, page_b;
+    REQUIRE(generator_a.generate_page(page_a));
+    REQUIRE(generator_b.generate_page(page_b));
+    REQUIRE(!page_a.words.empty());
+    CHECK(cv::norm(page_a.image, page_b.image, cv::NORM_INF) == 0.0);
+    REQUIRE(page_a.words.size() == page_b.words.size());
+
+    // the ground truth rects hold the drawn words
+    cv::Mat gray;
+    cv::cvtColor(page_a.image, gray, cv::COLOR_BGR2GRAY);
+    cv::Rect page_rect(0, 0, gray.cols, gray.rows);
+    int nb_inked_words = 0;
+    for (const auto& word : page_a.words) {
+        CHECK((word.rect & page_rect) == word.rect);
+        nb_inked_words += cv::countNonZero(gray(word.rect)) > 0;
+    }
+    CHECK(nb_inked_words == (int)page_a.words.size());
+    CHECK(cv::countNonZero(gray) > 0);
+
+    const fs::path corpus_folder = fs::temp_directory_path() / "libtunic_synthetic_pages";
+    REQUIRE(generator_a.generate_corpus(corpus_folder, 2));
+    CHECK(fs::exists(corpus_folder / "page_0000.png"));
+    CHECK(fs::exists(corpus_folder / "page_0001.json"));
+
+    // detection throughput and accuracy on degraded pages
+    PageGeneratorOptions degraded_options;
+    degraded_options.noise_sigma = 8.0;
+    degraded_options.blur_kernel_size = 3;
+    degraded_options.jpeg_quality = 75;
+    degraded_options.max_rotation = 2.0;
+    SyntheticPageGenerator generator(degraded_options, 7);
+    REQUIRE(generator.load_dictionary(DICTIONARY_ENG));
+
+    RuneDictionary dictionary(DICTIONARY_ENG);
+    dictionary.load(DICTIONARY_ENG);
+    RuneDetector rune_detector(&dictionary);
+    rune_detector.load_rune_folder(RUNES_FOLDER);
+
+    const int nb_pages = 3;
+    GeneratedPageScore total_score;
+    double total_ms = 0.0;
+    for (int i = 0; i < nb_pages; i++) {
+        GeneratedPage page;
+        REQUIRE(generator.generate_page(page));
+        DetectionResult detection_result;
+        REQUIRE(rune_detector.detect_words(page.image, detection_result, DetectionBudget(), 7, false, true));
+        auto score = SyntheticPageGenerator::score_detections(page, detection_result.zones);
+        total_score.nb_words += score.nb_words;
+        total_score.nb_detections += score.nb_detections;
+        total_score.nb_matched += score.nb_matched;
+        total_ms += detection_result.elapsed_ms;
+        printf("page %d: %d words, %d detections, %d matched (scale %.2f, rotation %.1f) in %.0f ms\n", i, score.nb_words,
+            score.nb_detections, score.nb_matched, page.scale_factor, page.rotation, detection_result.elapsed_ms);
+    }
+    CHECK(total_score.nb_words > 0);
+
+    printf("============ BENCH RESULTS ============\n");
+    printf("nb_pages: %d (%dx%d)\n", nb_pages, degraded_options.page_size.width, degraded_options.page_size.height);
+    printf("nb_words: %d\n", total_score.nb_words);
+    printf("nb_detections: %d\n", total_score.nb_detections);
+    printf("precision: %.3f\n", total_score.precision());
+    printf("recall: %.3f\n", total_score.recall());
+    printf("duration_per_page_ms: %.0f (%.2f pages/s)\n", total_ms / nb_pages, 1000.0 * nb_pages / (std::max)(1.0, total_ms));
+    printf("\n");
+}
+
+TEST_CASE("bench_annotate_languages", "[image][bench]")
+{
+    PRINT_TEST_HEADER("bench_annotate_languages");
+
+    // the same text in a zone of the same size is rasterised once
+    AnnotationRenderer renderer;
+    cv::Mat canvas(120, 300, CV_8UC3, cv::Scalar(40, 40, 40));
+    cv::Rect zone(10, 20, 140, 40);
+    REQUIRE(renderer.draw(canvas, "nature", zone));
+    REQUIRE(renderer.draw(canvas, "nature", zone + cv::Point(145, 50)));
+    CHECK(renderer.get_cache_misses() == 1);
+    CHECK(renderer.get_cache_hits() == 1);
+    CHECK(cv::norm(canvas(zone), canvas(zone + cv::Point(145, 50)), cv::NORM_INF) == 0.0);
+    cv::Mat outside = canvas.clone();
+    outside(zone).setTo(cv::Scalar(40, 40, 40));
+    outside(zone + cv::Point(145, 50)).setTo(cv::Scalar(40, 40, 40));
+    CHECK(cv::norm(outside, cv::Mat(canvas.size(), CV_8UC3, cv::Scalar(40, 40, 40)), cv::NORM_INF) == 0.0);
+    cv::Mat text_pixels;
+    cv::inRange(canvas(zone), cv::Scalar(128, 128, 128), cv::Scalar(255, 255, 255), text_pixels);
+    CHECK(cv::countNonZero(text_pixels) > 0);
+    // zones partly out of the image are clipped
+    CHECK(renderer.draw(canvas, "nature", cv::Rect(250, 100, 140, 40)));
+
+    // one detection, every language of lang/
+    auto image = cv::imread("../../../data/screenshots/manual_page_3_inverted.jpg", cv::IMREAD_COLOR_BGR);
+    REQUIRE(!image.empty());
+    resize_to_fit_max_bounds(image, MAX_IMAGE_DETECTION_DIMENSIONS);
+
+    RuneDictionary dictionary(DICTIONARY_ENG);
+    dictionary.load(DICTIONARY_ENG);
+    RuneDetector rune_detector(&dictionary);
+    rune_detector.load_rune_folder(RUNES_FOLDER);
+    DetectionOptions options;
+    options.deskew = false; // the zones must stay in the page frame
+    rune_detector.set_detection_options(options);
+
+    DetectionResult detection_result;
+    cv::Mat detection_image = image.clone();
+    REQUIRE(rune_detector.detect_words(detection_image, detection_result, DetectionBudget(), 7, false, true));
+
+    std::vector<fs::path> dictionary_files;
+    for (const auto& entry : fs::directory_iterator(DICTIONARY_ENG.parent_path())) {
+        if (entry.path().extension() == ".txt" && entry.path().stem().string().rfind("dictionary.", 0) == 0) {
+            dictionary_files.push_back(entry.path());
+        }
+    }
+    REQUIRE(!dictionary_files.empty());
+
+    const fs::path output_folder = fs::temp_directory_path() / "libtunic_annotations";
+    std::vector<fs::path> output_files;
+    auto start_annotation = std::chrono::high_resolution_clock::now();
+    REQUIRE(rune_detector.annotate_languages(image, detection_result.zones, dictionary_files, output_folder, "manual_page_3", output_files));
+    auto end_annotation = std::chrono::high_resolution_clock::now();
+    REQUIRE(output_files.size() == dictionary_files.size());
+    for (const auto& output_file : output_files) {
+        CHECK(fs::exists(output_file));
+    }
+
+    long long duration_annotation_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_annotation - start_annotation).count();
+    const auto& annotation_renderer = rune_detector.get_annotation_renderer();
+    printf("============ BENCH RESULTS ============\n");
+    printf("duration_detection_ms: %.0f (%zu words)\n", detection_result.elapsed_ms, detection_result.zones.size());
+    printf("duration_annotation_ms: %lld (%zu languages)\n", duration_annotation_ms, output_files.size());
+    printf("patches_rendered: %zu\n", annotation_renderer.get_cache_misses());
+    printf("patches_reused: %zu\n", annotation_renderer.get_cache_hits());
+    printf("\n");
+}
+
+TEST_CASE("bench_fft_plan", "[audio][bench]")
+{
+    PRINT_TEST_HEADER("bench_fft_plan");
+
+    // previous recursive transform (two vectors per level, twiddles from cos / sin), kept as the reference
+    std::function<void(std::vector<FFT::Complex>&)> recursive_fft = [&recursive_fft](std::vector<FFT::Complex>& a) {
+        size_t n = a.size();
+        if (n <= 1) return;
+        std::vector<FFT::Complex> a0(n / 2), a1(n / 2);
+        for (size_t i = 0; 2 * i < n; i++) {
+            a0[i] = a[2 * i];
+            a1[i] = a[2 * i + 1];
+        }
+        recursive_fft(a0);
+        recursive_fft(a1);
+        double ang = 2 * std::numbers::pi / n;
+        FFT::Complex w(1), wn(cos(ang), sin(ang));
+        for (size_t i = 0; 2 * i < n; i++) {
+            a[i] = a0[i] + w * a1[i];
+            a[i + n / 2] = a0[i] - w * a1[i];
+            w *= wn;
+        }
+    };
+
+    cv::RNG rng(42);
+    for (size_t fft_size : { 1, 2, 8, 256, 4096 }) {
+        std::vector<double> signal(fft_size);
+        for (auto& value : signal) {
+            value = rng.gaussian(1.0);
+        }
+        std::vector<FFT::Complex> reference(signal.begin(), signal.end());
+        recursive_fft(reference);
+
+        // the vector API keeps its sign convention
+        std::vector<FFT::Complex> compatible(signal.begin(), signal.end());
+        FFT::fft(compatible);
+
+        FftPlan<double> plan(fft_size);
+        REQUIRE(plan.is_valid());
+        std::vector<FFT::Complex> complex_spectrum(signal.begin(), signal.end());
+        plan.forward(complex_spectrum.data());
+        std::vector<FFT::Complex> real_spectrum(fft_size / 2 + 1);
+        plan.forward_real(signal.data(), real_spectrum.data());
+        FftPlan<float> float_plan(fft_size);
+        std::vector<float> float_signal(signal.begin(), signal.end());
+        std::vector<std::complex<float>> float_spectrum(fft_size / 2 + 1);
+        float_plan.forward_real(float_signal.data(), float_spectrum.data());
+
+        double tolerance = 1e-9 * fft_size;
+        for (size_t k = 0; k < fft_size; k++) {
+            CHECK(std::abs(compatible[k] - reference[k]) < tolerance);
+            // forward uses exp(-2i pi jk / n): conjugate of the previous convention for a real signal
+            CHECK(std::abs(complex_spectrum[k] - std::conj(reference[k])) < tolerance);
+        }
+        for (size_t k = 0; k <= fft_size / 2; k++) {
+            CHECK(std::abs(real_spectrum[k] - std::conj(reference[k])) < tolerance);
+            CHECK(std::abs(FFT::Complex(float_spectrum[k]) - std::conj(reference[k])) < 1e-4 * std::sqrt((double)fft_size) * 4.0);
+        }
+
+        // round trips
+        std::vector<double> restored(fft_size);
+        plan.inverse_real(real_spectrum.data(), restored.data());
+        plan.inverse(complex_spectrum.data());
+        for (size_t i = 0; i < fft_size; i++) {
+            CHECK(std::abs(restored[i] - signal[i]) < 1e-9);
+            CHECK(std::abs(complex_spectrum[i] - FFT::Complex(signal[i])) < 1e-9);
+        }
+    }
+    CHECK(!FftPlan<double>().init(1000));
+
+    // one analysis chunk of detect_note_sequence (75 ms at 44.1 kHz -> 4096 points)
+    const size_t fft_size = 4096;
+    const int iterations = 500;
+    std::vector<double> signal(fft_size);
+    for (size_t i = 0; i < fft_size; i++) {
+        signal[i] = std::sin(2 * std::numbers::pi * 440.0 * i / 44100.0);
+    }
+    auto start_recursive = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        std::vector<FFT::Complex> chunk(signal.begin(), signal.end());
+        recursive_fft(chunk);
+    }
+    auto end_recursive = std::chrono::high_resolution_clock::now();
+    FftPlan<double> plan(fft_size);
+    std::vector<FFT::Complex> chunk(fft_size);
+    for (int i = 0; i < iterations; i++) {
+        std::copy(signal.begin(), signal.end(), chunk.begin());
+        plan.forward(chunk.data());
+    }
+    auto end_complex = std::chrono::high_resolution_clock::now();
+    std::vector<FFT::Complex> spectrum(fft_size / 2 + 1);
+    for (int i = 0; i < iterations; i++) {
+        plan.forward_real(signal.data(), spectrum.data());
+    }
+    auto end_real = std::chrono::high_resolution_clock::now();
+    FftPlan<float> float_plan(fft_size);
+    std::vector<float> float_signal(signal.begin(), signal.end());
+    std::vector<std::complex<float>> float_spectrum(fft_size / 2 + 1);
+    for (int i = 0; i < iterations; i++) {
+        float_plan.forward_real(float_signal.data(), float_spectrum.data());
+    }
+    auto end_float = std::chrono::high_resolution_clock::now();
+
+    long long duration_recursive_us = std::chrono::duration_cast<std::chrono::microseconds>(end_recursive - start_recursive).count();
+    long long duration_complex_us = std::chrono::duration_cast<std::chrono::microseconds>(end_complex - end_recursive).count();
+    long long duration_real_us = std::chrono::duration_cast<std::chrono::microseconds>(end_real - end_complex).count();
+    long long duration_float_us = std::chrono::duration_cast<std::chrono::microseconds>(end_float - end_real).count();
+    printf("============ BENCH RESULTS ============\n");
+    printf("duration_recursive_us: %lld\n", duration_recursive_us);
+    printf("duration_plan_complex_us: %lld (%.2fx)\n", duration_complex_us, (double)duration_recursive_us / (std::max)(1LL, duration_complex_us));
+    printf("duration_plan_real_us: %lld (%.2fx)\n", duration_real_us, (double)duration_recursive_us / (std::max)(1LL, duration_real_us));
+    printf("duration_plan_real_float_us: %lld (%.2fx)\n", duration_float_us, (double)duration_recursive_us / (std::max)(1LL, duration_float_us));
+    printf("\n");
+}
+
+TEST_CASE("bench_stft", "[audio][bench]")
+{
+    PRINT_TEST_HEADER("bench_stft");
+
+    const uint32_t sample_rate = 44100;
+    const size_t window_size = static_cast<size_t>(sample_rate * DEFAULT_NOTE_LENGTH / 1000.0);
+    const size_t fft_size = FftPlan<double>::next_power_of_two(window_size);
+    cv::RNG rng(7);
+    std::vector<float> signal(sample_rate * 10);
+    for (auto& value : signal) {
+        value = (float)rng.gaussian(0.3);
+    }
+
+    // previous analysis: one zero padded chunk per note length, Hann window recomputed for every sample
+    auto reference_chunk = [&](size_t start, std::vector<double>& magnitudes) {
+        std::vector<double> chunk(fft_size, 0.0);
+        for (size_t j = 0; j < window_size; ++j) {
+            double hann_multiplier = 0.5 * (1 - cos(2 * std::numbers::pi * j / (window_size - 1)));
+            chunk[j] = signal[start + j] * hann_multiplier;
+        }
+        FftPlan<double> plan(fft_size);
+        std::vector<FftPlan<double>::Complex> spectrum(fft_size / 2 + 1);
+        plan.forward_real(chunk.data(), spectrum.data());
+        magnitudes.resize(spectrum.size());
+        for (size_t k = 0; k < spectrum.size(); k++) {
+            magnitudes[k] = std::abs(spectrum[k]);
+        }
+    };
+
+    for (size_t hop_size : { window_size, window_size / 2, window_size + 1000 }) {
+        StftConfig config;
+        config.window_size = window_size;
+        config.hop_size = hop_size;
+        config.ring_size = 3;
+        Stft stft_whole(config);
+        Stft stft_blocks(config);
+        REQUIRE(stft_whole.is_valid());
+        REQUIRE(stft_whole.get_fft_size() == fft_size);
+
+        std::vector<std::vector<double>> whole_magnitudes;
+        stft_whole.push(signal.data(), signal.size(), [&](const StftFrame& frame) {
+            CHECK(frame.start == frame.index * hop_size);
+            whole_magnitudes.emplace_back(frame.magnitudes, frame.magnitudes + stft_whole.get_nb_bins());
+        });
+        CHECK(whole_magnitudes.size() == (signal.size() - window_size) / hop_size + 1);
+
+        // same frames when the samples come in blocks of any size
+        size_t nb_frames = 0;
+        int nb_differences = 0;
+        for (size_t position = 0; position < signal.size(); ) {
+            size_t count = (std::min)((size_t)rng.uniform(0, 2000), signal.size() - position);
+            stft_blocks.push(signal.data() + position, count, [&](const StftFrame& frame) {
+                for (size_t j = 0; j < window_size; j++) {
+                    nb_differences += frame.samples[j] != signal[frame.start + j];
+                }
+                for (size_t k = 0; k < stft_blocks.get_nb_bins(); k++) {
+                    nb_differences += frame.magnitudes[k] != whole_magnitudes[nb_frames][k];
+                }
+                nb_frames++;
+            });
+            position += count;
+        }
+        CHECK(nb_frames == whole_magnitudes.size());
+        CHECK(nb_differences == 0);
+
+        // ring: the last ring_size frames stay readable
+        REQUIRE(stft_whole.get_frame(2) != nullptr);
+        CHECK(stft_whole.get_frame(0)->index == nb_frames - 1);
+        CHECK(stft_whole.get_frame(2)->index == nb_frames - 3);
+        CHECK(stft_whole.get_frame(3) == nullptr);
+
+        // same spectrum as the previous analysis
+        std::vector<double> reference;
+        for (size_t frame_index : { (size_t)0, nb_frames / 2, nb_frames - 1 }) {
+            reference_chunk(frame_index * hop_size, reference);
+            for (size_t k = 0; k < reference.size(); k++) {
+                CHECK(std::abs(reference[k] - whole_magnitudes[frame_index][k]) < 1e-9);
+            }
+        }
+    }
+
+    // raw frames only (YIN path)
+    StftConfig raw_config;
+    raw_config.window_size = 1000;
+    raw_config.window = WindowType::Rectangular;
+    raw_config.compute_magnitudes = false;
+    Stft raw_stft(raw_config);
+    size_t nb_raw_frames = raw_stft.push(signal.data(), signal.size(), [&](const StftFrame& frame) {
+        CHECK(frame.magnitudes == nullptr);
+        CHECK(frame.samples[999] == signal[frame.start + 999]);
+    });
+    CHECK(nb_raw_frames == signal.size() / 1000);
+
+    // a copy reads its own frames, a raw init drops the FFT plan of a previous init
+    Stft copied_stft = raw_stft;
+    REQUIRE(copied_stft.get_frame() != nullptr);
+    CHECK(copied_stft.get_frame()->samples != raw_stft.get_frame()->samples);
+    CHECK(copied_stft.get_frame()->samples[999] == raw_stft.get_frame()->samples[999]);
+    StftConfig spectrum_config = raw_config;
+    spectrum_config.compute_magnitudes = true;
+    REQUIRE(copied_stft.init(spectrum_config));
+    CHECK(copied_stft.get_fft_size() == 1024);
+    REQUIRE(copied_stft.init(raw_config));
+    CHECK(copied_stft.get_fft_size() == 0);
+
+    // 10 s of signal: previous chunks vs STFT, without and with overlap
+    auto start_reference = std::chrono::high_resolution_clock::now();
+    std::vector<double> magnitudes;
+    size_t nb_reference_frames = 0;
+    for (size_t i = 0; i + window_size <= signal.size(); i += window_size) {
+        reference_chunk(i, magnitudes);
+        nb_reference_frames++;
+    }
+    auto end_reference = std::chrono::high_resolution_clock::now();
+    StftConfig config;
+    config.window_size = window_size;
+    Stft stft(config);
+    size_t nb_stft_frames = stft.push(signal.data(), signal.size(), nullptr);
+    auto end_stft = std::chrono::high_resolution_clock::now();
+    config.hop_size = window_size / 4;
+    Stft stft_overlap(config);
+    size_t nb_overlap_frames = stft_overlap.push(signal.data(), signal.size(), nullptr);
+    auto end_overlap = std::chrono::high_resolution_clock::now();
+    CHECK(nb_stft_frames == nb_reference_frames);
+
+    double duration_reference_ms = std::chrono::duration<double, std::milli>(end_reference - start_reference).count();
+    double duration_stft_ms = std::chrono::duration<double, std::milli>(end_stft - end_reference).count();
+    double duration_overlap_ms = std::chrono::duration<double, std::milli>(end_overlap - end_stft).count();
+    printf("============ BENCH RESULTS ============\n");
+    printf("window_size: %zu (fft %zu points, 10 s of signal)\n", window_size, fft_size);
+    printf("duration_per_chunk_plan_ms: %.2f (%zu frames, %.3f ms / frame)\n", duration_reference_ms, nb_reference_frames, duration_reference_ms / nb_reference_frames);
+    printf("duration_stft_ms: %.2f (%zu frames, %.3f ms / frame)\n", duration_stft_ms, nb_stft_frames, duration_stft_ms / nb_stft_frames);
+    printf("duration_stft_overlap_75_ms: %.2f (%zu frames, %.3f ms / frame)\n", duration_overlap_ms, nb_overlap_frames, duration_overlap_ms / nb_overlap_frames);
+    printf("\n");
+}
+
+TEST_CASE("yin_detector", "[audio][bench]")
+{
+    PRINT_TEST_HEADER("yin_detector");
+
+    const std::vector<Note> notes = { Note::G2, Note::C3, Note::A4, Note::C5, Note::A5, Note::C6, Note::A6, Note::C7 };
+    for (uint32_t sample_rate : { 22050u, 44100u, 48000u }) {
+        size_t window_size = static_cast<size_t>(std::lround(sample_rate * YIN_WINDOW_DURATION));
+        YinDetector yin(sample_rate, window_size);
+        REQUIRE(yin.is_valid());
+        std::vector<float> samples(window_size);
+        for (const auto& note : notes) {
+            double frequency = note_frequencies.at(note);
+            for (size_t i = 0; i < window_size; i++) {
+                samples[i] = (float)(0.5 * std::sin(2 * std::numbers::pi * frequency * i / sample_rate));
+            }
+            float pitch = yin.get_pitch(samples.data());
+            CHECK(std::abs(pitch - frequency) < frequency * 0.01);
+            CHECK(yin.get_probability() > 0.9f);
+            CHECK((Note)std::lround(frequencyToMidiNote(pitch)) == note);
+        }
+        // noise and silence: no pitch
+        cv::RNG rng(sample_rate);
+        for (auto& sample : samples) {
+            sample = (float)rng.uniform(-0.5, 0.5);
+        }
+        CHECK(yin.get_pitch(samples.data()) == -1);
+        std::fill(samples.begin(), samples.end(), 0.0f);
+        CHECK(yin.get_pitch(samples.data()) == -1);
+        CHECK(yin.get_probability() == 0);
+    }
+
+    // 1 s per note at 44.1 kHz: previous search (Yin_init for every buffer length from 100 samples, buffers freed here)
+    // vs one YinDetector pass per window
+    const uint32_t sample_rate = 44100;
+    const size_t window_size = 1000;
+    YinDetector yin(sample_rate, window_size);
+    printf("============ BENCH RESULTS ============\n");
+    for (const auto& note : { Note::C3, Note::A4, Note::C6 }) {
+        double frequency = note_frequencies.at(note);
+        std::vector<float> samples(sample_rate);
+        std::vector<int16_t> samples_int16(sample_rate);
+        for (size_t i = 0; i < samples.size(); i++) {
+            samples_int16[i] = (int16_t)std::lround(16384 * std::sin(2 * std::numbers::pi * frequency * i / sample_rate));
+            samples[i] = samples_int16[i] / 32768.0f;
+        }
+
+        auto start_previous = std::chrono::high_resolution_clock::now();
+        size_t nb_buffers = 0;
+        for (size_t offset = 0; offset + window_size <= samples.size(); offset += window_size) {
+            Yin previous_yin;
+            int buffer_length = 100;
+            float pitch = 0;
+            while (pitch < 10 && buffer_length < (int)window_size) {
+                Yin_init(&previous_yin, buffer_length, 0.05f);
+                pitch = Yin_getPitch(&previous_yin, samples_int16.data() + offset);
+                free(previous_yin.yinBuffer);
+                buffer_length++;
+                nb_buffers++;
+            }
+        }
+        auto end_previous = std::chrono::high_resolution_clock::now();
+        size_t nb_windows = 0;
+        for (size_t offset = 0; offset + window_size <= samples.size(); offset += window_size) {
+            float pitch = yin.get_pitch(samples.data() + offset);
+            CHECK(std::abs(pitch - frequency) < frequency * 0.01);
+            nb_windows++;
+        }
+        auto end_detector = std::chrono::high_resolution_clock::now();
+
+        double duration_previous_ms = std::chrono::duration<double, std::milli>(end_previous - start_previous).count();
+        double duration_detector_ms = std::chrono::duration<double, std::milli>(end_detector - end_previous).count();
+        printf("duration_previous_%s_ms: %.2f (%zu Yin_init for %zu windows)\n", note_to_string(note).c_str(), duration_previous_ms, nb_buffers, nb_windows);
+        printf("duration_detector_%s_ms: %.2f (%.1fx)\n", note_to_string(note).c_str(), duration_detector_ms, duration_previous_ms / (std::max)(duration_detector_ms, 1e-3));
+    }
+    printf("\n");
+}
+
+TEST_CASE("bench_yin_fft_difference", "[audio][bench]")
+{
+    PRINT_TEST_HEADER("bench_yin_fft_difference");
+
+    // lags up to half the window (min frequency 1 Hz): the direct difference is quadratic in the window size
+    const uint32_t sample_rate = 44100;
+    cv::RNG rng(11);
+    printf("============ BENCH RESULTS ============\n");
+    for (size_t window_size : { 1000, 2048, 4096, 8192, 16384 }) {
+        YinDetector direct_yin(sample_rate, window_size, YIN_NOTE_THRESHOLD, 1.0, YIN_MAX_FREQUENCY, YinMethod::Direct);
+        YinDetector fft_yin(sample_rate, window_size, YIN_NOTE_THRESHOLD, 1.0, YIN_MAX_FREQUENCY, YinMethod::Fft);
+        REQUIRE(direct_yin.is_valid());
+        REQUIRE(fft_yin.is_valid());
+
+        std::vector<float> samples(window_size);
+        double duration_direct_ms = 0, duration_fft_ms = 0;
+        for (double frequency : { 98.0, 261.63, 440.0, 1046.5, 3520.0 }) {
+            for (size_t i = 0; i < window_size; i++) {
+                double phase = 2 * std::numbers::pi * frequency * i / sample_rate;
+                samples[i] = (float)(0.5 * std::sin(phase) + 0.2 * std::sin(2 * phase + 1) + rng.gaussian(0.01));
+            }
+            auto start_direct = std::chrono::high_resolution_clock::now();
+            float direct_pitch = direct_yin.get_pitch(samples.data());
+            auto end_direct = std::chrono::high_resolution_clock::now();
+            float fft_pitch = fft_yin.get_pitch(samples.data());
+            auto end_fft = std::chrono::high_resolution_clock::now();
+            duration_direct_ms += std::chrono::duration<double, std::milli>(end_direct - start_direct).count();
+            duration_fft_ms += std::chrono::duration<double, std::milli>(end_fft - end_direct).count();
+
+            CHECK(std::abs(direct_pitch - frequency) < frequency * 0.01);
+            CHECK(std::abs(fft_pitch - direct_pitch) < direct_pitch * 1e-4);
+            CHECK(std::abs(fft_yin.get_probability() - direct_yin.get_probability()) < 1e-3);
+            for (size_t tau = 0; tau < fft_yin.get_max_lag(); tau++) {
+                CHECK(std::abs(fft_yin.get_difference()[tau] - direct_yin.get_difference()[tau]) < 1e-3);
+            }
+        }
+        printf("duration_direct_%zu_ms: %.3f (%zu lags)\n", window_size, duration_direct_ms / 5, fft_yin.get_max_lag());
+        printf("duration_fft_%zu_ms: %.3f (%.1fx)\n", window_size, duration_fft_ms / 5, duration_direct_ms / (std::max)(duration_fft_ms, 1e-6));
+    }
+    printf("\n");
+
+    // windows above the int16_t indices of Yin_difference
+    const size_t large_window_size = 65536;
+    YinDetector large_yin(sample_rate, large_window_size, YIN_NOTE_THRESHOLD, 1.0);
+    REQUIRE(large_yin.is_valid());
+    std::vector<float> samples(large_window_size);
+    for (size_t i = 0; i < large_window_size; i++) {
+        samples[i] = (float)(0.5 * std::sin(2 * std::numbers::pi * 55.0 * i / sample_rate));
+    }
+    CHECK(std::abs(large_yin.get_pitch(samples.data()) - 55.0) < 0.1);
+}
+
+TEST_CASE("bench_yin_simd", "[audio][bench]")
+{
+    PRINT_TEST_HEADER("bench_yin_simd");
+
+    const uint32_t sample_rate = 44100;
+    const int iterations = 100;
+    cv::RNG rng(13);
+    printf("============ BENCH RESULTS ============\n");
+    printf("simd_kernels: %s\n", YinDetector(sample_rate, 1000).is_simd() ? "yes" : "no");
+    const std::vector<std::pair<size_t, double>> configurations = { { 256, 1.0 }, { 512, 1.0 }, { 1000, 1.0 }, { 2048, 200.0 }, { 2048, 1.0 }, { 4096, 1.0 } };
+    for (const auto& [window_size, min_frequency] : configurations) {
+        YinDetector scalar_yin(sample_rate, window_size, YIN_NOTE_THRESHOLD, min_frequency, YIN_MAX_FREQUENCY, YinMethod::Direct);
+        YinDetector simd_yin(sample_rate, window_size, YIN_NOTE_THRESHOLD, min_frequency, YIN_MAX_FREQUENCY, YinMethod::DirectSimd);
+        YinDetector fft_yin(sample_rate, window_size, YIN_NOTE_THRESHOLD, min_frequency, YIN_MAX_FREQUENCY, YinMethod::Fft);
+        YinDetector auto_yin(sample_rate, window_size, YIN_NOTE_THRESHOLD, min_frequency);
+        YinDetector measured_yin(sample_rate, window_size, YIN_NOTE_THRESHOLD, min_frequency, YIN_MAX_FREQUENCY, YinMethod::Measured);
+        REQUIRE(auto_yin.is_valid());
+        REQUIRE(measured_yin.is_valid());
+        // fixed crossover: no timing at init
+        bool direct_work = (window_size - auto_yin.get_max_lag()) * auto_yin.get_max_lag() <= YIN_AUTO_MAX_DIRECT_WORK;
+        CHECK(auto_yin.get_method() == (auto_yin.is_simd() && direct_work ? YinMethod::DirectSimd : YinMethod::Fft));
+        CHECK(measured_yin.get_method() != YinMethod::Measured);
+
+        // period at 40% of the lag range, with an harmonic and some noise
+        double frequency = sample_rate / (scalar_yin.get_max_lag() * 0.4);
+        std::vector<int16_t> samples_int16(window_size);
+        std::vector<float> samples(window_size);
+        for (size_t i = 0; i < window_size; i++) {
+            double phase = 2 * std::numbers::pi * frequency * i / sample_rate;
+            samples_int16[i] = cv::saturate_cast<int16_t>(16000 * (std::sin(phase) + 0.3 * std::sin(2 * phase + 1)) + rng.gaussian(300));
+            samples[i] = samples_int16[i] / 32768.0f;
+        }
+
+        YinDetector* detectors[3] = { &scalar_yin, &simd_yin, &fft_yin };
+        double durations_us[3] = { 0, 0, 0 };
+        float pitches[3] = { 0, 0, 0 };
+        for (int d = 0; d < 3; d++) {
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < iterations; i++) {
+                pitches[d] = detectors[d]->get_pitch(samples.data());
+            }
+            auto end = std::chrono::high_resolution_clock::now();
+            durations_us[d] = std::chrono::duration<double, std::micro>(end - start).count() / iterations;
+        }
+        CHECK(std::abs(pitches[0] - frequency) < frequency * 0.01);
+        CHECK(std::abs(pitches[1] - pitches[0]) < pitches[0] * 1e-4);
+        CHECK(std::abs(pitches[2] - pitches[0]) < pitches[0] * 1e-4);
+        for (size_t tau = 0; tau < scalar_yin.get_max_lag(); tau++) {
+            CHECK(std::abs(simd_yin.get_difference()[tau] - scalar_yin.get_difference()[tau]) < 1e-4);
+        }
+        // 16 bit input: widened to the same float samples
+        CHECK(simd_yin.get_pitch(samples_int16.data()) == pitches[1]);
+
+        printf("duration_direct_%zu_%zu_lags_us: %.1f\n", window_size, scalar_yin.get_max_lag(), durations_us[0]);
+        printf("duration_direct_simd_%zu_%zu_lags_us: %.1f (%.1fx)\n", window_size, scalar_yin.get_max_lag(), durations_us[1],
+            durations_us[0] / (std::max)(durations_us[1], 1e-3));
+        printf("duration_fft_%zu_%zu_lags_us: %.1f\n", window_size, scalar_yin.get_max_lag(), durations_us[2]);
+        printf("auto_method_%zu_%zu_lags: %s\n", window_size, scalar_yin.get_max_lag(), auto_yin.get_method() == YinMethod::Fft ? "fft" : "direct simd");
+        printf("measured_method_%zu_%zu_lags: %s\n", window_size, scalar_yin.get_max_lag(), measured_yin.get_method() == YinMethod::Fft ? "fft" : "direct simd");
+    }
+    printf("\n");
+}
+
+TEST_CASE("wav_reader", "[audio][bench]")
+{
+    PRINT_TEST_HEADER("wav_reader");
+
+    // RIFF file with the given fmt payload, optional chunks before "data", and interleaved sample bytes
+    auto write_wav = [](const fs::path& wav_file, const std::vector<uint8_t>& format, const std::vector<std::pair<std::string, std::vector<uint8_t>>>& extra_chunks,
+        const std::vector<uint8_t>& data, uint32_t declared_data_size) {
+        std::vector<uint8_t> bytes = { 'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E' };
+        auto append_chunk = [&bytes](const std::string& id, const std::vector<uint8_t>& payload, uint32_t declared_size) {
+            bytes.insert(bytes.end(), id.begin(), id.end());
+            for (int b = 0; b < 4; b++) {
+                bytes.push_back((uint8_t)(declared_size >> (8 * b)));
+            }
+            bytes.insert(bytes.end(), payload.begin(), payload.end());
+            if (payload.size() & 1) {
+                bytes.push_back(0);
+            }
+        };
+        for (const auto& [id, payload] : extra_chunks) {
+            if (id == "fmt ") {
+                append_chunk(id, format, (uint32_t)format.size());
+            }
+            else {
+                append_chunk(id, payload, (uint32_t)payload.size());
+            }
+        }
+        append_chunk("data", data, declared_data_size);
+        uint32_t riff_size = (uint32_t)bytes.size() - 8;
+        std::memcpy(bytes.data() + 4, &riff_size, 4);
+        std::ofstream file(wav_file, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    };
+    auto make_format = [](uint16_t format_tag, uint16_t channels, uint32_t sample_rate, uint16_t bits, size_t size) {
+        std::vector<uint8_t> format(size, 0);
+        uint16_t block_align = channels * bits / 8;
+        uint32_t byte_rate = sample_rate * block_align;
+        std::memcpy(format.data(), &format_tag, 2);
+        std::memcpy(format.data() + 2, &channels, 2);
+        std::memcpy(format.data() + 4, &sample_rate, 4);
+        std::memcpy(format.data() + 8, &byte_rate, 4);
+        std::memcpy(format.data() + 12, &block_align, 2);
+        std::memcpy(format.data() + 14, &bits, 2);
+        return format;
+    };
+
+    // left channel: ramp over [-1, 1), right channel: its opposite
+    const size_t nb_frames = 10000;
+    std::vector<float> left(nb_frames), right(nb_frames);
+    for (size_t i = 0; i < nb_frames; i++) {
+        left[i] = -1.0f + 2.0f * i / nb_frames;
+        right[i] = -left[i] * 0.5f;
+    }
+    struct FormatTest { std::string name; uint16_t format_tag; uint16_t bits; double tolerance; };
+    const std::vector<FormatTest> format_tests = {
+        { "uint8", 1, 8, 1.0 / 128 }, { "int16", 1, 16, 1.0 / 32768 }, { "int24", 1, 24, 1.0 / 8388608 },
+        { "int32", 1, 32, 1e-6 }, { "float32", 3, 32, 1e-7 }, { "float64", 3, 64, 1e-6 },
+    };
+    for (const auto& format_test : format_tests) {
+        std::vector<uint8_t> data;
+        for (size_t i = 0; i < nb_frames; i++) {
+            for (float value : { left[i], right[i] }) {
+                uint8_t sample_bytes[8];
+                if (format_test.format_tag == 3 && format_test.bits == 32) {
+                    std::memcpy(sample_bytes, &value, 4);
+                }
+                else if (format_test.format_tag == 3) {
+                    double double_value = value;
+                    std::memcpy(sample_bytes, &double_value, 8);
+                }
+                else if (format_test.bits == 8) {
+                    sample_bytes[0] = (uint8_t)std::clamp(std::lround(value * 128.0) + 128, 0L, 255L);
+                }
+                else {
+                    int64_t max_value = int64_t(1) << (format_test.bits - 1);
+                    int64_t integer_value = std::clamp((int64_t)std::llround(value * (double)max_value), -max_value, max_value - 1);
+                    for (int b = 0; b < format_test.bits / 8; b++) {
+                        sample_bytes[b] = (uint8_t)(integer_value >> (8 * b));
+                    }
+                }
+                data.insert(data.end(), sample_bytes, sample_bytes + format_test.bits / 8);
+            }
+        }
+
+        // 18 byte fmt after an odd sized LIST chunk, then the same as WAVE_FORMAT_EXTENSIBLE with a fact chunk
+        for (bool extensible : { false, true }) {
+            std::vector<uint8_t> format = make_format(extensible ? 0xFFFE : format_test.format_tag, 2, 48000, format_test.bits, extensible ? 40 : 18);
+            if (extensible) {
+                std::memcpy(format.data() + 24, &format_test.format_tag, 2);
+            }
+            std::vector<std::pair<std::string, std::vector<uint8_t>>> chunks = { { "LIST", { 'I', 'N', 'F', 'O', 'x' } }, { "fmt ", {} } };
+            if (extensible) {
+                chunks.push_back({ "fact", { 0x10, 0x27, 0, 0 } });
+            }
+            fs::path wav_file = fs::path("wav_reader_" + format_test.name + (extensible ? "_ext" : "") + ".wav");
+            write_wav(wav_file, format, chunks, data, (uint32_t)data.size());
+
+            WavReader wav_reader;
+            REQUIRE(wav_reader.open(wav_file));
+            CHECK(wav_reader.get_info().channels == 2);
+            CHECK(wav_reader.get_info().sample_rate == 48000);
+            CHECK(wav_reader.get_info().nb_frames == nb_frames);
+            std::vector<float> left_read, right_read, downmix_read;
+            REQUIRE(wav_reader.read_all(left_read, 0));
+            REQUIRE(wav_reader.read_all(right_read, 1));
+            REQUIRE(wav_reader.read_all(downmix_read));
+            double max_error = 0;
+            for (size_t i = 0; i < nb_frames; i++) {
+                max_error = (std::max)(max_error, (double)std::abs(left_read[i] - left[i]));
+                max_error = (std::max)(max_error, (double)std::abs(right_read[i] - right[i]));
+                max_error = (std::max)(max_error, (double)std::abs(downmix_read[i] - (left[i] + right[i]) / 2));
+            }
+            INFO(format_test.name);
+            CHECK(max_error <= format_test.tolerance);
+
+            // range reads (several conversion blocks), clipped at the end of the data
+            std::vector<float> range(WAV_READ_BLOCK_FRAMES + 100);
+            CHECK(wav_reader.read(range.data(), nb_frames - 50, range.size(), 0) == 50);
+            CHECK(range[49] == left_read[nb_frames - 1]);
+            CHECK(wav_reader.read(range.data(), 123, range.size(), 1) == range.size());
+            CHECK(range.back() == right_read[123 + range.size() - 1]);
+            CHECK(wav_reader.read(range.data(), 0, 10, 2) == 0);
+        }
+    }
+
+    // mono file whose data size is larger than the file (truncated capture)
+    std::vector<uint8_t> mono_data(2 * 1001, 0);
+    write_wav("wav_reader_truncated.wav", make_format(1, 1, 44100, 16, 16), { { "fmt ", {} } }, mono_data, 1 << 20);
+    WavReader truncated_reader;
+    REQUIRE(truncated_reader.open("wav_reader_truncated.wav"));
+    CHECK(truncated_reader.get_info().nb_frames == 1001);
+    // unsupported: 12 bit, no data chunk, not a RIFF file
+    write_wav("wav_reader_12bits.wav", make_format(1, 1, 44100, 12, 16), { { "fmt ", {} } }, mono_data, (uint32_t)mono_data.size());
+    CHECK(!WavReader().open("wav_reader_12bits.wav"));
+    CHECK(!WavReader().open(DICTIONARY_ENG));
+
+    // recorded capture, mapped: same samples as a plain read of the 16 bit data, then the same capture as 32 bit float
+    // after an odd sized chunk (data chunk at 2 bytes from a 4 byte boundary)
+    const fs::path recorded_file = fs::path("../../../data/audio_captures/Door unlock.wav");
+    WavReader recorded_reader;
+    REQUIRE(recorded_reader.open(recorded_file));
+    const WavInfo recorded_info = recorded_reader.get_info();
+    REQUIRE(recorded_info.sample_format == WavSampleFormat::Int16);
+    std::vector<float> recorded_left, recorded_downmix;
+    REQUIRE(recorded_reader.read_all(recorded_left, 0));
+    REQUIRE(recorded_reader.read_all(recorded_downmix));
+    std::vector<int16_t> recorded_pcm(recorded_info.nb_frames * recorded_info.channels);
+    {
+        std::ifstream file(recorded_file, std::ios::binary);
+        file.seekg(recorded_info.data_offset);
+        file.read(reinterpret_cast<char*>(recorded_pcm.data()), recorded_pcm.size() * sizeof(int16_t));
+        REQUIRE(file.gcount() == (std::streamsize)(recorded_pcm.size() * sizeof(int16_t)));
+    }
+    int nb_recorded_differences = 0;
+    for (size_t i = 0; i < recorded_info.nb_frames; i++) {
+        nb_recorded_differences += recorded_left[i] != recorded_pcm[i * recorded_info.channels] / 32768.0f;
+    }
+    CHECK(nb_recorded_differences == 0);
+
+    std::vector<uint8_t> float_data(recorded_downmix.size() * sizeof(float));
+    std::memcpy(float_data.data(), recorded_downmix.data(), float_data.size());
+    const fs::path unaligned_file = fs::temp_directory_path() / "wav_reader_unaligned.wav";
+    write_wav(unaligned_file, make_format(3, 1, recorded_info.sample_rate, 32, 16), { { "LIST", { 'I', 'N', 'F', 'O', 'x' } }, { "fmt ", {} } },
+        float_data, (uint32_t)float_data.size());
+    {
+        WavReader unaligned_reader;
+        REQUIRE(unaligned_reader.open(unaligned_file));
+        CHECK(unaligned_reader.get_info().data_offset % sizeof(float) != 0);
+        std::vector<float> unaligned_samples;
+        REQUIRE(unaligned_reader.read_all(unaligned_samples));
+        CHECK(unaligned_samples == recorded_downmix);
+    }
+    fs::remove(unaligned_file);
+
+    // 60 s stereo 16 bit capture: previous loop (one read and one seek per sample, growing vectors) vs mapped reader
+    const uint32_t sample_rate = 44100;
+    std::vector<uint8_t> capture_data(sample_rate * 60 * 4);
+    cv::RNG rng(5);
+    rng.fill(capture_data, cv::RNG::UNIFORM, 0, 256);
+    write_wav("wav_reader_capture.wav", make_format(1, 2, sample_rate, 16, 16), { { "fmt ", {} } }, capture_data, (uint32_t)capture_data.size());
+
+    auto start_previous = std::chrono::high_resolution_clock::now();
+    std::vector<float> previous_samples;
+    std::vector<int16_t> previous_samples_int16;
+    {
+        std::ifstream file("wav_reader_capture.wav", std::ios::binary);
+        file.seekg(44);
+        int16_t sample16;
+        while (file.read(reinterpret_cast<char*>(&sample16), sizeof(int16_t))) {
+            previous_samples.push_back(static_cast<float>(sample16) / 32768.0f);
+            previous_samples_int16.push_back(sample16);
+            file.seekg(sizeof(int16_t), std::ios_base::cur);
+        }
+    }
+    auto end_previous = std::chrono::high_resolution_clock::now();
+    std::vector<float> samples;
+    WavReader capture_reader;
+    REQUIRE(capture_reader.open("wav_reader_capture.wav"));
+    REQUIRE(capture_reader.read_all(samples, 0));
+    auto end_reader = std::chrono::high_resolution_clock::now();
+    std::vector<float> downmix_samples;
+    REQUIRE(capture_reader.read_all(downmix_samples));
+    auto end_downmix = std::chrono::high_resolution_clock::now();
+    CHECK(samples == previous_samples);
+
+    double duration_previous_ms = std::chrono::duration<double, std::milli>(end_previous - start_previous).count();
+    double duration_reader_ms = std::chrono::duration<double, std::milli>(end_reader - end_previous).count();
+    double duration_downmix_ms = std::chrono::duration<double, std::milli>(end_downmix - end_reader).count();
+    printf("============ BENCH RESULTS ============\n");
+    printf("capture_size_mb: %.1f (60 s stereo 16 bit)\n", capture_data.size() / 1e6);
+    printf("duration_previous_ms: %.1f\n", duration_previous_ms);
+    printf("duration_reader_first_channel_ms: %.1f (%.1fx)\n", duration_reader_ms, duration_previous_ms / (std::max)(duration_reader_ms, 1e-3));
+    printf("duration_reader_downmix_ms: %.1f\n", duration_downmix_ms);
+    printf("\n");
+}
+
+TEST_CASE("stream_words", "[audio][bench]")
+{
+    PRINT_TEST_HEADER("stream_words");
+
+    RuneDictionary dictionary(DICTIONARY_ENG);
+    ArpeggioDetector arpeggio_detector;
+    arpeggio_detector.load_dictionary(dictionary);
+    const size_t max_length = (size_t)arpeggio_detector.get_arpeggio_max_length();
+
+    // incremental matcher: same words as detect_words on the whole sequence, bounded pending notes
+    const std::vector<Note> word_no = { Note::F5, Note::G5, Note::D6, Note::G6, Note::C7, Note::D7 };
+    cv::RNG rng(17);
+    for (int test = 0; test < 50; test++) {
+        std::vector<Note> notes;
+        while (notes.size() < 300) {
+            if (rng.uniform(0, 3) == 0) {
+                int transpose = rng.uniform(-12, 6);
+                for (const auto& note : word_no) {
+                    notes.push_back((Note)((int)note + transpose));
+                }
+            }
+            else {
+                notes.push_back((Note)rng.uniform((int)Note::C4, (int)Note::C7));
+            }
+        }
+        std::vector<Word> batch_words;
+        arpeggio_detector.detect_words(notes, batch_words);
+
+        WordMatcher matcher(arpeggio_detector);
+        std::vector<Word> stream_words;
+        size_t max_pending_notes = 0;
+        for (const auto& note : notes) {
+            matcher.push(note, stream_words);
+            max_pending_notes = (std::max)(max_pending_notes, matcher.get_nb_pending_notes());
+        }
+        matcher.finish(stream_words);
+        REQUIRE(stream_words.size() == batch_words.size());
+        for (size_t i = 0; i < batch_words.size(); i++) {
+            CHECK(stream_words[i].get_hash() == batch_words[i].get_hash());
+        }
+        CHECK(max_pending_notes <= max_length);
+    }
+
+    // generated capture: "no" four times in four keys, repeated
+    const std::vector<Note> words_notes = { Note::F5, Note::G5, Note::D6, Note::G6, Note::C7, Note::D7, Note::C5, Note::D5, Note::A5, Note::D6, Note::G6, Note::A6,
+        Note::Eb5, Note::F5, Note::C6, Note::F6, Note::Bb6, Note::C7, Note::Bb4, Note::C5, Note::G5, Note::C6, Note::F6, Note::G6 };
+    const int nb_repetitions = 10;
+    std::vector<std::pair<Note, double>> notes_with_durations;
+    for (int repetition = 0; repetition < nb_repetitions; repetition++) {
+        for (const auto& note : words_notes) {
+            notes_with_durations.push_back(std::pair(note, 0.150));
+        }
+        notes_with_durations.push_back(std::pair(Note::SILENCE, 0.300));
+    }
+    fs::path wav_file = fs::temp_directory_path() / "stream_words.wav";
+    generate_wav(notes_with_durations, wav_file);
+
+    printf("============ BENCH RESULTS ============\n");
+    for (bool yin_algo : { false, true }) {
+        auto start_batch = std::chrono::high_resolution_clock::now();
+        auto detected_sequence = arpeggio_detector.detect_note_sequence(wav_file, DEFAULT_NOTE_LENGTH, yin_algo);
+        auto note_sequence = arpeggio_detector.get_clean_sequence(detected_sequence);
+        std::vector<Word> batch_words;
+        arpeggio_detector.detect_words(note_sequence, batch_words);
+        auto end_batch = std::chrono::high_resolution_clock::now();
+
+        std::vector<Note> stream_notes;
+        std::vector<Word> stream_words;
+        size_t nb_notes_at_first_word = 0;
+        bool decoded = arpeggio_detector.stream_words(wav_file, DEFAULT_NOTE_LENGTH, yin_algo,
+            [&](const Word& word) {
+                if (stream_words.empty()) {
+                    nb_notes_at_first_word = stream_notes.size();
+                }
+                stream_words.push_back(word);
+            },
+            [&](Note note) {
+                stream_notes.push_back(note);
+            });
+        auto end_stream = std::chrono::high_resolution_clock::now();
+
+        REQUIRE(decoded);
+        CHECK(stream_notes == note_sequence);
+        REQUIRE(stream_words.size() == batch_words.size());
+        for (size_t i = 0; i < batch_words.size(); i++) {
+            CHECK(stream_words[i].get_hash() == batch_words[i].get_hash());
+        }
+        REQUIRE(!stream_words.empty());
+        // the first word is out long before the end of the recording (once max_length notes follow its first note)
+        CHECK(nb_notes_at_first_word <= words_notes.size() + max_length);
+        CHECK(nb_notes_at_first_word < stream_notes.size() / 2);
+
+        double duration_batch_ms = std::chrono::duration<double, std::milli>(end_batch - start_batch).count();
+        double duration_stream_ms = std::chrono::duration<double, std::milli>(end_stream - end_batch).count();
+        const char* algo = yin_algo ? "yin" : "fft";
+        printf("capture_%s: %.1f s, %zu notes, %zu words\n", algo, notes_with_durations.size() * 0.150, stream_notes.size(), stream_words.size());
+        printf("duration_batch_%s_ms: %.1f\n", algo, duration_batch_ms);
+        printf("duration_stream_%s_ms: %.1f (%zu frame blocks, at most %zu pending notes)\n", algo, duration_stream_ms, AUDIO_STREAM_BLOCK_FRAMES, max_length);
+        printf("first_word_after_notes_%s: %zu\n", algo, nb_notes_at_first_word);
+    }
+    printf("\n");
+    fs::remove(wav_file);
+}
+
+TEST_CASE("arpeggio_stream", "[audio][bench]")
+{
+    PRINT_TEST_HEADER("arpeggio_stream");
+
+    RuneDictionary dictionary(DICTIONARY_ENG);
+    ArpeggioDetector arpeggio_detector;
+    arpeggio_detector.load_dictionary(dictionary);
+
+    // generated capture: "no" four times in four keys, repeated
+    const std::vector<Note> words_notes = { Note::F5, Note::G5, Note::D6, Note::G6, Note::C7, Note::D7, Note::C5, Note::D5, Note::A5, Note::D6, Note::G6, Note::A6,
+        Note::Eb5, Note::F5, Note::C6, Note::F6, Note::Bb6, Note::C7, Note::Bb4, Note::C5, Note::G5, Note::C6, Note::F6, Note::G6 };
+    const int nb_repetitions = 12;
+    std::vector<std::pair<Note, double>> notes_with_durations;
+    for (int repetition = 0; repetition < nb_repetitions; repetition++) {
+        for (const auto& note : words_notes) {
+            notes_with_durations.push_back(std::pair(note, 0.150));
+        }
+        notes_with_durations.push_back(std::pair(Note::SILENCE, 0.600));
+    }
+    fs::path wav_file = fs::temp_directory_path() / "arpeggio_stream.wav";
+    generate_wav(notes_with_durations, wav_file);
+    WavReader wav_reader;
+    REQUIRE(wav_reader.open(wav_file));
+    std::vector<float> samples;
+    REQUIRE(wav_reader.read_all(samples, 0));
+    const uint32_t sample_rate = wav_reader.get_info().sample_rate;
+    const double duration = (double)samples.size() / sample_rate;
+    std::vector<int16_t> samples_16(samples.size());
+    for (size_t i = 0; i < samples.size(); i++) {
+        samples_16[i] = (int16_t)std::clamp(std::lround(samples[i] * 32768.0f), -32768L, 32767L);
+    }
+
+    printf("============ BENCH RESULTS ============\n");
+    for (bool yin_algo : { false, true }) {
+        std::vector<Word> file_words;
+        REQUIRE(arpeggio_detector.stream_words(wav_file, DEFAULT_NOTE_LENGTH, yin_algo, [&](const Word& word) { file_words.push_back(word); }));
+        REQUIRE(!file_words.empty());
+
+        // no latency bound, blocks of any size (float and 16 bit): the words of the whole file
+        ArpeggioStreamConfig config;
+        config.sample_rate = sample_rate;
+        config.yin_algo = yin_algo;
+        config.latency = 0.0;
+        for (bool pcm_16 : { false, true }) {
+            std::vector<TimedWord> words;
+            std::vector<TimedNote> notes;
+            ArpeggioStream stream(arpeggio_detector);
+            REQUIRE(stream.init(config, [&](const TimedWord& word) { words.push_back(word); }, [&](const TimedNote& note) { notes.push_back(note); }));
+            cv::RNG rng(23);
+            for (size_t position = 0; position < samples.size(); ) {
+                size_t count = (std::min)((size_t)rng.uniform(1, 4096), samples.size() - position);
+                if (pcm_16) {
+                    stream.push(samples_16.data() + position, count);
+                }
+                else {
+                    stream.push(samples.data() + position, count);
+                }
+                position += count;
+            }
+            stream.flush();
+            CHECK(stream.get_time() == Approx(duration));
+            CHECK(stream.get_nb_pending_notes() == 0);
+            REQUIRE(words.size() == file_words.size());
+            for (size_t i = 0; i < words.size(); i++) {
+                CHECK(words[i].word.get_hash() == file_words[i].get_hash());
+                CHECK(words[i].start < words[i].end);
+                CHECK(words[i].end <= words[i].decided);
+            }
+            for (size_t i = 1; i < notes.size(); i++) {
+                CHECK(notes[i - 1].start < notes[i].start);
+            }
+        }
+
+        // latency bound: every word is out at most latency (plus one analysis hop) after its last note
+        for (double latency : { 250.0, ARPEGGIO_STREAM_DEFAULT_LATENCY }) {
+            config.latency = latency;
+            std::vector<TimedWord> words;
+            ArpeggioStream stream(arpeggio_detector);
+            REQUIRE(stream.init(config, [&](const TimedWord& word) { words.push_back(word); }));
+            const size_t block_size = sample_rate / 100; // 10 ms capture period
+            size_t nb_words_pushed = 0;
+            // sustained processing on one core
+            const int nb_threads = cv::getNumThreads();
+            cv::setNumThreads(1);
+            auto start = std::chrono::high_resolution_clock::now();
+            for (size_t position = 0; position < samples.size(); position += block_size) {
+                nb_words_pushed += stream.push(samples.data() + position, (std::min)(block_size, samples.size() - position));
+            }
+            stream.flush();
+            auto end = std::chrono::high_resolution_clock::now();
+            cv::setNumThreads(nb_threads);
+
+            REQUIRE(nb_words_pushed > 0);
+            REQUIRE(nb_words_pushed <= words.size());
+            double max_delay = 0.0, mean_delay = 0.0;
+            for (size_t i = 0; i < nb_words_pushed; i++) {
+                double delay = words[i].decided - words[i].end;
+                CHECK(delay <= (latency + DEFAULT_NOTE_LENGTH) / 1000.0 + 1e-9);
+                max_delay = (std::max)(max_delay, delay);
+                mean_delay += delay / nb_words_pushed;
+            }
+            double process_time = std::chrono::duration<double>(end - start).count();
+            double real_time_factor = process_time / duration;
+            // below real time on one core (loose bound: the factor depends on the machine, it is reported below)
+            CHECK(real_time_factor < 1.0);
+            const char* algo = yin_algo ? "yin" : "fft";
+            printf("duration_%s_latency_%.0f_ms: %.1f (%.1f s capture in 10 ms blocks)\n", algo, latency, process_time * 1000.0, duration);
+            printf("real_time_factor_%s_latency_%.0f: %.4f\n", algo, latency, real_time_factor);
+            printf("words_%s_latency_%.0f: %zu (%zu without bound)\n", algo, latency, words.size(), file_words.size());
+            printf("word_delay_%s_latency_%.0f_ms: mean %.0f, max %.0f\n", algo, latency, mean_delay * 1000.0, max_delay * 1000.0);
+        }
+    }
+    printf("\n");
+    wav_reader.close();
+    fs::remove(wav_file);
+}
+
+TEST_CASE("polyphase_resampler", "[audio][bench]")
+{
+    PRINT_TEST_HEADER("polyphase_resampler");
+
+    // 48 kHz -> 44.1 kHz (up 147, down 160): the same sine, late by the filter delay, for blocks of any size
+    auto make_sine = [](double frequency, uint32_t sample_rate, size_t count) {
+        std::vector<float> samples(count);
+        for (size_t i = 0; i < count; i++) {
+            samples[i] = (float)(0.5 * std::sin(2 * std::numbers::pi * frequency * i / sample_rate));
+        }
+        return samples;
+    };
+    std::vector<float> input = make_sine(1000.0, 48000, 48000);
+    PolyphaseResampler resampler(48000, 44100);
+    REQUIRE(resampler.is_valid());
+    CHECK(resampler.get_up() == 147);
+    CHECK(resampler.get_down() == 160);
+    std::vector<float> output, block_output, blocks_output;
+    resampler.process(input.data(), input.size(), output);
+    CHECK(output.size() == 44100);
+    double max_error = 0.0;
+    for (size_t i = output.size() / 4; i < output.size() * 3 / 4; i++) {
+        double expected = 0.5 * std::sin(2 * std::numbers::pi * 1000.0 * ((double)i / 44100 - resampler.get_delay()));
+        max_error = (std::max)(max_error, std::abs(output[i] - expected));
+    }
+    CHECK(max_error < 1e-4);
+    resampler.reset();
+    cv::RNG rng(31);
+    for (size_t position = 0; position < input.size(); ) {
+        size_t count = (std::min)((size_t)rng.uniform(1, 2000), input.size() - position);
+        resampler.process(input.data() + position, count, block_output);
+        blocks_output.insert(blocks_output.end(), block_output.begin(), block_output.end());
+        position += count;
+    }
+    CHECK(blocks_output == output);
+
+    // decimation by 4: a tone above the new Nyquist frequency is removed, a note below is kept
+    PolyphaseResampler decimator(44100, 11025);
+    std::vector<float> alias = make_sine(8000.0, 44100, 44100), note = make_sine(note_frequencies.at(Note::D7), 44100, 44100);
+    decimator.process(alias.data(), alias.size(), output);
+    float alias_peak = 0.0f;
+    for (size_t i = output.size() / 4; i < output.size(); i++) {
+        alias_peak = (std::max)(alias_peak, std::abs(output[i]));
+    }
+    CHECK(alias_peak < 1e-3f);
+    decimator.reset();
+    decimator.process(note.data(), note.size(), output);
+    float note_peak = 0.0f;
+    for (size_t i = output.size() / 4; i < output.size(); i++) {
+        note_peak = (std::max)(note_peak, std::abs(output[i]));
+    }
+    CHECK(std::abs(note_peak - 0.5f) < 1e-3f);
+
+    // lowest rates keeping the arpeggio notes: FFT (pass band) and YIN (YIN_MIN_PERIOD samples per period)
+    const double fft_min_rate = 2 * ARPEGGIO_STREAM_MAX_FREQUENCY / RESAMPLER_PASSBAND;
+    const double yin_min_rate = YIN_MIN_PERIOD * ARPEGGIO_STREAM_MAX_FREQUENCY;
+    CHECK(PolyphaseResampler::get_decimated_rate(44100, fft_min_rate) == 6300);
+    CHECK(PolyphaseResampler::get_decimated_rate(48000, fft_min_rate) == 6000);
+    CHECK(PolyphaseResampler::get_decimated_rate(44100, yin_min_rate) == 22050);
+    CHECK(PolyphaseResampler::get_decimated_rate(48000, yin_min_rate) == 24000);
+    CHECK(PolyphaseResampler::get_decimated_rate(8000, yin_min_rate) == 8000);
+
+    // YIN at the decimated rate: the notes of the arpeggios, a dip between two lags for the highest ones
+    for (const auto& arpeggio_note : { Note::Bb4, Note::A5, Note::G6, Note::D7 }) {
+        std::vector<float> samples = make_sine(note_frequencies.at(arpeggio_note), 44100, 44100);
+        PolyphaseResampler yin_decimator(44100, 22050);
+        yin_decimator.process(samples.data(), samples.size(), output);
+        size_t window_size = static_cast<size_t>(std::lround(22050 * YIN_WINDOW_DURATION));
+        YinDetector yin(22050, window_size);
+        yin.set_parabolic_threshold(true);
+        for (size_t offset = 2000; offset + window_size <= output.size(); offset += window_size) {
+            float pitch = yin.get_pitch(output.data() + offset);
+            CHECK((Note)std::lround(frequencyToMidiNote(pitch)) == arpeggio_note);
+        }
+    }
+
+    // 48 kHz capture: resampled to 44.1 kHz or decimated, the words of the 44.1 kHz file
+    RuneDictionary dictionary(DICTIONARY_ENG);
+    ArpeggioDetector arpeggio_detector;
+    arpeggio_detector.load_dictionary(dictionary);
+    const std::vector<Note> words_notes = { Note::F5, Note::G5, Note::D6, Note::G6, Note::C7, Note::D7, Note::C5, Note::D5, Note::A5, Note::D6, Note::G6, Note::A6,
+        Note::Eb5, Note::F5, Note::C6, Note::F6, Note::Bb6, Note::C7, Note::Bb4, Note::C5, Note::G5, Note::C6, Note::F6, Note::G6 };
+    std::vector<std::pair<Note, double>> notes_with_durations;
+    for (int repetition = 0; repetition < 8; repetition++) {
+        for (const auto& word_note : words_notes) {
+            notes_with_durations.push_back(std::pair(word_note, 0.150));
+        }
+        notes_with_durations.push_back(std::pair(Note::SILENCE, 0.300));
+    }
+    fs::path wav_file = fs::path("polyphase_resampler.wav");
+    generate_wav(notes_with_durations, wav_file);
+    WavReader wav_reader;
+    REQUIRE(wav_reader.open(wav_file));
+    std::vector<float> samples;
+    REQUIRE(wav_reader.read_all(samples, 0));
+    REQUIRE(wav_reader.get_info().sample_rate == 44100);
+    std::vector<float> samples_48k;
+    PolyphaseResampler upsampler(44100, 48000);
+    upsampler.process(samples.data(), samples.size(), samples_48k);
+    const double duration = (double)samples_48k.size() / 48000;
+
+    printf("============ BENCH RESULTS ============\n");
+    for (bool yin_algo : { false, true }) {
+        std::vector<Word> file_words;
+        REQUIRE(arpeggio_detector.stream_words(wav_file, DEFAULT_NOTE_LENGTH, yin_algo, [&](const Word& word) { file_words.push_back(word); }));
+        REQUIRE(!file_words.empty());
+        double native_ms = 0.0;
+        for (int mode = 0; mode < 3; mode++) {
+            ArpeggioStreamConfig config;
+            config.sample_rate = 48000;
+            config.analysis_rate = mode == 1 ? 44100 : 0;
+            config.decimate = mode == 2;
+            config.yin_algo = yin_algo;
+            config.latency = 0.0;
+            std::vector<Word> words;
+            ArpeggioStream stream(arpeggio_detector);
+            REQUIRE(stream.init(config, [&](const TimedWord& word) { words.push_back(word.word); }));
+            auto start = std::chrono::high_resolution_clock::now();
+            for (size_t position = 0; position < samples_48k.size(); position += 480) {
+                stream.push(samples_48k.data() + position, (std::min)((size_t)480, samples_48k.size() - position));
+            }
+            stream.flush();
+            double duration_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+            native_ms = mode == 0 ? duration_ms : native_ms;
+
+            if (mode > 0) {
+                REQUIRE(words.size() == file_words.size());
+                for (size_t i = 0; i < words.size(); i++) {
+                    CHECK(words[i].get_hash() == file_words[i].get_hash());
+                }
+            }
+            printf("duration_%s_%u_hz_ms: %.1f (%zu words in %.1f s of 48 kHz capture, %.2fx the native rate time)\n", yin_algo ? "yin" : "fft",
+                stream.get_analysis_rate(), duration_ms, words.size(), duration, duration_ms / (std::max)(native_ms, 1e-3));
+        }
+    }
+    printf("\n");
+}
+
+TEST_CASE("note_quantizer", "[audio][bench]")
+{
+    PRINT_TEST_HEADER("note_quantizer");
+
+    // every note of the range, a deviation, the range limits and the tolerance
+    NoteQuantizer quantizer;
+    for (const auto& [note, frequency] : note_frequencies) {
+        if (note == Note::SILENCE) {
+            continue;
+        }
+        QuantizedNote quantized = quantizer.quantize(frequency);
+        CHECK(quantized.note == note);
+        CHECK(std::abs(quantized.cents) < 1.0);
+        CHECK(quantized.confidence > 0.98);
+    }
+    QuantizedNote sharp = quantizer.quantize(440.0 * std::pow(2.0, 20.0 / 1200.0));
+    CHECK(sharp.note == Note::A4);
+    CHECK(sharp.cents == Approx(20.0).margin(1e-6));
+    CHECK(sharp.confidence == Approx(0.6).margin(1e-6));
+    CHECK(quantizer.quantize(note_frequencies.at(Note::C0) * 0.96).note == Note::UNKNOWN);
+    CHECK(quantizer.quantize(note_frequencies.at(Note::B8) * 1.04).note == Note::UNKNOWN);
+    CHECK(quantizer.quantize(-1.0).note == Note::UNKNOWN);
+    NoteQuantizer strict_quantizer(30.0);
+    CHECK(strict_quantizer.quantize(440.0 * std::pow(2.0, 40.0 / 1200.0)).note == Note::UNKNOWN);
+    strict_quantizer.set_tuning(40.0);
+    CHECK(strict_quantizer.quantize(440.0 * std::pow(2.0, 40.0 / 1200.0)).note == Note::A4);
+
+    // same notes as the previous linear search (nearest frequency of note_frequencies, 3% tolerance), except within a
+    // cent of the midpoint between two notes (arithmetic vs geometric)
+    cv::RNG rng(41);
+    std::vector<double> frequencies(200000);
+    for (auto& frequency : frequencies) {
+        frequency = note_frequencies.at(Note::C0) * std::pow(2.0, rng.uniform(0.0, 8.99));
+    }
+    auto start_previous = std::chrono::high_resolution_clock::now();
+    std::vector<Note> previous_notes;
+    previous_notes.reserve(frequencies.size());
+    for (double frequency : frequencies) {
+        double min_dist = std::numeric_limits<double>::max();
+        Note best_match = Note::UNKNOWN;
+        for (const auto& note : note_frequencies) {
+            double dist = std::abs(note.second - frequency);
+            if (dist < min_dist) {
+                min_dist = dist;
+                best_match = note.first;
+            }
+        }
+        previous_notes.push_back(min_dist / frequency < 0.03 ? best_match : Note::UNKNOWN);
+    }
+    auto end_previous = std::chrono::high_resolution_clock::now();
+    std::vector<QuantizedNote> quantized_notes;
+    quantized_notes.reserve(frequencies.size());
+    for (double frequency : frequencies) {
+        quantized_notes.push_back(quantizer.quantize(frequency));
+    }
+    auto end_quantizer = std::chrono::high_resolution_clock::now();
+    size_t nb_compared = 0;
+    for (size_t i = 0; i < frequencies.size(); i++) {
+        if (std::abs(quantized_notes[i].cents) < 49.0) {
+            CHECK(quantized_notes[i].note == previous_notes[i]);
+            nb_compared++;
+        }
+    }
+    CHECK(nb_compared > frequencies.size() * 9 / 10);
+
+    // tuning: deviations around the detuning (vibrato), wrong pitches anywhere, and a detuning close to half a semitone
+    for (double detuning : { 0.0, 25.0, -45.0, 49.0 }) {
+        TuningEstimator tuning_estimator;
+        double tuning = 0.0;
+        CHECK(!tuning_estimator.estimate(tuning));
+        for (int i = 0; i < 2000; i++) {
+            double cents = rng.uniform(0, 5) == 0 ? rng.uniform(-50.0, 50.0) : detuning + rng.gaussian(8.0);
+            tuning_estimator.add(note_frequencies.at((Note)rng.uniform((int)Note::C4, (int)Note::C7)) * std::pow(2.0, cents / 1200.0));
+        }
+        REQUIRE(tuning_estimator.estimate(tuning));
+        double error = std::remainder(tuning - detuning, 100.0);
+        CHECK(std::abs(error) < 2.0);
+    }
+
+    // detuned capture (+45 cents, 12 cents of vibrato): the notes of the words once the quantisation follows the tuning
+    const std::vector<Note> words_notes = { Note::F5, Note::G5, Note::D6, Note::G6, Note::C7, Note::D7, Note::C5, Note::D5, Note::A5, Note::D6, Note::G6, Note::A6,
+        Note::Eb5, Note::F5, Note::C6, Note::F6, Note::Bb6, Note::C7, Note::Bb4, Note::C5, Note::G5, Note::C6, Note::F6, Note::G6 };
+    const int nb_repetitions = 4;
+    const uint32_t sample_rate = 44100;
+    const size_t note_samples = sample_rate * 150 / 1000;
+    std::vector<int16_t> pcm;
+    std::vector<Note> expected_notes;
+    double phase = 0.0;
+    for (int repetition = 0; repetition < nb_repetitions; repetition++) {
+        for (const auto& note : words_notes) {
+            for (size_t i = 0; i < note_samples; i++) {
+                double cents = 45.0 + 12.0 * std::sin(2 * std::numbers::pi * 5.5 * (double)(pcm.size()) / sample_rate);
+                phase += 2 * std::numbers::pi * note_frequencies.at(note) * std::pow(2.0, cents / 1200.0) / sample_rate;
+                pcm.push_back((int16_t)std::lround(16384 * std::sin(phase)));
+            }
+            expected_notes.push_back(note);
+        }
+    }
+    fs::path detuned_file = fs::path("note_quantizer_detuned.wav");
+    {
+        uint32_t data_size = (uint32_t)(pcm.size() * sizeof(int16_t)), riff_size = 36 + data_size, format_size = 16, byte_rate = sample_rate * 2;
+        uint16_t format_tag = 1, channels = 1, block_align = 2, bits = 16;
+        std::ofstream file(detuned_file, std::ios::binary);
+        file.write("RIFF", 4);
+        file.write(reinterpret_cast<const char*>(&riff_size), 4);
+        file.write("WAVEfmt ", 8);
+        file.write(reinterpret_cast<const char*>(&format_size), 4);
+        file.write(reinterpret_cast<const char*>(&format_tag), 2);
+        file.write(reinterpret_cast<const char*>(&channels), 2);
+        file.write(reinterpret_cast<const char*>(&sample_rate), 4);
+        file.write(reinterpret_cast<const char*>(&byte_rate), 4);
+        file.write(reinterpret_cast<const char*>(&block_align), 2);
+        file.write(reinterpret_cast<const char*>(&bits), 2);
+        file.write("data", 4);
+        file.write(reinterpret_cast<const char*>(&data_size), 4);
+        file.write(reinterpret_cast<const char*>(pcm.data()), data_size);
+    }
+
+    RuneDictionary dictionary(DICTIONARY_ENG);
+    ArpeggioDetector arpeggio_detector;
+    arpeggio_detector.load_dictionary(dictionary);
+    std::vector<Word> expected_words;
+    arpeggio_detector.detect_words(expected_notes, expected_words);
+    REQUIRE(!expected_words.empty());
+
+    // whole recording: the tuning is estimated before the quantisation
+    auto batch_notes = arpeggio_detector.get_clean_sequence(arpeggio_detector.detect_note_sequence(detuned_file, DEFAULT_NOTE_LENGTH, false));
+    CHECK(batch_notes == expected_notes);
+
+    double duration_previous_ms = std::chrono::duration<double, std::milli>(end_previous - start_previous).count();
+    double duration_quantizer_ms = std::chrono::duration<double, std::milli>(end_quantizer - end_previous).count();
+    printf("============ BENCH RESULTS ============\n");
+    printf("nb_pitches: %zu\n", frequencies.size());
+    printf("duration_linear_search_ms: %.2f\n", duration_previous_ms);
+    printf("duration_quantizer_ms: %.2f (%.1fx)\n", duration_quantizer_ms, duration_previous_ms / (std::max)(duration_quantizer_ms, 1e-3));
+
+    // stream: running estimate, the first notes are quantised before it is available
+    for (bool yin_algo : { false, true }) {
+        for (bool estimate_tuning : { false, true }) {
+            ArpeggioStreamConfig config;
+            config.sample_rate = sample_rate;
+            config.yin_algo = yin_algo;
+            config.latency = 0.0;
+            config.estimate_tuning = estimate_tuning;
+            std::vector<Word> words;
+            std::vector<Note> notes;
+            ArpeggioStream stream(arpeggio_detector);
+            REQUIRE(stream.init(config, [&](const TimedWord& word) { words.push_back(word.word); }, [&](const TimedNote& note) { notes.push_back(note.note); }));
+            stream.push(pcm.data(), pcm.size());
+            stream.flush();
+            if (estimate_tuning) {
+                CHECK(std::abs(stream.get_tuning() - 45.0) < 5.0);
+                if (!yin_algo) {
+                    CHECK(words.size() + 1 >= expected_words.size());
+                }
+            }
+            size_t nb_wrong_notes = 0;
+            for (const auto& note : notes) {
+                nb_wrong_notes += std::find(words_notes.begin(), words_notes.end(), note) == words_notes.end() ? 1 : 0;
+            }
+            const char* label = estimate_tuning ? "estimated" : "equal_temperament";
+            const char* algo = yin_algo ? "yin" : "fft";
+            printf("tuning_%s_%s_cents: %+.1f (+45 cents capture)\n", algo, label, stream.get_tuning());
+            printf("notes_%s_%s: %zu (%zu not in the words)\n", algo, label, notes.size(), nb_wrong_notes);
+            printf("words_%s_%s: %zu / %zu\n", algo, label, words.size(), expected_words.size());
+        }
+    }
+    printf("\n");
+}
@@ -9,123 +9,195 @@
 #include <map>     // For std::map
 #include <string>  // For std::string in main's debug output
 #include <cstdint> // For uint16_t, uint32_t, int16_t etc.
+#include <cstring> // For std::memcmp
 #include <sstream> // Required for std::ostringstream and std::istringstream
 #include <opencv2/opencv.hpp> // For cv::Mat, cv::Size, cv::resize
 #include <algorithm>          // For std::min
+#include <chrono>
+#include <opencv2/core/hal/intrin.hpp> // OpenCV universal intrinsics
 
 // Define PI if not available (M_PI is a common GNU extension)
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
-bool find_horizontal_separator(const cv::Mat& binary_image, int& line_center_y, int& separator_tickness)
-{
-
-	// Find the Row with the Most White Pixels
-	long long max_white_pixels_in_row = 0;
-	int best_y_pos_top = -1; // Top-most y-coordinate of the thick line
-	int best_y_pos_bottom = -1; // Bottom-most y-coordinate of the thick line
-	double WHITE_SEP_PERCENT_THRESOLD = 0.75;
-
-	// Iterate through each row of the binary image
-	for (int y = 0; y < binary_image.rows; ++y) {
+// Projection kernels: the pixel counts are vectorised with the OpenCV universal intrinsics or done by OpenCV itself
+// (cv::compare and cv::reduce have their own CPU dispatch). CV_SIMD follows the compiler flags of this file: without
+// -march that is the baseline width (SSE2 / NEON), there is no runtime AVX2 / AVX-512 dispatch here
 
-		// Get a pointer to the current row's data for efficiency
-		const uchar* row_ptr = binary_image.ptr<uchar>(y);
-		long long current_row_white_pixels = 0;
-
-		// Count white pixels (where value is 255) in the current row
-		for (int x = 0; x < binary_image.cols; ++x) {
-			if (row_ptr[x] == 255) {
-				current_row_white_pixels++;
+bool count_value_per_row(const cv::Mat& image, uchar value, std::vector<int>& counts)
+{
+	if (image.empty() || image.type() != CV_8U) {
+		std::cerr << "Error: Row projection expects a non empty CV_8U image." << std::endl;
+		return false;
+	}
+	counts.assign(image.rows, 0);
+	for (int y = 0; y < image.rows; ++y) {
+		const uchar* row_ptr = image.ptr<uchar>(y);
+		int x = 0;
+		int count = 0;
+#if (CV_SIMD || CV_SIMD_SCALABLE)
+		const int lanes = cv::VTraits<cv::v_uint8>::vlanes();
+		const cv::v_uint8 v_value = cv::vx_setall_u8(value);
+		const cv::v_uint8 v_one = cv::vx_setall_u8(1);
+		while (x <= image.cols - lanes) {
+			// 8 bit lane counters, summed before they can overflow
+			cv::v_uint8 v_count = cv::vx_setzero_u8();
+			for (int block = 0; block < 255 && x <= image.cols - lanes; ++block, x += lanes) {
+				v_count = cv::v_add(v_count, cv::v_and(cv::v_eq(cv::vx_load(row_ptr + x), v_value), v_one));
 			}
+			cv::v_uint16 v_count_low, v_count_high;
+			cv::v_expand(v_count, v_count_low, v_count_high);
+			count += (int)cv::v_reduce_sum(cv::v_add(v_count_low, v_count_high));
 		}
-
-		if (current_row_white_pixels > max_white_pixels_in_row) {
-			max_white_pixels_in_row = current_row_white_pixels;
+#endif
+		for (; x < image.cols; ++x) {
+			count += row_ptr[x] == value;
 		}
+		counts[y] = count;
+	}
+	return true;
+}
 
-		// If this row has a significant amount of white pixels (e.g., > 90% of width)
-		// AND we haven't started detecting the line yet, mark it as the top.
-		// This threshold (0.1) can be adjusted.
-		if (current_row_white_pixels > (binary_image.cols * WHITE_SEP_PERCENT_THRESOLD) && best_y_pos_top == -1) {
-			best_y_pos_top = y;
-		}
-		// If this row has fewer white pixels than the threshold AND we have started detecting,
-		// it means we've passed the bottom of the line.
-		if (current_row_white_pixels <= (binary_image.cols * WHITE_SEP_PERCENT_THRESOLD) && best_y_pos_top != -1 && best_y_pos_bottom == -1) {
-			best_y_pos_bottom = y;
-		}
+bool count_value_per_column(const cv::Mat& image, uchar value, std::vector<int>& counts)
+{
+	if (image.empty() || image.type() != CV_8U) {
+		std::cerr << "Error: Column projection expects a non empty CV_8U image." << std::endl;
+		return false;
 	}
+	cv::Mat mask, sums;
+	cv::compare(image, value, mask, cv::CMP_EQ);
+	cv::reduce(mask, sums, 0, cv::REDUCE_SUM, CV_32S);
+	counts.resize(image.cols);
+	const int* sums_ptr = sums.ptr<int>(0);
+	for (int x = 0; x < image.cols; ++x) {
+		counts[x] = sums_ptr[x] / 255;
+	}
+	return true;
+}
 
+bool find_value_bounds(const uchar* data, int length, uchar value, int& first, int& last)
+{
+	first = -1;
+	last = -1;
+	int x = 0;
+#if (CV_SIMD || CV_SIMD_SCALABLE)
+	const int lanes = cv::VTraits<cv::v_uint8>::vlanes();
+	const cv::v_uint8 v_value = cv::vx_setall_u8(value);
+	// skip the blocks without any match, the exact position is found by the scalar loops
+	while (x <= length - lanes && !cv::v_check_any(cv::v_eq(cv::vx_load(data + x), v_value))) {
+		x += lanes;
+	}
+#endif
+	for (; x < length; ++x) {
+		if (data[x] == value) {
+			first = x;
+			break;
+		}
+	}
+	if (first == -1) {
+		return false;
+	}
 
+	int end = length;
+#if (CV_SIMD || CV_SIMD_SCALABLE)
+	while (end - lanes >= first && !cv::v_check_any(cv::v_eq(cv::vx_load(data + end - lanes), v_value))) {
+		end -= lanes;
+	}
+#endif
+	for (x = end - 1; x >= first; --x) {
+		if (data[x] == value) {
+			last = x;
+			break;
+		}
+	}
+	return true;
+}
 
-	// Handle case where line goes to the bottom of the image
-	if (best_y_pos_top != -1 && best_y_pos_bottom == -1) {
-		best_y_pos_bottom = binary_image.rows - 1;
+bool find_first_run_above(const std::vector<int>& profile, double threshold, int& run_begin, int& run_end)
+{
+	run_begin = -1;
+	run_end = -1;
+	for (int i = 0; i < (int)profile.size(); ++i) {
+		if (profile[i] > threshold) {
+			run_begin = i;
+			break;
+		}
+	}
+	if (run_begin == -1) {
+		return false;
+	}
+	run_end = run_begin + 1;
+	while (run_end < (int)profile.size() && profile[run_end] > threshold) {
+		run_end++;
+	}
+	return true;
+}
 
-		// no separation line found
+bool find_profile_bounds(const std::vector<int>& profile, int& first, int& last)
+{
+	first = -1;
+	last = -1;
+	for (int i = 0; i < (int)profile.size(); ++i) {
+		if (profile[i] > 0) {
+			first = i;
+			break;
+		}
+	}
+	if (first == -1) {
+		return false;
 	}
+	for (last = (int)profile.size() - 1; profile[last] <= 0; --last);
+	return true;
+}
 
+bool find_horizontal_separator(const cv::Mat& binary_image, int& line_center_y, int& separator_tickness)
+{
+	double WHITE_SEP_PERCENT_THRESOLD = 0.75;
 	separator_tickness = 0;
 	line_center_y = -1;
-	if (best_y_pos_top != -1 && best_y_pos_bottom != -1) {
-		// Top-left Y of the line region
-		int line_top_y = best_y_pos_top;
-		// Height of the detected line region
-		separator_tickness = best_y_pos_bottom - best_y_pos_top + 1;
-		// Center Y position of the line
-		line_center_y = line_top_y + separator_tickness / 2;
 
-		// final check on line_center_y and separator_tickness
+	// The separator is the first band of rows with a significant amount of white pixels
+	std::vector<int> row_white_pixels;
+	int line_top_y = -1;
+	int line_end_y = -1;
+	if (!count_value_per_row(binary_image, 255, row_white_pixels) ||
+		!find_first_run_above(row_white_pixels, binary_image.cols * WHITE_SEP_PERCENT_THRESOLD, line_top_y, line_end_y)) {
+		// no separation line found
+		return false;
+	}
+
+	// Handle case where line goes to the bottom of the image
+	int line_bottom_y = (std::min)(line_end_y, binary_image.rows - 1);
 
+	// Height of the detected line region
+	separator_tickness = line_bottom_y - line_top_y + 1;
+	// Center Y position of the line
+	line_center_y = line_top_y + separator_tickness / 2;
 
-		// if ticknckness is greater than 20% of the image height, it is probably not a separator line
-		if (separator_tickness > (0.2 * binary_image.rows))
-		{
-			return false;
-		}
+	// final check on line_center_y and separator_tickness
 
-		// if line center is not in the middle of the image, it is probably not a separator line
-		if (line_center_y < (0.3 * binary_image.rows) || line_center_y >(0.7 * binary_image.rows))
-		{
-			return false;
-		}
+	// if ticknckness is greater than 20% of the image height, it is probably not a separator line
+	if (separator_tickness > (0.2 * binary_image.rows))
+	{
+		return false;
+	}
 
-		// separator line found
-		return true;
+	// if line center is not in the middle of the image, it is probably not a separator line
+	if (line_center_y < (0.3 * binary_image.rows) || line_center_y >(0.7 * binary_image.rows))
+	{
+		return false;
 	}
 
-	return false;
+	// separator line found
+	return true;
 }
 
 bool find_horizontal_separator_bounds(const cv::Mat& binary_image, int line_center_y, int& line_center_x_min, int& line_center_x_max)
 {
 	// --- Part 2: Find horizontal extremities (line_center_x_min, line_center_x_max) ---
-	line_center_x_min = -1;
-	line_center_x_max = -1;
-
-	// We'll examine the row at line_center_y in the binary image.
-	// For robustness, you could average over a few rows within the line_height.
-
-	const uchar* scan_row_ptr = binary_image.ptr<uchar>(line_center_y);
-
-	// Find the first white pixel (from left to right)
-	for (int x = 0; x < binary_image.cols; ++x) {
-		if (scan_row_ptr[x] == 255) {
-			line_center_x_min = x;
-			break; // Found the start, exit loop
-		}
-	}
-
-	// Find the last white pixel (from right to left)
-	for (int x = binary_image.cols - 1; x >= 0; --x) {
-		if (scan_row_ptr[x] == 255) {
-			line_center_x_max = x;
-			break; // Found the end, exit loop
-		}
-	}
-
+	// First and last white pixels of the row at line_center_y (-1 when the row has none)
+	find_value_bounds(binary_image.ptr<uchar>(line_center_y), binary_image.cols, 255, line_center_x_min, line_center_x_max);
 	return true;
 }
 
@@ -149,6 +221,30 @@ bool crop_borders(const cv::Mat& image, int line_center_y, int line_center_x_min
 	return true;
 }
 
+// Crop a binarized word image (white runes on black) to the left end of its separator line,
+// so the first rune starts at x = 0 (the layout expected by RuneClassifier)
+bool crop_word_image(const cv::Mat& binary_word_image, cv::Mat& cropped_image)
+{
+	int line_center_y = 0;
+	int tickness = 0;
+	if (!find_horizontal_separator(binary_word_image, line_center_y, tickness)) {
+		std::cerr << "No horizontal separator found in the rune image." << std::endl;
+		return false; // No separator line found
+	}
+
+	int line_center_x_min = 0;
+	int line_center_x_max = binary_word_image.cols;
+	if (!find_horizontal_separator_bounds(binary_word_image, line_center_y, line_center_x_min, line_center_x_max) || line_center_x_min < 0) {
+		std::cerr << "Error when trying to find word width" << std::endl;
+		return false;
+	}
+
+	// crop size - we only crop the left size of the word image
+	cv::Rect roi(line_center_x_min, 0, binary_word_image.cols - line_center_x_min, binary_word_image.rows);
+	cropped_image = binary_word_image(roi);
+	return true;
+}
+
 bool make_white_rune_black_background(cv::Mat& image) {
 	if (image.empty()) {
 		std::cerr << "Error: Input image is empty." << std::endl;
@@ -311,9 +407,15 @@ std::vector<std::string> loadLinesFromFile(const fs::path& filename) {
 	return lines;      // Return the vector of lines
 }
 
-bool partition_image(cv::Mat& image, std::vector<cv::Rect>& partition)
+// Blocks of a page: the outer bright components whose outline is a convex quadrilateral (rune word frames).
+// Connected components (labelled in parallel stripes by OpenCV) replace the contour search over the whole page:
+// the stats reject the small components, then only the remaining ones get the outline test, concurrently
+bool partition_image(cv::Mat& image, std::vector<cv::Rect>& partition, PartitionTiming* timing)
 {
 	partition.clear();
+	PartitionTiming local_timing;
+	PartitionTiming& partition_timing = timing != nullptr ? *timing : local_timing;
+	partition_timing = PartitionTiming();
 
 	if (image.empty()) {
 		std::cerr << "Error: Could not open or find the image." << std::endl;
@@ -321,6 +423,7 @@ bool partition_image(cv::Mat& image, std::vector<cv::Rect>& partition)
 	}
 
 	// 1. Convert to grayscale
+	auto start_threshold = std::chrono::high_resolution_clock::now();
 	cv::Mat gray_image;
 	if (image.channels() == 3) {
 		// If the image is in color (3 channels), convert it to grayscale
@@ -335,61 +438,108 @@ bool partition_image(cv::Mat& image, std::vector<cv::Rect>& partition)
 		gray_image = image;
 	}
 
-
-	//// 2. Invert the image (so black lines become white, and blocks become black)
-	//// This is useful for finding contours or connected components where objects are white on a black background
-	//cv::Mat inverted_image;
-	//cv::bitwise_not(gray_image, inverted_image);
-
-	// 3. Threshold the image to make the black lines very clear (white) and blocks black
+	// 2. Threshold the image to make the black lines very clear (white) and blocks black
 	// Adjust the threshold value (e.g., 50) based on how dark your "black" lines are.
-	// If the lines are perfectly black, a low threshold like 10-20 might work.
-	// If they are dark gray, you might need a higher value.
 	cv::Mat binary_lines;
 	cv::threshold(gray_image, binary_lines, 50, 255, cv::THRESH_BINARY);
+	auto end_threshold = std::chrono::high_resolution_clock::now();
+
+	// 3. Label the bright components (8-connectivity, like the contour search)
+	cv::Mat labels, stats, centroids;
+	int nb_labels = cv::connectedComponentsWithStats(binary_lines, labels, stats, centroids, 8, CV_32S);
+	auto end_labelling = std::chrono::high_resolution_clock::now();
+	partition_timing.nb_components = nb_labels - 1;
+
+	// 4. The outline of a component spans at most (width - 1) x (height - 1): smaller boxes cannot hold a block
+	const double min_area = RUNE_DEFAULT_SIZE.area() / 2.0;
+	auto component_rect = [&stats](int label) {
+		return cv::Rect(stats.at<int>(label, cv::CC_STAT_LEFT), stats.at<int>(label, cv::CC_STAT_TOP),
+			stats.at<int>(label, cv::CC_STAT_WIDTH), stats.at<int>(label, cv::CC_STAT_HEIGHT));
+	};
+	std::vector<int> candidates;
+	for (int label = 1; label < nb_labels; label++) {
+		cv::Rect rect = component_rect(label);
+		if ((double)(rect.width - 1) * (rect.height - 1) > min_area) {
+			candidates.push_back(label);
+		}
+	}
+	partition_timing.nb_candidates = (int)candidates.size();
+
+	// 5. Only the outer components are blocks: drop the candidates lying in a hole of a bigger candidate
+	// (a container is flood filled from its border once, its holes are what the fill does not reach)
+	std::vector<std::vector<int>> nested_candidates(candidates.size());
+	cv::parallel_for_(cv::Range(0, (int)candidates.size()), [&](const cv::Range& range) {
+		for (int c = range.start; c < range.end; c++) {
+			cv::Rect container = component_rect(candidates[c]);
+			std::vector<int> inner_candidates;
+			for (int inner : candidates) {
+				cv::Rect rect = component_rect(inner);
+				if (rect.x > container.x && rect.y > container.y && rect.br().x < container.br().x && rect.br().y < container.br().y) {
+					inner_candidates.push_back(inner);
+				}
+			}
+			if (inner_candidates.empty()) {
+				continue;
+			}
+			cv::Mat container_mask, outside;
+			cv::compare(labels(container), candidates[c], container_mask, cv::CMP_EQ);
+			cv::copyMakeBorder(container_mask, outside, 1, 1, 1, 1, cv::BORDER_CONSTANT, cv::Scalar(0));
+			cv::floodFill(outside, cv::Point(0, 0), cv::Scalar(128), nullptr, cv::Scalar(), cv::Scalar(), 4);
+			for (int inner : inner_candidates) {
+				// any pixel of the inner component tells which region of the container it lies in
+				cv::Rect rect = component_rect(inner);
+				const int* label_row = labels.ptr<int>(rect.y);
+				int x = rect.x;
+				while (label_row[x] != inner) {
+					x++;
+				}
+				if (outside.at<uchar>(rect.y - container.y + 1, x - container.x + 1) == 0) {
+					nested_candidates[c].push_back(inner);
+				}
+			}
+		}
+	});
+	std::vector<bool> is_nested(nb_labels, false);
+	for (const auto& nested : nested_candidates) {
+		for (int label : nested) {
+			is_nested[label] = true;
+		}
+	}
 
-	// Optional: Dilate the lines to ensure they are connected and form closed boundaries
-	// This helps in finding complete rectangular contours.
-	cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(3, 3));
-	const auto nb_filtering = 1;
-	//cv::dilate(binary_lines, binary_lines, kernel, cv::Point(-1, -1), nb_filtering); // Dilate a couple of times
-	//cv::erode(binary_lines, binary_lines, kernel, cv::Point(-1, -1), nb_filtering); // Erode a couple of times
-
-	//cv::imshow("gray_image", gray_image);
-	//cv::imshow("binary_lines", binary_lines);
-	//cv::waitKey(0); // Wait for a key press to close the window
-
-
-	// 4. Find contours in the binary image
-	std::vector<std::vector<cv::Point>> contours;
-	cv::findContours(binary_lines, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
-
-	// Create a copy of the original image to draw on
-	cv::Mat output_image = image.clone();
-
-	std::cout << "image before partition:" << std::endl;
-	int block_count = 0;
-
-	// 5. Iterate through the found contours
-	std::vector<cv::Point> approx_poly;
-	for (const auto& contour : contours) {
-		// Approximate the contour to a polygon
-		approx_poly.clear();
-		cv::approxPolyDP(contour, approx_poly, cv::arcLength(contour, true) * 0.02, true);
-
-		// Check if the approximated polygon has 4 vertices (a rectangle) and is sufficiently large
-		// You might need to adjust the contour area threshold based on your image and expected block sizes
-
-		if (approx_poly.size() == 4 && cv::isContourConvex(approx_poly)) {
-			auto area = cv::contourArea(contour);
-			if (area > (RUNE_DEFAULT_SIZE.area() / 2.0)) {
-				// Get the bounding rectangle for the current contour
-				cv::Rect bounding_rect = cv::boundingRect(contour);
-				partition.push_back(cv::Rect(bounding_rect));
+	// 6. The outline of each remaining candidate must approximate a convex quadrilateral (same test as the contour search)
+	std::vector<uchar> is_block(candidates.size(), 0);
+	cv::parallel_for_(cv::Range(0, (int)candidates.size()), [&](const cv::Range& range) {
+		std::vector<std::vector<cv::Point>> contours;
+		std::vector<cv::Point> approx_poly;
+		for (int c = range.start; c < range.end; c++) {
+			if (is_nested[candidates[c]]) {
+				continue;
+			}
+			cv::Mat component_mask;
+			cv::compare(labels(component_rect(candidates[c])), candidates[c], component_mask, cv::CMP_EQ);
+			contours.clear();
+			cv::findContours(component_mask, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+			if (contours.empty()) {
+				continue;
+			}
+			const auto& contour = contours[0];
+			approx_poly.clear();
+			cv::approxPolyDP(contour, approx_poly, cv::arcLength(contour, true) * 0.02, true);
+			if (approx_poly.size() == 4 && cv::isContourConvex(approx_poly) && cv::contourArea(contour) > min_area) {
+				is_block[c] = 1;
 			}
 		}
+	});
+	for (size_t c = 0; c < candidates.size(); c++) {
+		if (is_block[c]) {
+			partition.push_back(component_rect(candidates[c]));
+		}
 	}
+	auto end_filtering = std::chrono::high_resolution_clock::now();
 
+	partition_timing.threshold_ms = std::chrono::duration<double, std::milli>(end_threshold - start_threshold).count();
+	partition_timing.labelling_ms = std::chrono::duration<double, std::milli>(end_labelling - end_threshold).count();
+	partition_timing.filtering_ms = std::chrono::duration<double, std::milli>(end_filtering - end_labelling).count();
 	return true;
 }
 
@@ -576,10 +726,15 @@ void resize_to_fit_max_bounds(cv::Mat& image, const cv::Size& max_bounds) {
 
 // Function to detect straight lines, create a mask, and apply it to the image
 // Added minLineLength and maxLineGap parameters for more control over HoughLinesP
-cv::Mat detectAndMaskStraightLines(const cv::Mat& inputImage, double minLineLength, double maxLineGap, std::vector<cv::Vec4i>& detectedLines) {
-	// 1. Convert the input image to grayscale
+cv::Mat detectAndMaskStraightLines(const cv::Mat& inputImage, double minLineLength, double maxLineGap, std::vector<cv::Vec4i>& detectedLines, double theta) {
+	// 1. Convert the input image to grayscale (gray images are used as is)
 	cv::Mat grayImage;
-	cv::cvtColor(inputImage, grayImage, cv::COLOR_BGR2GRAY);
+	if (inputImage.channels() == 1) {
+		grayImage = inputImage;
+	}
+	else {
+		cv::cvtColor(inputImage, grayImage, cv::COLOR_BGR2GRAY);
+	}
 
 	// 2. Apply Gaussian blur to reduce noise and help with edge detection
 	cv::Mat blurredImage;
@@ -592,7 +747,7 @@ cv::Mat detectAndMaskStraightLines(const cv::Mat& inputImage, double minLineLeng
 
 	// 4. Detect lines using the Probabilistic Hough Transform (HoughLinesP)
 	// The detected lines are stored in the 'detectedLines' reference parameter.
-	cv::HoughLinesP(edges, detectedLines, 1, CV_PI / 180, 100, minLineLength, maxLineGap);
+	cv::HoughLinesP(edges, detectedLines, 1, theta, 100, minLineLength, maxLineGap);
 
 	// 5. Create a black mask image (same size and type as the input image)
 	// Initialize with zeros (black)
@@ -711,3 +866,496 @@ Brightness analyzeLineBrightness(const cv::Mat& originalImage, const std::vector
 }
 
 
+// Ink mask of a page: the minority class after Otsu, so dark and bright pages are handled the same way
+bool make_ink_mask(const cv::Mat& image, cv::Mat& ink)
+{
+	if (image.empty()) {
+		std::cerr << "Error: Cannot compute the ink mask of an empty image." << std::endl;
+		return false;
+	}
+
+	cv::Mat gray_image;
+	if (image.channels() == 3) {
+		cv::cvtColor(image, gray_image, cv::COLOR_BGR2GRAY);
+	}
+	else if (image.channels() == 4) {
+		cv::cvtColor(image, gray_image, cv::COLOR_BGRA2GRAY);
+	}
+	else {
+		gray_image = image;
+	}
+
+	cv::threshold(gray_image, ink, 0, 255, cv::THRESH_BINARY | cv::THRESH_OTSU);
+	if (cv::countNonZero(ink) > (int)(ink.total() / 2)) {
+		cv::bitwise_not(ink, ink);
+	}
+	return true;
+}
+
+// Union of overlapping rectangles as disjoint ones: the rect edges split the plane in a grid of cells, the covered
+// cells of a row band are joined in runs, and a run continues the rectangle of the band above when it has the same span
+bool merge_rects(const std::vector<cv::Rect>& rects, std::vector<cv::Rect>& disjoint_rects)
+{
+	disjoint_rects.clear();
+	std::vector<int> xs, ys;
+	for (const auto& rect : rects) {
+		if (rect.width <= 0 || rect.height <= 0) {
+			continue;
+		}
+		xs.push_back(rect.x);
+		xs.push_back(rect.x + rect.width);
+		ys.push_back(rect.y);
+		ys.push_back(rect.y + rect.height);
+	}
+	if (xs.empty()) {
+		return true;
+	}
+	std::sort(xs.begin(), xs.end());
+	xs.erase(std::unique(xs.begin(), xs.end()), xs.end());
+	std::sort(ys.begin(), ys.end());
+	ys.erase(std::unique(ys.begin(), ys.end()), ys.end());
+
+	int cells_x = (int)xs.size() - 1;
+	int cells_y = (int)ys.size() - 1;
+	cv::Mat covered = cv::Mat::zeros(cells_y, cells_x, CV_8U);
+	for (const auto& rect : rects) {
+		if (rect.width <= 0 || rect.height <= 0) {
+			continue;
+		}
+		int cx0 = (int)(std::lower_bound(xs.begin(), xs.end(), rect.x) - xs.begin());
+		int cx1 = (int)(std::lower_bound(xs.begin(), xs.end(), rect.x + rect.width) - xs.begin());
+		int cy0 = (int)(std::lower_bound(ys.begin(), ys.end(), rect.y) - ys.begin());
+		int cy1 = (int)(std::lower_bound(ys.begin(), ys.end(), rect.y + rect.height) - ys.begin());
+		covered(cv::Rect(cx0, cy0, cx1 - cx0, cy1 - cy0)).setTo(255);
+	}
+
+	std::vector<cv::Rect> open_rects;
+	for (int cy = 0; cy < cells_y; cy++) {
+		std::vector<cv::Rect> next_open_rects;
+		const uchar* row = covered.ptr<uchar>(cy);
+		for (int cx = 0; cx < cells_x; cx++) {
+			if (row[cx] == 0) {
+				continue;
+			}
+			int run_start = cx;
+			while (cx < cells_x && row[cx] != 0) {
+				cx++;
+			}
+			cv::Rect run(xs[run_start], ys[cy], xs[cx] - xs[run_start], ys[cy + 1] - ys[cy]);
+			auto it = std::find_if(open_rects.begin(), open_rects.end(), [&run](const cv::Rect& open_rect) {
+				return open_rect.x == run.x && open_rect.width == run.width;
+			});
+			if (it != open_rects.end()) {
+				run = *it | run;
+				open_rects.erase(it);
+			}
+			next_open_rects.push_back(run);
+		}
+		// rects not continued on this band are done
+		disjoint_rects.insert(disjoint_rects.end(), open_rects.begin(), open_rects.end());
+		open_rects = next_open_rects;
+	}
+	disjoint_rects.insert(disjoint_rects.end(), open_rects.begin(), open_rects.end());
+	return true;
+}
+
+// Cheap text / illustration classifier: mark the tiles of a page that may contain rune words.
+// Every rune word is crossed by a long, thin horizontal separator stroke while illustrations are made of
+// filled areas and strokes in every direction. A tile is kept when its ink density looks like text and
+// a large enough part of its ink is thin horizontal strokes. Kept tiles are grown by one tile (runes extend
+// above and below their separator) and grouped in rectangles, row by row.
+bool find_text_regions(const cv::Mat& image, std::vector<cv::Rect>& text_regions, double& skipped_ratio, int tile_size, bool debug_mode)
+{
+	text_regions.clear();
+	skipped_ratio = 0.0;
+
+	if (image.empty() || tile_size <= 0) {
+		std::cerr << "Error: Cannot classify text regions of an empty image." << std::endl;
+		return false;
+	}
+
+	cv::Mat ink;
+	if (!make_ink_mask(image, ink)) {
+		return false;
+	}
+
+	// horizontal strokes long enough to be a separator
+	cv::Mat horizontal_strokes;
+	cv::Mat horizontal_kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(TEXT_TILE_MIN_STROKE_LENGTH, 1));
+	cv::morphologyEx(ink, horizontal_strokes, cv::MORPH_OPEN, horizontal_kernel);
+
+	// remove the thick parts (filled areas survive the horizontal opening)
+	cv::Mat thick_parts;
+	cv::Mat vertical_kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(1, TEXT_TILE_MAX_STROKE_TICKNESS + 1));
+	cv::morphologyEx(horizontal_strokes, thick_parts, cv::MORPH_OPEN, vertical_kernel);
+	cv::Mat thin_strokes = horizontal_strokes & ~thick_parts;
+
+	int tiles_x = (image.cols + tile_size - 1) / tile_size;
+	int tiles_y = (image.rows + tile_size - 1) / tile_size;
+	cv::Rect image_rect(0, 0, image.cols, image.rows);
+	cv::Mat tile_mask = cv::Mat::zeros(tiles_y, tiles_x, CV_8U);
+	for (int ty = 0; ty < tiles_y; ty++) {
+		for (int tx = 0; tx < tiles_x; tx++) {
+			cv::Rect tile = cv::Rect(tx * tile_size, ty * tile_size, tile_size, tile_size) & image_rect;
+			int ink_pixels = cv::countNonZero(ink(tile));
+			double ink_density = (double)ink_pixels / tile.area();
+			if (ink_density < TEXT_TILE_MIN_INK_DENSITY || ink_density > TEXT_TILE_MAX_INK_DENSITY) {
+				continue;
+			}
+			if (cv::countNonZero(thin_strokes(tile)) >= TEXT_TILE_MIN_STROKE_RATIO * ink_pixels) {
+				tile_mask.at<uchar>(ty, tx) = 255;
+			}
+		}
+	}
+
+	cv::dilate(tile_mask, tile_mask, cv::getStructuringElement(cv::MORPH_RECT, cv::Size(3, 3)));
+
+	int text_tiles = cv::countNonZero(tile_mask);
+	skipped_ratio = 1.0 - (double)text_tiles / tile_mask.total();
+
+	// group the horizontal runs of text tiles: a run extends the region above it
+	// as long as the grown rectangle does not waste more than TEXT_REGION_MAX_WASTE of its area
+	std::vector<cv::Rect> tile_regions, open_regions;
+	for (int ty = 0; ty < tiles_y; ty++) {
+		std::vector<cv::Rect> next_open_regions;
+		const uchar* row = tile_mask.ptr<uchar>(ty);
+		for (int tx = 0; tx < tiles_x; tx++) {
+			if (row[tx] == 0) {
+				continue;
+			}
+			int run_start = tx;
+			while (tx < tiles_x && row[tx] != 0) {
+				tx++;
+			}
+			cv::Rect run(run_start, ty, tx - run_start, 1);
+
+			bool merged = false;
+			for (auto it = open_regions.begin(); it != open_regions.end(); it++) {
+				if (it->x >= run.x + run.width || run.x >= it->x + it->width) {
+					continue;
+				}
+				cv::Rect grown = *it | run;
+				if (grown.area() <= TEXT_REGION_MAX_WASTE * (it->area() + run.area())) {
+					next_open_regions.push_back(grown);
+					open_regions.erase(it);
+					merged = true;
+				}
+				break;
+			}
+			if (!merged) {
+				next_open_regions.push_back(run);
+			}
+		}
+		// regions not continued on this row are done
+		tile_regions.insert(tile_regions.end(), open_regions.begin(), open_regions.end());
+		open_regions = next_open_regions;
+	}
+	tile_regions.insert(tile_regions.end(), open_regions.begin(), open_regions.end());
+
+	for (const auto& tile_region : tile_regions) {
+		cv::Rect region(tile_region.x * tile_size, tile_region.y * tile_size, tile_region.width * tile_size, tile_region.height * tile_size);
+		text_regions.push_back(region & image_rect);
+	}
+
+	if (debug_mode) {
+		std::cout << "Text regions: " << text_regions.size() << " (" << text_tiles << "/" << tile_mask.total() << " tiles), skipped "
+			<< skipped_ratio * 100.0 << "% of the image" << std::endl;
+		cv::Mat debug_image;
+		cv::cvtColor(ink, debug_image, cv::COLOR_GRAY2BGR);
+		for (const auto& region : text_regions) {
+			cv::rectangle(debug_image, region, cv::Scalar(0, 255, 0), 2);
+		}
+		cv::imshow("Text regions", debug_image);
+		cv::waitKey(500);
+		cv::destroyWindow("Text regions");
+	}
+
+	return true;
+}
+
+// Read the pixel size of a JPEG or PNG file from its header, without decoding the image
+bool read_image_size(const fs::path& image_file, cv::Size& size)
+{
+	std::ifstream file(image_file, std::ios::binary);
+	if (!file.is_open()) {
+		std::cerr << "Error: Could not open image file " << image_file << std::endl;
+		return false;
+	}
+
+	unsigned char header[24] = { 0 };
+	if (!file.read(reinterpret_cast<char*>(header), 2)) {
+		return false;
+	}
+
+	// PNG: 8 bytes signature then the IHDR chunk (length, type, width, height in big endian)
+	if (header[0] == 0x89 && header[1] == 'P') {
+		if (!file.read(reinterpret_cast<char*>(header + 2), 22) || std::memcmp(header + 12, "IHDR", 4) != 0) {
+			return false;
+		}
+		size.width = (header[16] << 24) | (header[17] << 16) | (header[18] << 8) | header[19];
+		size.height = (header[20] << 24) | (header[21] << 16) | (header[22] << 8) | header[23];
+		return size.width > 0 && size.height > 0;
+	}
+
+	// JPEG: walk the markers until a start of frame (SOF0..SOF15 except DHT, JPG and DAC)
+	if (header[0] == 0xFF && header[1] == 0xD8) {
+		while (file) {
+			int byte = file.get();
+			if (byte != 0xFF) {
+				return false;
+			}
+			int marker = file.get();
+			while (marker == 0xFF) { // fill bytes
+				marker = file.get();
+			}
+			if (marker == EOF || marker == 0xD9 || marker == 0xDA) { // end of image or start of scan: no frame header found
+				return false;
+			}
+			if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) { // markers without payload
+				continue;
+			}
+			unsigned char segment[7];
+			if (!file.read(reinterpret_cast<char*>(segment), 2)) {
+				return false;
+			}
+			int length = (segment[0] << 8) | segment[1];
+			if (length < 2) {
+				return false;
+			}
+			if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+				// precision (1 byte), height (2 bytes), width (2 bytes)
+				if (!file.read(reinterpret_cast<char*>(segment + 2), 5)) {
+					return false;
+				}
+				size.height = (segment[3] << 8) | segment[4];
+				size.width = (segment[5] << 8) | segment[6];
+				return size.width > 0 && size.height > 0;
+			}
+			file.seekg(length - 2, std::ios::cur);
+		}
+	}
+
+	return false;
+}
+
+// Largest decoder reduction (1, 2, 4 or 8) that still gives an image about as big as the size fitted in max_bounds.
+// The bound is not exact: the reduced image may be up to REDUCED_DECODE_MAX_UNDERSHOOT smaller than the fitted size
+// (a 2301x1753 scan is decoded at 1/2 for a 1280x900 target, 1151x877 instead of 1181x900), a cheaper decode is worth it
+int get_reduced_decode_factor(const cv::Size& image_size, const cv::Size& max_bounds)
+{
+	if (image_size.width <= 0 || image_size.height <= 0 || max_bounds.width <= 0 || max_bounds.height <= 0) {
+		return 1;
+	}
+	double scale_factor = (std::min)((double)max_bounds.width / image_size.width, (double)max_bounds.height / image_size.height);
+	int factor = 1;
+	while (factor < 8 && scale_factor * factor * 2 <= 1.0 + REDUCED_DECODE_MAX_UNDERSHOOT) {
+		factor *= 2;
+	}
+	return factor;
+}
+
+// Decode an image at about the size fitted in max_bounds. When max_bounds is set, the decoder reduction is chosen from
+// the file header (for JPEG the downscale happens in the DCT domain, so the full resolution image is never built),
+// then the remaining resize to fit max_bounds is done as usual.
+static bool load_reduced_image(const fs::path& image_file, cv::Mat& image, const cv::Size& max_bounds, bool gray)
+{
+	int factor = 1;
+	cv::Size file_size;
+	if (max_bounds.area() > 0 && read_image_size(image_file, file_size)) {
+		factor = get_reduced_decode_factor(file_size, max_bounds);
+	}
+
+	int flags = gray ? cv::IMREAD_GRAYSCALE : cv::IMREAD_COLOR_BGR;
+	switch (factor) {
+	case 2: flags = gray ? cv::IMREAD_REDUCED_GRAYSCALE_2 : cv::IMREAD_REDUCED_COLOR_2; break;
+	case 4: flags = gray ? cv::IMREAD_REDUCED_GRAYSCALE_4 : cv::IMREAD_REDUCED_COLOR_4; break;
+	case 8: flags = gray ? cv::IMREAD_REDUCED_GRAYSCALE_8 : cv::IMREAD_REDUCED_COLOR_8; break;
+	default: break;
+	}
+
+	image = cv::imread(image_file.string(), flags);
+	if (image.empty()) {
+		std::cerr << "Error: Could not load image from " << image_file << std::endl;
+		return false;
+	}
+	if (factor > 1) {
+		std::cout << "Decoded " << image_file.filename() << " at 1/" << factor << " (" << file_size.width << "x" << file_size.height
+			<< " -> " << image.cols << "x" << image.rows << ")" << std::endl;
+	}
+
+	if (max_bounds.area() > 0) {
+		resize_to_fit_max_bounds(image, max_bounds);
+	}
+
+	return true;
+}
+
+// Ingest an image straight to 8 bits gray (matching, decoding)
+bool load_gray_image(const fs::path& image_file, cv::Mat& image, const cv::Size& max_bounds)
+{
+	return load_reduced_image(image_file, image, max_bounds, true);
+}
+
+// Ingest an image in BGR (annotated outputs), matching converts it to gray
+bool load_color_image(const fs::path& image_file, cv::Mat& image, const cv::Size& max_bounds)
+{
+	return load_reduced_image(image_file, image, max_bounds, false);
+}
+
+// Page angle from its long straight lines: every rune word has a horizontal separator, so the near horizontal
+// lines found by detectAndMaskStraightLines vote with their length and the weighted median angle is kept
+// (illustration lines at random angles do not move the median)
+bool estimate_skew_angle(const cv::Mat& image, double& angle)
+{
+	angle = 0.0;
+	if (image.empty()) {
+		std::cerr << "Error: Cannot estimate the angle of an empty image." << std::endl;
+		return false;
+	}
+
+	std::vector<cv::Vec4i> lines;
+	double min_line_length = DESKEW_MIN_LINE_LENGTH * image.cols;
+	detectAndMaskStraightLines(image, min_line_length, 0.1 * min_line_length, lines, DESKEW_ANGLE_RESOLUTION * CV_PI / 180.0);
+
+	std::vector<std::pair<double, double>> votes; // angle, length
+	double total_length = 0.0;
+	for (const auto& line : lines) {
+		double dx = line[2] - line[0];
+		double dy = line[3] - line[1];
+		double line_angle = std::atan2(dy, dx) * 180.0 / CV_PI;
+		if (line_angle > 90.0) {
+			line_angle -= 180.0;
+		}
+		else if (line_angle < -90.0) {
+			line_angle += 180.0;
+		}
+		if (std::abs(line_angle) <= DESKEW_MAX_ANGLE) {
+			double length = std::sqrt(dx * dx + dy * dy);
+			votes.push_back({ line_angle, length });
+			total_length += length;
+		}
+	}
+	if (votes.empty()) {
+		return false;
+	}
+
+	std::sort(votes.begin(), votes.end());
+	double cumulated_length = 0.0;
+	for (const auto& [line_angle, length] : votes) {
+		cumulated_length += length;
+		if (cumulated_length >= 0.5 * total_length) {
+			angle = line_angle;
+			break;
+		}
+	}
+	return true;
+}
+
+// Rotate the page so its text lines are horizontal (single warp, same size, borders replicated so no
+// new straight edges appear). angle is the applied rotation in degrees, 0 when the page was left as is
+bool deskew_image(cv::Mat& image, double& angle)
+{
+	double skew_angle = 0.0;
+	angle = 0.0;
+	if (!estimate_skew_angle(image, skew_angle)) {
+		return false;
+	}
+	if (std::abs(skew_angle) < DESKEW_MIN_ANGLE) {
+		return true;
+	}
+
+	if (!rotate_image(image, skew_angle)) {
+		return false;
+	}
+	angle = skew_angle;
+	return true;
+}
+
+// Rotation around the image center, same size (the corners are filled with the border pixels)
+bool rotate_image(cv::Mat& image, double angle)
+{
+	if (image.empty()) {
+		std::cerr << "Error: Cannot rotate an empty image." << std::endl;
+		return false;
+	}
+	cv::Point2f center(0.5f * image.cols, 0.5f * image.rows);
+	cv::Mat rotation = cv::getRotationMatrix2D(center, angle, 1.0);
+	cv::Mat rotated_image;
+	cv::warpAffine(image, rotated_image, rotation, image.size(), cv::INTER_LINEAR, cv::BORDER_REPLICATE);
+	image = rotated_image;
+	return true;
+}
+
+// One 64 bit hash per tile (row major, the last row / column of tiles may be smaller): 8 bytes are mixed at a time
+bool compute_tile_hashes(const cv::Mat& image, int tile_size, std::vector<uint64_t>& tile_hashes)
+{
+	if (image.empty() || image.depth() != CV_8U || tile_size <= 0) {
+		std::cerr << "Error: Tile hashes expect a non empty 8 bit image." << std::endl;
+		return false;
+	}
+	const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+	const uint64_t FNV_PRIME = 1099511628211ULL;
+	int tiles_x = (image.cols + tile_size - 1) / tile_size;
+	int tiles_y = (image.rows + tile_size - 1) / tile_size;
+	size_t row_bytes = image.cols * image.elemSize();
+	size_t tile_bytes = tile_size * image.elemSize();
+	tile_hashes.assign((size_t)tiles_x * tiles_y, FNV_OFFSET);
+	for (int y = 0; y < image.rows; ++y) {
+		const uchar* row_ptr = image.ptr<uchar>(y);
+		uint64_t* row_hashes = &tile_hashes[(size_t)(y / tile_size) * tiles_x];
+		for (int tx = 0; tx < tiles_x; ++tx) {
+			size_t begin = tx * tile_bytes;
+			size_t end = (std::min)(begin + tile_bytes, row_bytes);
+			uint64_t hash = row_hashes[tx];
+			size_t i = begin;
+			for (; i + sizeof(uint64_t) <= end; i += sizeof(uint64_t)) {
+				uint64_t word;
+				std::memcpy(&word, row_ptr + i, sizeof(uint64_t));
+				hash = (hash ^ word) * FNV_PRIME;
+			}
+			for (; i < end; ++i) {
+				hash = (hash ^ row_ptr[i]) * FNV_PRIME;
+			}
+			row_hashes[tx] = hash;
+		}
+	}
+	return true;
+}
+
+// Rectangles (pixels) covering the tiles whose hash changed, one per group of connected changed tiles
+bool find_dirty_regions(const std::vector<uint64_t>& previous_hashes, const std::vector<uint64_t>& tile_hashes, const cv::Size& image_size, int tile_size, std::vector<cv::Rect>& dirty_regions, double& dirty_ratio)
+{
+	dirty_regions.clear();
+	dirty_ratio = 0.0;
+	int tiles_x = (image_size.width + tile_size - 1) / tile_size;
+	int tiles_y = (image_size.height + tile_size - 1) / tile_size;
+	if (tile_size <= 0 || previous_hashes.size() != tile_hashes.size() || tile_hashes.size() != (size_t)tiles_x * tiles_y) {
+		std::cerr << "Error: Tile hashes of different pages cannot be compared." << std::endl;
+		return false;
+	}
+
+	cv::Mat dirty_tiles = cv::Mat::zeros(tiles_y, tiles_x, CV_8U);
+	for (int ty = 0; ty < tiles_y; ++ty) {
+		for (int tx = 0; tx < tiles_x; ++tx) {
+			size_t index = (size_t)ty * tiles_x + tx;
+			if (previous_hashes[index] != tile_hashes[index]) {
+				dirty_tiles.at<uchar>(ty, tx) = 255;
+			}
+		}
+	}
+	int nb_dirty_tiles = cv::countNonZero(dirty_tiles);
+	if (nb_dirty_tiles == 0) {
+		return true;
+	}
+	dirty_ratio = (double)nb_dirty_tiles / dirty_tiles.total();
+
+	cv::Mat labels, stats, centroids;
+	int nb_labels = cv::connectedComponentsWithStats(dirty_tiles, labels, stats, centroids, 8);
+	cv::Rect image_rect(cv::Point(0, 0), image_size);
+	for (int label = 1; label < nb_labels; ++label) {
+		cv::Rect tiles(stats.at<int>(label, cv::CC_STAT_LEFT), stats.at<int>(label, cv::CC_STAT_TOP),
+			stats.at<int>(label, cv::CC_STAT_WIDTH), stats.at<int>(label, cv::CC_STAT_HEIGHT));
+		dirty_regions.push_back(cv::Rect(tiles.x * tile_size, tiles.y * tile_size, tiles.width * tile_size, tiles.height * tile_size) & image_rect);
+	}
+	return true;
+}
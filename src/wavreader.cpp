@@ -0,0 +1,286 @@
+#include "wavreader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <opencv2/core.hpp>
+
+// Platform-specific headers
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h> // For CreateFileMappingW, MapViewOfFile
+#else
+#include <fcntl.h> // For open
+#include <sys/mman.h> // For mmap
+#include <sys/stat.h> // For fstat
+#include <unistd.h> // For close
+#endif
+
+// RIFF fields are little endian, like the supported hosts
+static uint16_t read_uint16(const uint8_t* data)
+{
+    uint16_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static uint32_t read_uint32(const uint8_t* data)
+{
+    uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+bool WavReader::open(const std::filesystem::path& file)
+{
+    close();
+    if (!map_file(file)) {
+        return false;
+    }
+    if (!parse_chunks()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void WavReader::close()
+{
+#ifdef _WIN32
+    if (m_file_data != nullptr) {
+        UnmapViewOfFile(m_file_data);
+    }
+    if (m_mapping_handle != nullptr) {
+        CloseHandle(m_mapping_handle);
+    }
+    if (m_file_handle != nullptr) {
+        CloseHandle(m_file_handle);
+    }
+    m_mapping_handle = nullptr;
+    m_file_handle = nullptr;
+#else
+    if (m_file_data != nullptr) {
+        munmap(const_cast<uint8_t*>(m_file_data), m_file_size);
+    }
+    if (m_file_descriptor >= 0) {
+        ::close(m_file_descriptor);
+    }
+    m_file_descriptor = -1;
+#endif
+    m_file_data = nullptr;
+    m_file_size = 0;
+    m_data = nullptr;
+    m_info = WavInfo();
+}
+
+bool WavReader::map_file(const std::filesystem::path& file)
+{
+#ifdef _WIN32
+    HANDLE file_handle = CreateFileW(file.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file_handle == INVALID_HANDLE_VALUE) {
+        std::cerr << "Error: Could not open WAV file " << file << std::endl;
+        return false;
+    }
+    m_file_handle = file_handle;
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file_handle, &file_size) || file_size.QuadPart == 0) {
+        std::cerr << "Error: Empty or unreadable WAV file " << file << std::endl;
+        return false;
+    }
+    m_mapping_handle = CreateFileMappingW(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* view = m_mapping_handle != nullptr ? MapViewOfFile(m_mapping_handle, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (view == nullptr) {
+        std::cerr << "Error: Could not map WAV file " << file << std::endl;
+        return false;
+    }
+    m_file_size = static_cast<size_t>(file_size.QuadPart);
+#else
+    m_file_descriptor = ::open(file.c_str(), O_RDONLY);
+    if (m_file_descriptor < 0) {
+        std::cerr << "Error: Could not open WAV file " << file << std::endl;
+        return false;
+    }
+    struct stat file_stat;
+    if (fstat(m_file_descriptor, &file_stat) != 0 || file_stat.st_size == 0) {
+        std::cerr << "Error: Empty or unreadable WAV file " << file << std::endl;
+        return false;
+    }
+    void* view = mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_PRIVATE, m_file_descriptor, 0);
+    if (view == MAP_FAILED) {
+        std::cerr << "Error: Could not map WAV file " << file << std::endl;
+        return false;
+    }
+    m_file_size = static_cast<size_t>(file_stat.st_size);
+    madvise(view, m_file_size, MADV_SEQUENTIAL);
+#endif
+    m_file_data = static_cast<const uint8_t*>(view);
+    return true;
+}
+
+bool WavReader::parse_chunks()
+{
+    if (m_file_size < 12 || std::memcmp(m_file_data, "RIFF", 4) != 0 || std::memcmp(m_file_data + 8, "WAVE", 4) != 0) {
+        std::cerr << "Error: Invalid or unsupported file (RIFF/WAVE header is missing)." << std::endl;
+        return false;
+    }
+
+    bool has_format = false;
+    size_t position = 12;
+    while (position + 8 <= m_file_size) {
+        const uint8_t* chunk = m_file_data + position;
+        uint32_t chunk_size = read_uint32(chunk + 4);
+        size_t payload = position + 8;
+
+        if (std::memcmp(chunk, "fmt ", 4) == 0) {
+            if (chunk_size < 16 || payload + 16 > m_file_size) {
+                std::cerr << "Error: Truncated WAV fmt chunk." << std::endl;
+                return false;
+            }
+            const uint8_t* format = m_file_data + payload;
+            m_info.format_tag = read_uint16(format);
+            m_info.channels = read_uint16(format + 2);
+            m_info.sample_rate = read_uint32(format + 4);
+            m_info.block_align = read_uint16(format + 12);
+            m_info.bits_per_sample = read_uint16(format + 14);
+            // WAVE_FORMAT_EXTENSIBLE: the sub format GUID starts with the actual format tag
+            if (m_info.format_tag == 0xFFFE && chunk_size >= 40 && payload + 40 <= m_file_size) {
+                m_info.format_tag = read_uint16(format + 24);
+            }
+            has_format = true;
+        }
+        else if (std::memcmp(chunk, "data", 4) == 0) {
+            if (!has_format) {
+                std::cerr << "Error: WAV data chunk found before the fmt chunk." << std::endl;
+                return false;
+            }
+            if (m_info.format_tag == 1) {
+                m_info.sample_format = m_info.bits_per_sample == 8 ? WavSampleFormat::UInt8 : m_info.bits_per_sample == 16 ? WavSampleFormat::Int16 :
+                    m_info.bits_per_sample == 24 ? WavSampleFormat::Int24 : m_info.bits_per_sample == 32 ? WavSampleFormat::Int32 : WavSampleFormat::Unknown;
+            }
+            else if (m_info.format_tag == 3) {
+                m_info.sample_format = m_info.bits_per_sample == 32 ? WavSampleFormat::Float32 : m_info.bits_per_sample == 64 ? WavSampleFormat::Float64 : WavSampleFormat::Unknown;
+            }
+            if (m_info.sample_format == WavSampleFormat::Unknown || m_info.channels == 0 || m_info.sample_rate == 0
+                || m_info.block_align != m_info.channels * (m_info.bits_per_sample / 8)) {
+                std::cerr << "Error: Unsupported WAV format (tag " << m_info.format_tag << ", " << m_info.channels << " channels, "
+                    << m_info.bits_per_sample << " bits per sample)." << std::endl;
+                return false;
+            }
+            // streamed (size 0 or 0xFFFFFFFF) and truncated captures: up to the end of the file
+            size_t data_size = m_file_size - payload;
+            if (chunk_size != 0 && chunk_size != 0xFFFFFFFF) {
+                data_size = (std::min)(data_size, static_cast<size_t>(chunk_size));
+            }
+            m_info.data_offset = payload;
+            m_info.nb_frames = data_size / m_info.block_align;
+            m_data = m_file_data + payload;
+            return true;
+        }
+        // chunks are word aligned
+        position = payload + chunk_size + (chunk_size & 1);
+    }
+
+    std::cerr << "Error: No data chunk in WAV file." << std::endl;
+    return false;
+}
+
+// OpenCV conversions (vectorised) for the formats it has a depth for, then downmix (row mean) or channel column
+void WavReader::convert_block(const uint8_t* data, size_t nb_frames, int channel, float* output)
+{
+    const int rows = static_cast<int>(nb_frames);
+    const int channels = m_info.channels;
+    int depth = -1;
+    double scale = 1.0, shift = 0.0;
+    switch (m_info.sample_format) {
+    case WavSampleFormat::UInt8:
+        depth = CV_8U;
+        scale = 1.0 / 128.0;
+        shift = -1.0;
+        break;
+    case WavSampleFormat::Int16:
+        depth = CV_16S;
+        scale = 1.0 / 32768.0;
+        break;
+    case WavSampleFormat::Int32:
+        depth = CV_32S;
+        scale = 1.0 / 2147483648.0;
+        break;
+    case WavSampleFormat::Float32:
+        depth = CV_32F;
+        break;
+    case WavSampleFormat::Float64:
+        depth = CV_64F;
+        break;
+    default:
+        break;
+    }
+
+    // the data chunk is only word aligned in the file: 32 and 64 bit samples are copied before OpenCV reads them
+    const size_t sample_bytes = m_info.bits_per_sample / 8;
+    if (depth >= 0 && reinterpret_cast<uintptr_t>(data) % sample_bytes != 0) {
+        size_t block_bytes = nb_frames * m_info.block_align;
+        m_aligned.resize((block_bytes + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+        std::memcpy(m_aligned.data(), data, block_bytes);
+        data = reinterpret_cast<const uint8_t*>(m_aligned.data());
+    }
+
+    cv::Mat mono(rows, 1, CV_32F, output);
+    if (channels == 1 && depth >= 0) {
+        cv::Mat(rows, 1, depth, const_cast<uint8_t*>(data)).convertTo(mono, CV_32F, scale, shift);
+        return;
+    }
+
+    m_block.resize(nb_frames * channels);
+    cv::Mat interleaved(rows, channels, CV_32F, m_block.data());
+    if (depth >= 0) {
+        cv::Mat(rows, channels, depth, const_cast<uint8_t*>(data)).convertTo(interleaved, CV_32F, scale, shift);
+    }
+    else {
+        // 24 bit: the three bytes at the top of an int32, sign extended by the shift
+        const float scale_24 = 1.0f / 8388608.0f;
+        for (size_t i = 0; i < m_block.size(); i++) {
+            const uint8_t* sample = data + 3 * i;
+            int32_t value = static_cast<int32_t>((uint32_t)sample[0] << 8 | (uint32_t)sample[1] << 16 | (uint32_t)sample[2] << 24) >> 8;
+            m_block[i] = value * scale_24;
+        }
+    }
+
+    if (channels == 1) {
+        interleaved.copyTo(mono);
+    }
+    else if (channel == WAV_DOWNMIX) {
+        cv::reduce(interleaved, mono, 1, cv::REDUCE_AVG);
+    }
+    else {
+        interleaved.col(channel).copyTo(mono);
+    }
+}
+
+size_t WavReader::read(float* output, size_t first_frame, size_t nb_frames, int channel)
+{
+    if (!is_open() || first_frame >= m_info.nb_frames) {
+        return 0;
+    }
+    if (channel != WAV_DOWNMIX && (channel < 0 || channel >= m_info.channels)) {
+        std::cerr << "Error: WAV channel " << channel << " out of range (" << m_info.channels << " channels)." << std::endl;
+        return 0;
+    }
+    nb_frames = (std::min)(nb_frames, m_info.nb_frames - first_frame);
+    for (size_t done = 0; done < nb_frames; ) {
+        size_t block_frames = (std::min)(WAV_READ_BLOCK_FRAMES, nb_frames - done);
+        convert_block(m_data + (first_frame + done) * m_info.block_align, block_frames, channel, output + done);
+        done += block_frames;
+    }
+    return nb_frames;
+}
+
+bool WavReader::read_all(std::vector<float>& output, int channel)
+{
+    if (!is_open()) {
+        return false;
+    }
+    output.resize(m_info.nb_frames);
+    return read(output.data(), 0, m_info.nb_frames, channel) == m_info.nb_frames;
+}
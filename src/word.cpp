@@ -91,69 +91,76 @@ bool Word::generate_image(cv::Size2i rune_size, double tickness, cv::Mat& output
 	return true;
 }
 
-bool Word::decode_image(const cv::Mat& word_image)
+cv::Point2d RuneGrid::get_rune_origin(int index) const
 {
-	bool result = true;
-	auto height = word_image.rows;
-	auto width = word_image.cols;
-	int rune_width = std::round(height * RUNE_DEFAULT_SIZE.aspectRatio());
-
-	// resize image so the width is a perfect multiple of rune_width
-	int nb_runes = std::round(double(width) / double(rune_width));
-
-
-	cv::Rect roi_word(0, 0, std::min(nb_runes*rune_width, width), height);
-	//cv::Mat resized_image(height, nb_runes*rune_width, CV_8UC1, cv::Scalar(0));
-	cv::Mat region_to_copy = word_image(roi_word);
-	region_to_copy = word_image(roi_word);
-
-	cv::Mat resized_image;
-	if(width < nb_runes * rune_width) {
-		int dx = nb_runes * rune_width - width; // Calculate the right border width
-		// If the image is smaller than the expected width, resize it
-		cv::copyMakeBorder(word_image,
-			resized_image,      // Output image
-			0,                   // top border
-			0,                   // bottom border
-			0,                   // left border
-			dx,  // right border
-			cv::BORDER_CONSTANT, // Border type
-			cv::Scalar(0));       // Border value
-	} else {
-		// If the image is larger or equal, just copy the region
-		resized_image = word_image(roi_word).clone();
-	}
-
-	// Dilation
-	int current_kernel_size = 5;
-	int current_iterations = 1;
-	cv::Mat processed_result = applyClosing(resized_image, current_kernel_size, current_iterations);
-	cv::imshow("Cloased Image (dil the erosion) (Kernel: " + std::to_string(current_kernel_size) + ", Iterations: " + std::to_string(current_iterations) + ")", processed_result);
-
+	return cv::Point2d(x_min + 0.5 * tickness + index * rune_width, separator_y - 0.01 * RUNE_POINT_E.y * rune_height);
+}
 
+// The height only gives a first guess of the rune width, used to count the runes: the separator span then gives
+// their exact width (no padding or cropping of the word to a multiple of a guessed width)
+bool Word::find_rune_grid(const cv::Mat& binary_word_image, RuneGrid& grid)
+{
+	grid = RuneGrid();
+	if (!find_horizontal_separator(binary_word_image, grid.separator_y, grid.tickness)) {
+		std::cerr << "No horizontal separator found in the rune image." << std::endl;
+		return false; // No separator line found
+	}
+	if (!find_horizontal_separator_bounds(binary_word_image, grid.separator_y, grid.x_min, grid.x_max) || grid.x_min < 0) {
+		std::cerr << "Error when trying to find word width" << std::endl;
+		return false;
+	}
 
-	m_runes.clear(); // Clear previous runes
+	// the word holds a stroke tickness above and below the runes (see generate_image)
+	double span = grid.x_max - grid.x_min + 1 - grid.tickness;
+	double estimated_rune_width = (binary_word_image.rows - 2.0 * grid.tickness) * RUNE_DEFAULT_SIZE.aspectRatio();
+	if (span <= 0.0 || estimated_rune_width <= 0.0) {
+		return false;
+	}
+	grid.nb_runes = (std::max)(1, (int)std::round(span / estimated_rune_width));
+	grid.rune_width = span / grid.nb_runes;
+	grid.rune_height = grid.rune_width / RUNE_DEFAULT_SIZE.aspectRatio();
+	return true;
+}
 
-	for (int i = 0; i < nb_runes; i++) {
-		int x = i * rune_width;
-		// Extract the rune image
-		cv::Rect roi_rune(x, 0, rune_width, height);
-		cv::Mat rune_image = processed_result(roi_rune);
+bool Word::decode_grid(const cv::Mat& binary_word_image, const RuneGrid& grid)
+{
+	m_runes.clear();
+	std::vector<cv::Point2d> origins;
+	for (int i = 0; i < grid.nb_runes; i++) {
+		origins.push_back(grid.get_rune_origin(i));
+	}
+	cv::Size2i rune_size((int)std::round(grid.rune_width), (int)std::round(grid.rune_height));
+	if (!Rune::decode_cells(binary_word_image, origins, rune_size, grid.tickness, m_runes)) {
+		return false;
+	}
+	// runes not decoded stay in the word (displayed as ???)
+	return !m_runes.empty();
+}
 
-		// Decode the rune from the image
-		Rune rune;
-		bool rune_detected = rune.decode_image(rune_image);
+// Binary word image (white runes on black): one separator search gives the rune grid, then all the cells are decoded at once
+bool Word::decode_image(const cv::Mat& word_image, bool debug_mode)
+{
+	m_runes.clear();
+	if (word_image.empty()) {
+		return false;
+	}
+	cv::Mat binary_image;
+	cv::threshold(word_image, binary_image, 100, 255, cv::THRESH_BINARY);
 
-		// push back rune even if not decoded (will be display as ???)
-		m_runes.push_back(rune);
-		if(rune_detected) {
-			//m_runes.push_back(rune);
-		} else {
-			std::cerr << "Failed to decode rune from image at position: " << x << std::endl;
-			result = false; // If any rune fails to decode, set result to false
+	RuneGrid grid;
+	if (!find_rune_grid(binary_image, grid)) {
+		return false;
+	}
+	if (debug_mode) {
+		cv::Mat grid_image;
+		cv::cvtColor(binary_image, grid_image, cv::COLOR_GRAY2BGR);
+		for (int i = 0; i < grid.nb_runes; i++) {
+			cv::Point2d origin = grid.get_rune_origin(i);
+			cv::rectangle(grid_image, cv::Rect2d(origin.x, origin.y, grid.rune_width, grid.rune_height), cv::Scalar(0, 255, 0), 1);
 		}
+		cv::imshow("Rune grid", grid_image);
+		cv::waitKey(1000);
+		cv::destroyAllWindows();
 	}
-
-	return true;
-	//return result;
+	return decode_grid(binary_image, grid);
 }
\ No newline at end of file
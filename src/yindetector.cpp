@@ -0,0 +1,318 @@
+#include "yindetector.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <opencv2/core/utility.hpp>
+#include <opencv2/core/hal/intrin.hpp>
+
+static void difference_scalar(const float* samples, size_t integration_size, size_t max_lag, float* difference)
+{
+    difference[0] = 0;
+    for (size_t tau = 1; tau < max_lag; tau++) {
+        const float* shifted = samples + tau;
+        float sum = 0;
+        for (size_t i = 0; i < integration_size; i++) {
+            float delta = samples[i] - shifted[i];
+            sum += delta * delta;
+        }
+        difference[tau] = sum;
+    }
+}
+
+#if CV_SIMD
+// Four lags per pass: every vector of samples is loaded once for the four shifted differences
+static void difference_simd(const float* samples, size_t integration_size, size_t max_lag, float* difference)
+{
+    const size_t lanes = cv::VTraits<cv::v_float32>::vlanes();
+    difference[0] = 0;
+    size_t tau = 1;
+    for (; tau + 4 <= max_lag; tau += 4) {
+        cv::v_float32 sum0 = cv::vx_setzero_f32(), sum1 = cv::vx_setzero_f32(), sum2 = cv::vx_setzero_f32(), sum3 = cv::vx_setzero_f32();
+        size_t i = 0;
+        for (; i + lanes <= integration_size; i += lanes) {
+            cv::v_float32 x = cv::vx_load(samples + i);
+            cv::v_float32 delta0 = cv::v_sub(x, cv::vx_load(samples + i + tau));
+            cv::v_float32 delta1 = cv::v_sub(x, cv::vx_load(samples + i + tau + 1));
+            cv::v_float32 delta2 = cv::v_sub(x, cv::vx_load(samples + i + tau + 2));
+            cv::v_float32 delta3 = cv::v_sub(x, cv::vx_load(samples + i + tau + 3));
+            sum0 = cv::v_muladd(delta0, delta0, sum0);
+            sum1 = cv::v_muladd(delta1, delta1, sum1);
+            sum2 = cv::v_muladd(delta2, delta2, sum2);
+            sum3 = cv::v_muladd(delta3, delta3, sum3);
+        }
+        float sums[4] = { cv::v_reduce_sum(sum0), cv::v_reduce_sum(sum1), cv::v_reduce_sum(sum2), cv::v_reduce_sum(sum3) };
+        for (; i < integration_size; i++) {
+            for (size_t k = 0; k < 4; k++) {
+                float delta = samples[i] - samples[i + tau + k];
+                sums[k] += delta * delta;
+            }
+        }
+        std::copy(sums, sums + 4, difference + tau);
+    }
+    for (; tau < max_lag; tau++) {
+        cv::v_float32 sum_vector = cv::vx_setzero_f32();
+        size_t i = 0;
+        for (; i + lanes <= integration_size; i += lanes) {
+            cv::v_float32 delta = cv::v_sub(cv::vx_load(samples + i), cv::vx_load(samples + i + tau));
+            sum_vector = cv::v_muladd(delta, delta, sum_vector);
+        }
+        float sum = cv::v_reduce_sum(sum_vector);
+        for (; i < integration_size; i++) {
+            float delta = samples[i] - samples[i + tau];
+            sum += delta * delta;
+        }
+        difference[tau] = sum;
+    }
+}
+
+// d'(tau) = d(tau) * tau / running_sum(tau) for tau >= 1, 1 where the running sum is 0 (same operations as the scalar loop)
+static void normalize_simd(float* difference, const float* running_sums, size_t max_lag)
+{
+    const size_t lanes = cv::VTraits<cv::v_float32>::vlanes();
+    float first_lags[cv::VTraits<cv::v_float32>::max_nlanes];
+    for (size_t k = 0; k < lanes; k++) {
+        first_lags[k] = (float)(k + 1);
+    }
+    cv::v_float32 lags = cv::vx_load(first_lags);
+    const cv::v_float32 lag_step = cv::vx_setall_f32((float)lanes);
+    const cv::v_float32 zero = cv::vx_setzero_f32(), one = cv::vx_setall_f32(1.0f);
+    size_t tau = 1;
+    for (; tau + lanes <= max_lag; tau += lanes) {
+        cv::v_float32 sums = cv::vx_load(running_sums + tau);
+        cv::v_float32 normalized = cv::v_div(cv::v_mul(cv::vx_load(difference + tau), lags), sums);
+        cv::v_store(difference + tau, cv::v_select(cv::v_gt(sums, zero), normalized, one));
+        lags = cv::v_add(lags, lag_step);
+    }
+    for (; tau < max_lag; tau++) {
+        difference[tau] = running_sums[tau] > 0 ? difference[tau] * tau / running_sums[tau] : 1;
+    }
+}
+#endif
+
+static void widen_samples(const int16_t* samples, size_t count, float* output, bool use_simd)
+{
+    const float scale = 1.0f / 32768.0f;
+    size_t i = 0;
+#if CV_SIMD
+    if (use_simd) {
+        const size_t lanes = cv::VTraits<cv::v_int16>::vlanes();
+        const cv::v_float32 scale_vector = cv::vx_setall_f32(scale);
+        for (; i + lanes <= count; i += lanes) {
+            cv::v_int32 low, high;
+            cv::v_expand(cv::vx_load(samples + i), low, high);
+            cv::v_store(output + i, cv::v_mul(cv::v_cvt_f32(low), scale_vector));
+            cv::v_store(output + i + lanes / 2, cv::v_mul(cv::v_cvt_f32(high), scale_vector));
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        output[i] = samples[i] * scale;
+    }
+}
+
+bool YinDetector::init(uint32_t sample_rate, size_t window_size, float threshold, double min_frequency, double max_frequency, YinMethod method)
+{
+    m_window_size = 0;
+    if (sample_rate == 0 || min_frequency <= 0 || max_frequency <= min_frequency) {
+        std::cerr << "Error: Invalid YIN sample rate or frequency range." << std::endl;
+        return false;
+    }
+    m_max_lag = (std::min)(window_size / 2, static_cast<size_t>(std::ceil(sample_rate / min_frequency)));
+    m_min_lag = (std::max)(static_cast<size_t>(2), static_cast<size_t>(sample_rate / max_frequency));
+    if (m_min_lag + 1 >= m_max_lag) {
+        std::cerr << "Error: YIN window of " << window_size << " samples is too short for the frequency range." << std::endl;
+        return false;
+    }
+    m_sample_rate = sample_rate;
+    m_integration_size = window_size - m_max_lag;
+    m_threshold = threshold;
+    m_probability = 0;
+    m_difference.assign(m_max_lag, 0.0f);
+    m_running_sums.assign(m_max_lag, 0.0f);
+    m_samples.assign(window_size, 0.0f);
+    m_use_simd = CV_SIMD && cv::useOptimized();
+    m_method = method;
+    if (m_method == YinMethod::Auto) {
+        m_method = m_use_simd && m_integration_size * m_max_lag <= YIN_AUTO_MAX_DIRECT_WORK ? YinMethod::DirectSimd : YinMethod::Fft;
+    }
+    if (m_method == YinMethod::Fft || m_method == YinMethod::Measured) {
+        // circular correlation of the first integration_size samples with the window: lags below max_lag never wrap
+        size_t fft_size = FftPlan<double>::next_power_of_two(window_size);
+        if (!m_fft_plan.init(fft_size)) {
+            return false;
+        }
+        m_fft_buffer.assign(fft_size, 0.0);
+        m_head_spectrum.assign(fft_size / 2 + 1, FftPlan<double>::Complex());
+        m_window_spectrum.assign(fft_size / 2 + 1, FftPlan<double>::Complex());
+        m_energy.assign(window_size + 1, 0.0);
+    }
+    m_window_size = window_size;
+    if (m_method == YinMethod::Measured) {
+        m_method = measure_fastest_method();
+    }
+    return true;
+}
+
+// Best of three timings of each method on a noise window (the crossover depends on the CPU, the window and the lags)
+YinMethod YinDetector::measure_fastest_method()
+{
+    std::vector<float> noise(m_window_size);
+    std::minstd_rand generator(1);
+    std::uniform_real_distribution<float> distribution(-0.5f, 0.5f);
+    for (auto& sample : noise) {
+        sample = distribution(generator);
+    }
+    double best_ms[2] = { 1e30, 1e30 };
+    const YinMethod candidates[2] = { YinMethod::DirectSimd, YinMethod::Fft };
+    for (int run = 0; run < 3; run++) {
+        for (int c = 0; c < 2; c++) {
+            m_method = candidates[c];
+            auto start = std::chrono::high_resolution_clock::now();
+            get_pitch(noise.data());
+            auto end = std::chrono::high_resolution_clock::now();
+            best_ms[c] = (std::min)(best_ms[c], std::chrono::duration<double, std::milli>(end - start).count());
+        }
+    }
+    m_probability = 0;
+    return best_ms[0] <= best_ms[1] ? YinMethod::DirectSimd : YinMethod::Fft;
+}
+
+// Step 1: squared difference of the signal with a shifted version of itself, for every lag
+void YinDetector::difference(const float* samples)
+{
+#if CV_SIMD
+    if (m_method == YinMethod::DirectSimd && m_use_simd) {
+        difference_simd(samples, m_integration_size, m_max_lag, m_difference.data());
+        return;
+    }
+#endif
+    difference_scalar(samples, m_integration_size, m_max_lag, m_difference.data());
+}
+
+// Step 1 through the autocorrelation r: d(tau) = e(0) + e(tau) - 2 r(tau), e(tau) being the energy of the
+// integration_size samples from tau (prefix sums of the squares)
+void YinDetector::difference_fft(const float* samples)
+{
+    for (size_t i = 0; i < m_window_size; i++) {
+        m_energy[i + 1] = m_energy[i] + (double)samples[i] * samples[i];
+    }
+
+    std::copy(samples, samples + m_window_size, m_fft_buffer.begin());
+    std::fill(m_fft_buffer.begin() + m_window_size, m_fft_buffer.end(), 0.0);
+    m_fft_plan.forward_real(m_fft_buffer.data(), m_window_spectrum.data());
+    std::fill(m_fft_buffer.begin() + m_integration_size, m_fft_buffer.end(), 0.0);
+    m_fft_plan.forward_real(m_fft_buffer.data(), m_head_spectrum.data());
+    for (size_t k = 0; k < m_window_spectrum.size(); k++) {
+        m_window_spectrum[k] *= std::conj(m_head_spectrum[k]);
+    }
+    m_fft_plan.inverse_real(m_window_spectrum.data(), m_fft_buffer.data());
+
+    double head_energy = m_energy[m_integration_size];
+    m_difference[0] = 0;
+    for (size_t tau = 1; tau < m_max_lag; tau++) {
+        double shifted_energy = m_energy[tau + m_integration_size] - m_energy[tau];
+        // rounding can leave a tiny negative value for a (nearly) perfect period
+        m_difference[tau] = (float)(std::max)(0.0, head_energy + shifted_energy - 2 * m_fft_buffer[tau]);
+    }
+}
+
+// Step 2: cumulative mean normalized difference, d'(0) = 1
+void YinDetector::cumulative_mean_normalized_difference()
+{
+    float running_sum = 0;
+    m_difference[0] = 1;
+#if CV_SIMD
+    if (m_method == YinMethod::DirectSimd && m_use_simd) {
+        // sequential running sums, then the normalization over whole vectors
+        for (size_t tau = 1; tau < m_max_lag; tau++) {
+            running_sum += m_difference[tau];
+            m_running_sums[tau] = running_sum;
+        }
+        normalize_simd(m_difference.data(), m_running_sums.data(), m_max_lag);
+        return;
+    }
+#endif
+    for (size_t tau = 1; tau < m_max_lag; tau++) {
+        running_sum += m_difference[tau];
+        m_difference[tau] = running_sum > 0 ? m_difference[tau] * tau / running_sum : 1;
+    }
+}
+
+// Step 3: first lag under the threshold, followed down to its local minimum. -1 if none
+int YinDetector::absolute_threshold()
+{
+    for (size_t tau = m_min_lag; tau < m_max_lag; tau++) {
+        if (m_difference[tau] < m_threshold) {
+            while (tau + 1 < m_max_lag && m_difference[tau + 1] < m_difference[tau]) {
+                tau++;
+            }
+            // periodicity = 1 - aperiodicity
+            m_probability = 1 - m_difference[tau];
+            return static_cast<int>(tau);
+        }
+        // short periods (high pitch, low sample rate) dip between two lags: threshold the minimum of the parabola
+        if (m_parabolic_threshold && tau + 1 < m_max_lag && m_difference[tau] <= m_difference[tau - 1] && m_difference[tau] <= m_difference[tau + 1]) {
+            float s0 = m_difference[tau - 1];
+            float s1 = m_difference[tau];
+            float s2 = m_difference[tau + 1];
+            float curvature = s0 - 2 * s1 + s2;
+            float minimum = curvature > 0 ? s1 - (s2 - s0) * (s2 - s0) / (8 * curvature) : s1;
+            if (minimum < m_threshold) {
+                m_probability = 1 - minimum;
+                return static_cast<int>(tau);
+            }
+        }
+    }
+    m_probability = 0;
+    return -1;
+}
+
+// Step 5: fractional lag from the parabola through the estimate and its neighbours
+float YinDetector::parabolic_interpolation(int tau_estimate) const
+{
+    int x0 = tau_estimate < 1 ? tau_estimate : tau_estimate - 1;
+    int x2 = tau_estimate + 1 < (int)m_max_lag ? tau_estimate + 1 : tau_estimate;
+    if (x0 == tau_estimate) {
+        return m_difference[tau_estimate] <= m_difference[x2] ? (float)tau_estimate : (float)x2;
+    }
+    if (x2 == tau_estimate) {
+        return m_difference[tau_estimate] <= m_difference[x0] ? (float)tau_estimate : (float)x0;
+    }
+    float s0 = m_difference[x0];
+    float s1 = m_difference[tau_estimate];
+    float s2 = m_difference[x2];
+    float denominator = 2 * (2 * s1 - s2 - s0);
+    return denominator != 0 ? tau_estimate + (s2 - s0) / denominator : (float)tau_estimate;
+}
+
+float YinDetector::get_pitch(const float* samples)
+{
+    if (!is_valid()) {
+        return -1;
+    }
+    if (m_method == YinMethod::Fft) {
+        difference_fft(samples);
+    }
+    else {
+        difference(samples);
+    }
+    cumulative_mean_normalized_difference();
+    int tau_estimate = absolute_threshold();
+    if (tau_estimate == -1) {
+        return -1;
+    }
+    return m_sample_rate / parabolic_interpolation(tau_estimate);
+}
+
+float YinDetector::get_pitch(const int16_t* samples)
+{
+    if (!is_valid()) {
+        return -1;
+    }
+    // Direct stays the scalar reference
+    widen_samples(samples, m_window_size, m_samples.data(), m_method != YinMethod::Direct && m_use_simd);
+    return get_pitch(m_samples.data());
+}